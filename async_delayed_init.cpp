@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::async_delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "async_delayed_init.h"
+
+using overload::async_delayed_init;
+
+//------------------------------------------------------------------------------
+// Allocation counter.
+//------------------------------------------------------------------------------
+
+// Counts every allocation, including any the header might make behind the
+// awaiter's back. The replacements are kept out of line: once inlined, GCC
+// pairs the malloc() in operator new with the operator delete at the call
+// site and reports them as mismatched.
+#if defined(__GNUC__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
+std::atomic<std::size_t> n_allocations(0);
+
+NOINLINE void* operator new(std::size_t size) {
+  ++n_allocations;
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+NOINLINE void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+NOINLINE void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+#undef NOINLINE
+
+//------------------------------------------------------------------------------
+// task
+//------------------------------------------------------------------------------
+
+// Eager coroutine which destroys itself on completion.
+struct task {
+  struct promise_type {
+    task get_return_object() noexcept {
+      return task();
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() noexcept {
+    }
+    void unhandled_exception() noexcept {
+      std::terminate();
+    }
+  };
+};
+
+// Appends the value of d to values.
+task reader(async_delayed_init<int>& d, std::vector<int>& values, int id) {
+  const int& value = co_await d;
+  values.push_back(id);
+  values.push_back(value);
+}
+
+// Increments count by the value of d.
+task counter(const async_delayed_init<int>& d, std::atomic<int>& count) {
+  count += co_await d;
+}
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_ready()
+//------------------------------------------------------------------------------
+
+task write_when_ready(async_delayed_init<int>& d, bool& done, std::size_t& n) {
+  const std::size_t before = n_allocations;
+  int& value = co_await d;
+  n = n_allocations - before;
+  value = 2;
+  done = true;
+}
+
+void test_ready(int line) {
+  where(line, __func__);
+  async_delayed_init<int> d;
+  assert(!d && d.get() == nullptr);
+  assert(d.init(1) == 1);
+  assert(d && *d == 1);
+  bool done = false;
+  std::size_t n = 1;
+  write_when_ready(d, done, n);
+  // Completion before write_when_ready() returns means it didn't suspend.
+  assert(done);
+  assert(n == 0);
+  assert(*d == 2);
+}
+
+//------------------------------------------------------------------------------
+// test_waiters()
+//------------------------------------------------------------------------------
+
+void test_waiters(int line) {
+  where(line, __func__);
+  async_delayed_init<int> d;
+  std::vector<int> values;
+  values.reserve(6);
+  reader(d, values, 0);
+  reader(d, values, 1);
+  reader(d, values, 2);
+  assert(values.empty());
+  assert(!d);
+  const std::size_t before = n_allocations;
+  d.init(42);
+  assert(n_allocations == before);
+  assert((values == std::vector<int>{0, 42, 1, 42, 2, 42}));
+  reader(d, values, 3);
+  assert(values.size() == 8 && values[6] == 3 && values[7] == 42);
+}
+
+//------------------------------------------------------------------------------
+// test_const()
+//------------------------------------------------------------------------------
+
+static_assert(std::is_same<decltype(std::declval<async_delayed_init<int>&>().
+  operator co_await().await_resume()), int&>::value,
+  "co_await async_delayed_init<int>& doesn't yield int&");
+static_assert(std::is_same<decltype(std::declval<
+  const async_delayed_init<int>&>().operator co_await().await_resume()),
+  const int&>::value,
+  "co_await const async_delayed_init<int>& doesn't yield const int&");
+
+void test_const(int line) {
+  where(line, __func__);
+  async_delayed_init<int> d;
+  std::atomic<int> count(0);
+  counter(d, count);
+  counter(d, count);
+  assert(count == 0);
+  d.init_with([] { return 5; });
+  assert(count == 10);
+}
+
+//------------------------------------------------------------------------------
+// test_throwing_init()
+//------------------------------------------------------------------------------
+
+void test_throwing_init(int line) {
+  where(line, __func__);
+  async_delayed_init<int> d;
+  std::vector<int> values;
+  values.reserve(2);
+  reader(d, values, 0);
+  try {
+    d.init_with([]() -> int { throw std::runtime_error("failed"); });
+    assert(false);
+  }
+  catch (std::runtime_error&) {
+  }
+  assert(!d);
+  assert(values.empty());
+  d.init(3);
+  assert((values == std::vector<int>{0, 3}));
+  try {
+    d.init(4);
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  assert(*d == 3);
+}
+
+//------------------------------------------------------------------------------
+// test_threads()
+//------------------------------------------------------------------------------
+
+void test_threads(int line) {
+  where(line, __func__);
+  constexpr int n_threads = 4;
+  constexpr int n_tasks = 1000;
+  for (int round = 0; round < 10; ++round) {
+    async_delayed_init<int> d;
+    std::atomic<int> count(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; ++i)
+      threads.emplace_back([&] {
+        while (!go)
+          std::this_thread::yield();
+        for (int j = 0; j < n_tasks; ++j)
+          counter(d, count);
+      });
+    go = true;
+    std::this_thread::yield();
+    d.init(1);
+    for (auto& thread : threads)
+      thread.join();
+    assert(count == n_threads * n_tasks);
+  }
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_ready(__LINE__);
+  test_waiters(__LINE__);
+  test_const(__LINE__);
+  test_throwing_init(__LINE__);
+  test_threads(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
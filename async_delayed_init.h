@@ -0,0 +1,353 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file async_delayed_init.h
+  * @brief Definition of class async_delayed_init (requires C++20).
+  */
+
+#ifndef OVERLOAD_ASYNC_DELAYED_INIT_H_
+#define OVERLOAD_ASYNC_DELAYED_INIT_H_
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+
+/**
+ * @brief delayed_init<T> whose initialisation can be awaited by coroutines.
+ *
+ * The expression co_await d suspends the awaiting coroutine until d.init() (or
+ * d.init_with()) completes and then yields a reference to the object. If the
+ * object is already initialised, then the coroutine doesn't suspend at all.
+ *
+ * Waiters are kept in an intrusive list of awaiters that live in the frames of
+ * the suspended coroutines and, hence, awaiting allocates nothing. The head
+ * of the list and the initialisation state share a single atomic pointer.
+ * Once the object is built, init() resumes all waiters in batch, in the order
+ * they suspended, on its calling thread. (Hence, resumed coroutines must not
+ * let exceptions escape to the caller of resume().)
+ *
+ * Awaits and accessors might happen concurrently with each other and with
+ * init() from any thread. Calls to init() and init_with() must not race with
+ * each other. The destructor is not thread-safe and must not run while
+ * coroutines are suspended on this object. Objects of this class are neither
+ * copyable nor movable (suspended awaiters point to them).
+ *
+ * The type T must not be a reference type.
+ */
+template <typename T, typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class async_delayed_init {
+
+  template <typename U>
+  class awaiter;
+
+public:
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "async_delayed_init for reference type");
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  constexpr async_delayed_init() noexcept : state_(nullptr), raw_() {
+  }
+
+  async_delayed_init(const async_delayed_init&) = delete;
+
+  async_delayed_init& operator=(const async_delayed_init&) = delete;
+
+  /**
+   * @brief Destructor.
+   *
+   * T:~T() must not throw.
+   *
+   * @pre No coroutine is suspended on *this.
+   * @throw - Nothing.
+   */
+  ~async_delayed_init() noexcept {
+    void* const state = state_.load(std::memory_order_relaxed);
+    assert((state == nullptr || state == ready()) && "destruction of "
+      "async_delayed_init with suspended waiters");
+    if (state == ready())
+      (&raw_.obj_)->~T();
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  T& operator*() noexcept(Check::is_nothrow) {
+    if (!is_ready())
+      Check::fail("attempt to use uninitialised object");
+    return raw_.obj_;
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  const T& operator*() const noexcept(Check::is_nothrow) {
+    if (!is_ready())
+      Check::fail("attempt to use uninitialised object");
+    return raw_.obj_;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  T* get() noexcept {
+    return is_ready() ? &raw_.obj_ : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  const T* get() const noexcept {
+    return is_ready() ? &raw_.obj_ : nullptr;
+  }
+
+  /**
+   * @brief Deference.
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  T* operator->() noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Deference (const).
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  const T* operator->() const noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the inner object is not (completely) initialised.
+   * Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return is_ready();
+  }
+
+  /**
+   * @brief Awaits initialisation.
+   *
+   * @return An awaitable which suspends the caller unless
+   * static_cast<bool>(*this) == true and yields **this on resumption.
+   * @throw - Nothing.
+   */
+  awaiter<T> operator co_await() noexcept {
+    return awaiter<T>(*this);
+  }
+
+  /**
+   * @brief Awaits initialisation (const).
+   *
+   * @return An awaitable which suspends the caller unless
+   * static_cast<bool>(*this) == true and yields **this on resumption.
+   * @throw - Nothing.
+   */
+  awaiter<const T> operator co_await() const noexcept {
+    return awaiter<const T>(const_cast<async_delayed_init&>(*this));
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds inner object by forwarding arguments to T's constructor and then
+   * resumes all coroutines awaiting it. If T's constructor throws, then waiters
+   * remain suspended.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return **this.
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  T& init(Args&&... args) {
+    if (is_ready())
+      Check::fail("second attempt to initialise object");
+    new ((void *) &raw_.obj_) T(std::forward<Args>(args)...);
+    publish();
+    return raw_.obj_;
+  }
+
+  /**
+   * @brief Initialiser from factory.
+   *
+   * Builds inner object from f() and then resumes all coroutines awaiting it.
+   * If f() or T's constructor throws, then waiters remain suspended.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param f Factory.
+   * @return **this.
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   * @throw - Whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  T& init_with(F&& f) {
+    if (is_ready())
+      Check::fail("second attempt to initialise object");
+    new ((void *) &raw_.obj_) T(std::forward<F>(f)());
+    publish();
+    return raw_.obj_;
+  }
+
+private:
+
+  /**
+   * @brief Node of the list of waiters.
+   */
+  struct waiter {
+    waiter*                 next;
+    std::coroutine_handle<> handle;
+  };
+
+  /**
+   * @brief Awaitable returned by operator co_await().
+   *
+   * While its coroutine is suspended, it is a node of the list of waiters.
+   *
+   * @tparam U T or const T.
+   */
+  template <typename U>
+  class awaiter : private waiter {
+
+    friend class async_delayed_init;
+
+    async_delayed_init& d_;
+
+    explicit awaiter(async_delayed_init& d) noexcept : waiter(), d_(d) {
+    }
+
+  public:
+
+    bool await_ready() const noexcept {
+      return d_.is_ready();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+      this->handle = handle;
+      void* state = d_.state_.load(std::memory_order_acquire);
+      do {
+        if (state == d_.ready())
+          return false;
+        this->next = static_cast<waiter*>(state);
+      } while (!d_.state_.compare_exchange_weak(state,
+        static_cast<waiter*>(this), std::memory_order_release,
+        std::memory_order_acquire));
+      return true;
+    }
+
+    U& await_resume() const noexcept {
+      return d_.raw_.obj_;
+    }
+  };
+
+  // nullptr (no waiters), ready() or the last waiter to suspend.
+  std::atomic<void*>     state_;
+  detail::raw_storage<T> raw_;
+
+  // The state of initialised objects (an address which is not an awaiter's).
+  void* ready() const noexcept {
+    return const_cast<async_delayed_init*>(this);
+  }
+
+  bool is_ready() const noexcept {
+    return state_.load(std::memory_order_acquire) == ready();
+  }
+
+  /**
+   * @brief Marks the object as initialised and resumes waiters.
+   *
+   * Waiters are pushed at the head of the list and are resumed from the tail
+   * to preserve order.
+   */
+  void publish() noexcept {
+    waiter* head = static_cast<waiter*>(state_.exchange(ready(),
+      std::memory_order_acq_rel));
+    waiter* fifo = nullptr;
+    while (head) {
+      waiter* const next = head->next;
+      head->next = fifo;
+      fifo = head;
+      head = next;
+    }
+    while (fifo) {
+      // Resumption might destroy the waiter.
+      waiter* const next = fifo->next;
+      fifo->handle.resume();
+      fifo = next;
+    }
+  }
+
+}; // class async_delayed_init
+
+} // namespace overload
+
+#endif // OVERLOAD_ASYNC_DELAYED_INIT_H_
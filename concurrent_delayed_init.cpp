@@ -0,0 +1,212 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::concurrent_delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "concurrent_delayed_init.h"
+
+// Helper class counting the number of constructions.
+class counted {
+
+  int i_;
+
+public:
+
+  static std::atomic<int> constructions;
+
+  explicit counted(int i) : i_(i) {
+    constructions.fetch_add(1);
+    if (i < 0)
+      throw std::runtime_error("negative");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  int get() const noexcept {
+    return i_;
+  }
+
+}; // class counted
+
+std::atomic<int> counted::constructions(0);
+using overload::concurrent_delayed_init;
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// run()
+//------------------------------------------------------------------------------
+
+template <typename F>
+void run(unsigned n_threads, F f) {
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < n_threads; ++i)
+    threads.emplace_back(f, i);
+  for (auto& t : threads)
+    t.join();
+}
+
+//------------------------------------------------------------------------------
+// test_default_constructor()
+//------------------------------------------------------------------------------
+
+void test_default_constructor(int line) {
+  where(line, __func__);
+  const concurrent_delayed_init<counted> d;
+  assert(!d);
+  assert(d.get() == nullptr);
+  try {
+    (*d).get();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_init()
+//------------------------------------------------------------------------------
+
+void test_init(int line) {
+  where(line, __func__);
+  counted::constructions = 0;
+  concurrent_delayed_init<counted> d;
+  std::atomic<int> winners(0);
+  run(8, [&](unsigned i) {
+    if (d.init(static_cast<int>(i)))
+      winners.fetch_add(1);
+    assert(d);
+    assert(d->get() >= 0 && d->get() < 8);
+  });
+  assert(winners == 1);
+  assert(counted::constructions == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_init_once()
+//------------------------------------------------------------------------------
+
+void test_init_once(int line) {
+  where(line, __func__);
+  counted::constructions = 0;
+  concurrent_delayed_init<counted> d;
+  std::atomic<int> sum(0);
+  run(8, [&](unsigned) {
+    sum.fetch_add(d.init_once([]{ return counted(7); }).get());
+  });
+  assert(sum == 8 * 7);
+  assert(counted::constructions == 1);
+  assert((*d).get() == 7);
+}
+
+//------------------------------------------------------------------------------
+// test_init_once_throw()
+//------------------------------------------------------------------------------
+
+void test_init_once_throw(int line) {
+  where(line, __func__);
+  counted::constructions = 0;
+  concurrent_delayed_init<counted> d;
+  std::atomic<int> failures(0);
+  run(8, [&](unsigned i) {
+    try {
+      d.init_once([i]{ return counted(i == 0 ? -1 : 1); });
+    }
+    catch (std::runtime_error&) {
+      failures.fetch_add(1);
+    }
+  });
+  assert(failures <= 1);
+  assert(counted::constructions == 1 + failures);
+  assert(d->get() == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_waiters_block()
+//------------------------------------------------------------------------------
+
+void test_waiters_block(int line) {
+
+  where(line, __func__);
+  const auto duration = std::chrono::milliseconds(300);
+  concurrent_delayed_init<int> d;
+  std::atomic<int> n_calls(0);
+
+  const std::clock_t start = std::clock();
+  run(4, [&](unsigned) {
+    d.init_once([&] {
+      std::this_thread::sleep_for(duration);
+      return ++n_calls;
+    });
+  });
+  const double cpu = double(std::clock() - start) / CLOCKS_PER_SEC;
+
+  assert(n_calls == 1);
+  assert(*d == 1);
+  // Waiters that spin or yield burn (at least) one core while the winner
+  // sleeps. Blocked waiters don't.
+  assert(cpu < 0.25 * std::chrono::duration<double>(duration).count());
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_default_constructor(__LINE__);
+  test_init(__LINE__);
+  test_init_once(__LINE__);
+  test_init_once_throw(__LINE__);
+  test_waiters_block(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
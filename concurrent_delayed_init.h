@@ -0,0 +1,419 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+
+ /**
+  * @file concurrent_delayed_init.h
+  * @brief Definition of class concurrent_delayed_init.
+  */
+
+#ifndef OVERLOAD_CONCURRENT_DELAYED_INIT_H_
+#define OVERLOAD_CONCURRENT_DELAYED_INIT_H_
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if !defined(__cpp_lib_atomic_wait)
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+#endif
+
+#include "delayed_init.h"
+
+/**
+ * @brief Hints the processor that the caller is spinning.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define OVERLOAD_DELAYED_INIT_PAUSE() __builtin_ia32_pause()
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define OVERLOAD_DELAYED_INIT_PAUSE() __asm__ __volatile__("yield")
+#else
+#define OVERLOAD_DELAYED_INIT_PAUSE() static_cast<void>(0)
+#endif
+
+namespace overload {
+
+#if !defined(__cpp_lib_atomic_wait) && !defined(__linux__)
+
+namespace detail {
+
+/**
+ * @brief Mutex and condition variable where waiters of
+ * concurrent_delayed_init block (when std::atomic::wait and futexes are not
+ * available).
+ *
+ * They are shared by all objects and only used on the contended path.
+ */
+template <typename = void>
+struct parking_lot {
+  static std::mutex              mutex;
+  static std::condition_variable cv;
+};
+
+template <typename V>
+std::mutex parking_lot<V>::mutex;
+
+template <typename V>
+std::condition_variable parking_lot<V>::cv;
+
+} // namespace detail
+
+#endif
+
+/**
+ * @brief Thread-safe delayed_init<T>.
+ *
+ * Class concurrent_delayed_init<T> holds an object of type T whose
+ * initialisation is delayed until init() or init_once() is called. These
+ * functions might be called concurrently by different threads and only one of
+ * them constructs the object. Others wait until construction finishes. They
+ * spin for a short while and then block: on std::atomic::wait if available
+ * (C++20), on a futex on Linux or on a condition variable otherwise.
+ *
+ * Once the object is initialised, get(), operator*() and operator bool() are a
+ * single acquire load and can be called concurrently. Non-const access to the
+ * object after initialisation is not synchronised by this class.
+ *
+ * The destructor and swap() are not thread-safe. Objects of this class are
+ * neither copyable nor movable.
+ *
+ * The type T must not be a reference type.
+ */
+template <typename T, typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class concurrent_delayed_init {
+
+public:
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "concurrent_delayed_init for reference type");
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  constexpr concurrent_delayed_init() noexcept : state_(uninit), raw_() {
+  }
+
+  concurrent_delayed_init(const concurrent_delayed_init&) = delete;
+
+  concurrent_delayed_init& operator=(const concurrent_delayed_init&) = delete;
+
+  /**
+   * @brief Destructor.
+   *
+   * T:~T() must not throw.
+   *
+   * @throw - Nothing.
+   */
+  ~concurrent_delayed_init() noexcept {
+    if (state_.load(std::memory_order_relaxed) == ready)
+      (&raw_.obj_)->~T();
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  T& operator*() noexcept(Check::is_nothrow) {
+    if (!is_ready())
+      Check::fail("attempt to use uninitialised object");
+    return raw_.obj_;
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  const T& operator*() const noexcept(Check::is_nothrow) {
+    if (!is_ready())
+      Check::fail("attempt to use uninitialised object");
+    return raw_.obj_;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  T* get() noexcept {
+    return is_ready() ? &raw_.obj_ : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  const T* get() const noexcept {
+    return is_ready() ? &raw_.obj_ : nullptr;
+  }
+
+  /**
+   * @brief Deference.
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  T* operator->() noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Deference (const).
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  const T* operator->() const noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the inner object is not (completely) initialised.
+   * Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return is_ready();
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds inner object by forwarding arguments to T's constructor unless it
+   * has already been built. If another thread is building it, then waits until
+   * construction finishes and, if it fails, tries again.
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return true if this call has built the object. Otherwise, false.
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  bool init(Args&&... args) {
+    if (!acquire())
+      return false;
+    releaser r(state_);
+    new ((void *) &raw_.obj_) T(std::forward<Args>(args)...);
+    r.commit();
+    return true;
+  }
+
+  /**
+   * @brief Initialiser from factory.
+   *
+   * Builds inner object from f() unless it has already been built. If another
+   * thread is building it, then waits until construction finishes and, if it
+   * fails, tries again.
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param f Factory.
+   * @return *get().
+   * @throw - Whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  T& init_once(F&& f) {
+    if (!is_ready() && acquire()) {
+      releaser r(state_);
+      new ((void *) &raw_.obj_) T(std::forward<F>(f)());
+      r.commit();
+    }
+    return raw_.obj_;
+  }
+
+private:
+
+  enum : int {
+    uninit,             // not initialised.
+    busy,               // being initialised.
+    busy_with_waiters,  // being initialised with threads waiting.
+    ready               // initialised.
+  };
+
+  /**
+   * @brief Releases the state acquired by acquire() and wakes up waiters.
+   *
+   * If commit() is not called (e.g. an exception is thrown by T's
+   * constructor), then the state goes back to uninit.
+   */
+  class releaser {
+
+    std::atomic<int>& state_;
+    int               next_;
+
+  public:
+
+    explicit releaser(std::atomic<int>& state) noexcept : state_(state),
+      next_(uninit) {
+    }
+
+    void commit() noexcept {
+      next_ = ready;
+    }
+
+    ~releaser() noexcept {
+      if (state_.exchange(next_, std::memory_order_acq_rel) ==
+        busy_with_waiters)
+        concurrent_delayed_init::wake(state_);
+    }
+  };
+
+  std::atomic<int> state_;
+  detail::raw_storage<T> raw_;
+
+  bool is_ready() const noexcept {
+    return state_.load(std::memory_order_acquire) == ready;
+  }
+
+  /**
+   * @brief Acquires the right to build the object.
+   *
+   * @return true if the caller must build the object and false if it's
+   * already built.
+   */
+  bool acquire() noexcept {
+    int state = state_.load(std::memory_order_acquire);
+    for (unsigned spins = 0; ; ) {
+      if (state == ready)
+        return false;
+      if (state == uninit) {
+        if (state_.compare_exchange_weak(state, busy,
+          std::memory_order_acquire, std::memory_order_acquire))
+          return true;
+        continue;
+      }
+      if (spins < 64) {
+        ++spins;
+        OVERLOAD_DELAYED_INIT_PAUSE();
+        state = state_.load(std::memory_order_acquire);
+        continue;
+      }
+      if (state == busy && !state_.compare_exchange_weak(state,
+        busy_with_waiters, std::memory_order_acquire,
+        std::memory_order_acquire))
+        continue;
+      wait(state_, busy_with_waiters);
+      state = state_.load(std::memory_order_acquire);
+    }
+  }
+
+#if defined(__cpp_lib_atomic_wait)
+
+  static void wait(std::atomic<int>& state, int old) noexcept {
+    state.wait(old, std::memory_order_acquire);
+  }
+
+  static void wake(std::atomic<int>& state) noexcept {
+    state.notify_all();
+  }
+
+#elif defined(__linux__)
+
+  static_assert(sizeof(std::atomic<int>) == sizeof(int), "std::atomic<int> "
+    "cannot be used as a futex");
+
+  static int* futex(std::atomic<int>& state) noexcept {
+    return reinterpret_cast<int*>(&state);
+  }
+
+  static void wait(std::atomic<int>& state, int old) noexcept {
+    // The kernel returns immediately if the state is no longer old.
+    while (state.load(std::memory_order_acquire) == old)
+      syscall(SYS_futex, futex(state), FUTEX_WAIT_PRIVATE, old, nullptr,
+        nullptr, 0);
+  }
+
+  static void wake(std::atomic<int>& state) noexcept {
+    syscall(SYS_futex, futex(state), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+      nullptr, 0);
+  }
+
+#else
+
+  // If the mutex cannot be locked, waiters fall back to yielding and wake()
+  // notifies without locking. The timeout bounds how long a waiter might
+  // sleep after a notification lost in this case.
+  static void wait(std::atomic<int>& state, int old) noexcept {
+    typedef detail::parking_lot<> lot;
+    try {
+      std::unique_lock<std::mutex> lock(lot::mutex);
+      while (state.load(std::memory_order_acquire) == old)
+        lot::cv.wait_for(lock, std::chrono::milliseconds(10));
+    }
+    catch (...) {
+      while (state.load(std::memory_order_acquire) == old)
+        std::this_thread::yield();
+    }
+  }
+
+  static void wake(std::atomic<int>&) noexcept {
+    typedef detail::parking_lot<> lot;
+    try {
+      // Waiters test the state while holding the mutex. Hence, once it's
+      // acquired here, they either have seen the new state or are waiting.
+      std::lock_guard<std::mutex> lock(lot::mutex);
+    }
+    catch (...) {
+    }
+    lot::cv.notify_all();
+  }
+
+#endif
+
+}; // class concurrent_delayed_init
+
+} // namespace overload
+
+#endif // OVERLOAD_CONCURRENT_DELAYED_INIT_H_
@@ -1,708 +1,2234 @@
-/*******************************************************************************
- * This is free and unencumbered software released into the public domain.
- *
- * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
- * this software, either in source code form or as a compiled binary, for any
- * purpose, commercial or non-commercial, and by any means.
- *
- * In jurisdictions that recognize copyright laws, the author or authors of this
- * software dedicate any and all copyright interest in the software to the
- * public domain. We make this dedication for the benefit of the public at large
- * and to the detriment of our heirs and successors. We intend this dedication
- * to be an overt act of relinquishment in perpetuity of all present and future
- * rights to this software under copyright law.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
- * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
- * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- * 
- * For more information, please refer to <http://unlicense.org/>
- *
- * If you use this software in a product, an acknowledgment in the product
- * documentation would be appreciated but is not required.
- *
- * by Cassio Neri
- ******************************************************************************/
-
- /**
-  * Unit tests of overload::delayed_init.
-  *
-  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
-  * poor. More advanced diagnostics can be obtained by using a good unit testing
-  * framework as CATCH:
-  * http://www.catch-lib.net/
-  */
-
-#include <cassert>
-#include <iostream>
-#include <stack>
-
-#include "delayed_init.h"
-
-// Helper class for testing delayed_init.
-class helper {
-
-  int i_;
-  
-public:
-
-  // List of helper's methods (used for instrumentation purposes).
-  enum method {
-    none, default_constructor, constructor, copy_constructor,
-    move_constructor, destructor, copy_assignment, move_assignment, equal,
-    const_get, non_const_get, swap_member, swap_non_member
-  };
-
-  // Call stack registering calls to helper's methods.
-  static std::stack<method> call_stack;
-  
-  // Mark call stack by pushing helper::none.
-  static void mark_call_stack() {
-    call_stack.push(none);
-  }
-
-  // Check top of call stack against expectation.
-  static void check_call_stack(std::initializer_list<method> methods) {
-    for (auto f : methods) {
-      assert(call_stack.top() == f);
-      call_stack.pop();
-    }
-    assert(call_stack.top() == none);
-    call_stack.pop();
-  }
-   
-  helper() noexcept : i_(0) {
-    call_stack.push(default_constructor);
-  }
-
-  explicit helper(int i) noexcept : i_(i) {
-    call_stack.push(constructor);
-  }
-
-  helper(const helper& other) noexcept : i_(other.i_) {
-    call_stack.push(copy_constructor);
-  }
-  
-  helper(helper&& other) noexcept : i_(other.i_) {
-    call_stack.push(move_constructor);
-  }
-  
-  ~helper() noexcept {
-    call_stack.push(destructor);
-  }
-  
-  helper& operator=(const helper& other) noexcept {
-    call_stack.push(copy_assignment);
-    i_ = other.i_;
-    return *this;
-  }
-  
-  helper& operator=(helper&& other) noexcept {
-    call_stack.push(move_assignment);
-    i_ = other.i_;
-    return *this;
-  }
-  
-  bool operator==(const helper& other) const noexcept {
-    call_stack.push(equal);
-    return i_ == other.i_;
-  }
-  
-  const int& get() const noexcept {
-    call_stack.push(const_get);
-    return i_;
-  }
-  
-  int& get() noexcept {
-    call_stack.push(non_const_get);
-    return i_;
-  }
-  
-  void swap(helper& other) noexcept {
-    call_stack.push(swap_member);
-    std::swap(i_, other.i_);
-  }
-  
-}; // class helper
-
-std::stack<helper::method> helper::call_stack;
-using overload::delayed_init;
-typedef std::initializer_list<helper::method> method_list;
-
-//------------------------------------------------------------------------------
-// swap()
-//------------------------------------------------------------------------------
-
-void swap(helper& h1, helper& h2) noexcept {
-  helper::call_stack.push(helper::swap_non_member);
-  h1.swap(h2);
-}
-
-//------------------------------------------------------------------------------
-// is_pointer_to_const()
-//------------------------------------------------------------------------------
-
-constexpr bool is_pointer_to_const(const helper*) {
-  return true;
-}
-
-constexpr bool is_pointer_to_const(helper*) {
-  return false;
-}
-
-//------------------------------------------------------------------------------
-// where()
-//------------------------------------------------------------------------------
-
-void where(int line, const char* func) {
-  std::cout << "line " << line << " : " << func << std::endl;
-}
-
-//------------------------------------------------------------------------------
-// test_default_constructor()
-//------------------------------------------------------------------------------
-
-void test_default_constructor(int line) {
-  where(line, __func__);
-  helper::mark_call_stack();
-  const delayed_init<const helper> d;
-  helper::check_call_stack({});
-  assert(!d);
-}
-
-//------------------------------------------------------------------------------
-// test_constructor()
-//------------------------------------------------------------------------------
-
-template <typename T, typename U>
-void test_constructor(int line, U&& src, bool is_init, method_list ml) {
-  where(line, __func__);
-  helper::mark_call_stack();
-  const delayed_init<T> d(std::forward<U>(src));
-  helper::check_call_stack(ml);
-  assert(static_cast<bool>(d) == is_init);
-}
-
-//------------------------------------------------------------------------------
-// test_destructor()
-//------------------------------------------------------------------------------
-
-template <typename U>
-void test_destructor(int line, const U& src, method_list ml) {
-  where(line, __func__);
-  {
-    const delayed_init<const helper> d(src);
-    helper::mark_call_stack();
-  }
-  helper::check_call_stack(ml);
-}
-
-//------------------------------------------------------------------------------
-// test_assignment()
-//------------------------------------------------------------------------------
-
-template <typename T, typename U>
-void test_assignment(int line, U&& from, const T& to, bool is_init,
-  method_list ml) {
-  
-  where(line, __func__);
-  delayed_init<helper> d(to);
-  helper::mark_call_stack();
-  d = std::forward<U>(from);
-  helper::check_call_stack(ml);
-  assert(static_cast<bool>(d) == is_init);
-}
-
-//------------------------------------------------------------------------------
-// test_indirection_uninitialised()
-//------------------------------------------------------------------------------
-
-template <typename D>
-void test_indirection_uninitialised(int line) {
-
-  where(line, __func__);
-  D d;
-  helper::mark_call_stack();
-  try {
-    (*d).get();
-    assert(false);
-  }
-  catch (std::logic_error&) {
-  }
-  catch (...) {
-    assert(false);
-  }
-  helper::check_call_stack({});
-}
-
-//------------------------------------------------------------------------------
-// test_indirection_initialised()
-//------------------------------------------------------------------------------
-
-template <typename D>
-void test_indirection_initialised(int line, method_list ml) {
-  where(line, __func__);
-  D d(helper(1));
-  helper::mark_call_stack();
-  (*d).get();
-  helper::check_call_stack(ml);
-}
-
-//------------------------------------------------------------------------------
-// test_getter()
-//------------------------------------------------------------------------------
-
-template <typename D>
-void test_getter(int line, const delayed_init<helper>& src, bool is_const,
-  bool is_init) {
-  
-  where(line, __func__);
-  D d(src);
-  const auto p = d.get();
-  assert(is_pointer_to_const(p) == is_const);
-  assert(static_cast<bool>(p) == is_init);
-}
-
-//------------------------------------------------------------------------------
-// test_dereference()
-//------------------------------------------------------------------------------
-
-template <typename D>
-void test_dereference(int line, method_list ml) {
-  where(line, __func__);
-  D d(helper(1));
-  helper::mark_call_stack();
-  d->get();
-  helper::check_call_stack(ml);
-}
-
-//------------------------------------------------------------------------------
-// test_conversion_to_bool()
-//------------------------------------------------------------------------------
-
-void test_conversion_to_bool(int line, const delayed_init<const helper>& d,
-  bool is_init) {
-  where(line, __func__);
-  helper::mark_call_stack();
-  assert(static_cast<bool>(d) == is_init);
-  helper::check_call_stack({});
-}
-
-//------------------------------------------------------------------------------
-// test_init_uninitialised()
-//------------------------------------------------------------------------------
-
-template <typename... Args>
-void test_init_uninitialised(int line, method_list ml, Args&&... args) {
-  where(line, __func__);
-  delayed_init<const helper> d;
-  helper::mark_call_stack();
-  d.init(std::forward<Args>(args)...);
-  helper::check_call_stack(ml);
-  assert(d);
-  assert(d.get());
-}
-
-//------------------------------------------------------------------------------
-// test_init_initialised()
-//------------------------------------------------------------------------------
-
-void test_init_initialised(int line) {
-  where(line, __func__);
-  delayed_init<const helper> d(helper(1));
-  helper::mark_call_stack();
-  try {
-    d.init(1);
-    assert(false);
-  }
-  catch(std::logic_error&) {
-  }
-  catch (...) {
-    assert(false);
-  }
-  helper::check_call_stack({});
-}
-
-//------------------------------------------------------------------------------
-// test_swap_member()
-//------------------------------------------------------------------------------
-
-template <typename D1, typename D2>
-void test_swap_member(int line, D1& d1, D2& d2, method_list ml) {
-  where(line, __func__);
-  const bool is_init1 = static_cast<bool>(d1);
-  const bool is_init2 = static_cast<bool>(d2);
-  helper::mark_call_stack();
-  d1.swap(d2);
-  helper::check_call_stack(ml);
-  assert(static_cast<bool>(d2) == is_init1);
-  assert(static_cast<bool>(d1) == is_init2);
-}
-
-//------------------------------------------------------------------------------
-// test_swap_non_member()
-//------------------------------------------------------------------------------
-
-template <typename D1, typename D2>
-void test_swap_non_member(int line, D1& d1, D2& d2, method_list ml) {
-  where(line, __func__);
-  const bool is_init1 = static_cast<bool>(d1);
-  const bool is_init2 = static_cast<bool>(d2);
-  helper::mark_call_stack();
-  swap(d1, d2);
-  helper::check_call_stack(ml);
-  assert(static_cast<bool>(d2) == is_init1);
-  assert(static_cast<bool>(d1) == is_init2);
-}
-
-//------------------------------------------------------------------------------
-// main()
-//------------------------------------------------------------------------------
-
-int main() {
-  
-  /***
-   * Test default-constructor.
-   */
-
-  test_default_constructor(__LINE__);
-
-  /***
-   * Create non-const/const helpers.
-   */
-   
-  helper h;
-  const helper ch;
-  
-  /***
-   * Test constructor from helper.
-   */
-
-  // lvalue.
-  test_constructor<helper>(__LINE__, h, true, {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, h, true,
-    {helper::copy_constructor});
-
-  // const lvalue.
-  test_constructor<helper>(__LINE__, ch, true, {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, ch, true,
-    {helper::copy_constructor});
-
-  // rvalue.
-  test_constructor<helper>(__LINE__, std::move(h), true,
-    {helper::move_constructor});
-  test_constructor<const helper>(__LINE__, std::move(h), true,
-    {helper::move_constructor});
-
-  // const rvalue.
-  test_constructor<helper>(__LINE__, std::move(ch), true,
-    {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, std::move(ch), true,
-    {helper::copy_constructor});
-
-  /***
-   * Create default/non-default initialised delayed_init non-const/const.
-   */
-   
-  delayed_init<helper> d0;
-  delayed_init<const helper> cd0;
-  delayed_init<helper> d1(helper(1));
-  delayed_init<const helper> cd1(helper(1));
-    
-  /***
-   * Test constructor from delayed_init.
-   */
-
-  // uninitialised lvalue.
-  test_constructor<helper>(__LINE__, d0, false, {});
-  test_constructor<const helper>(__LINE__, d0, false, {});
-  
-  // uninitialised const lvalue.
-  test_constructor<helper>(__LINE__, cd0, false, {});
-  test_constructor<const helper>(__LINE__, cd0, false, {});
-  
-  // initialised lvalue.
-  test_constructor<helper>(__LINE__, d1, true, {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, d1, true,
-    {helper::copy_constructor});
-
-  // initialised const lvalue.
-  test_constructor<helper>(__LINE__, cd1, true, {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, cd1, true,
-    {helper::copy_constructor});
-
-  // uninitialised rvalue.
-  test_constructor<helper>(__LINE__, std::move(d0), false, {});
-  test_constructor<const helper>(__LINE__, std::move(d0), false, {});
-  
-  // uninitialised const rvalue.
-  test_constructor<helper>(__LINE__, std::move(cd0), false, {});
-  test_constructor<const helper>(__LINE__, std::move(cd0), false, {});
-  
-  // initialised rvalue.
-  test_constructor<helper>(__LINE__, std::move(d1), true,
-    {helper::move_constructor});
-  test_constructor<const helper>(__LINE__, std::move(d1), true,
-    {helper::move_constructor});
-
-  // initialised const rvalue.
-  test_constructor<helper>(__LINE__, std::move(cd1), true,
-    {helper::copy_constructor});
-  test_constructor<const helper>(__LINE__, std::move(cd1), true,
-    {helper::copy_constructor});
-
-  /**
-   * Test destructor.
-   */
-   
-  // uninitialised.
-  test_destructor(__LINE__, d0, {});
-  
-  // initialised.
-  test_destructor(__LINE__, d1, {helper::destructor});
-
-  /***
-   * Test assignment from helper.
-   */
-   
-  // lvalue -> uninitialised.
-  test_assignment(__LINE__, h, d0, true, {helper::copy_constructor});
-  
-  // lvalue -> initialised.
-  test_assignment(__LINE__, h, d1, true, {helper::copy_assignment});
-  
-  // const lvalue -> uninitialised.
-  test_assignment(__LINE__, ch, d0, true, {helper::copy_constructor});
-  
-  // const lvalue -> initialised.
-  test_assignment(__LINE__, ch, d1, true, {helper::copy_assignment});
-
-  // rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(h), d0, true,
-    {helper::move_constructor});
-  
-  // rvalue -> initialised.
-  test_assignment(__LINE__, std::move(h), d1, true,
-    {helper::move_assignment});
-
-  // const rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(ch), d0, true,
-    {helper::copy_constructor});
-
-  // const rvalue -> initialised.
-  test_assignment(__LINE__, std::move(ch), d1, true,
-    {helper::copy_assignment});
-
-  /***
-   * Test assignment from uninitialised delayed_init.
-   */
-   
-  // lvalue -> uninitialised.
-  test_assignment(__LINE__, d0, d0, false, {});
-  
-  // lvalue -> initialised.
-  test_assignment(__LINE__, d0, d1, false, {helper::destructor});
-  
-  // const lvalue -> uninitialised.
-  test_assignment(__LINE__, cd0, d0, false, {});
-
-  // const lvalue -> initialised.
-  test_assignment(__LINE__, cd0, d1, false, {helper::destructor});
-
-  // rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(d0), d0, false, {});
-
-  // rvalue -> initialised.
-  test_assignment(__LINE__, std::move(d0), d1, false, {helper::destructor});
-
-  // const rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(cd0), d0, false, {});
-
-  // const rvalue -> initialised.
-  test_assignment(__LINE__, std::move(cd0), d1, false,
-    {helper::destructor});
-
-  /***
-   * Test assignment from initialised delayed_init.
-   */
-   
-  // lvalue -> uninitialised.
-  test_assignment(__LINE__, d1, d0, true, {helper::copy_constructor});
-  
-  // lvalue -> initialised.
-  test_assignment(__LINE__, d1, d1, true, {helper::copy_assignment});
-  
-  // const lvalue -> uninitialised.
-  test_assignment(__LINE__, cd1, d0, true, {helper::copy_constructor});
-
-  // const lvalue -> initialised.
-  test_assignment(__LINE__, cd1, d1, true, {helper::copy_assignment});
-
-  // rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(d1), d0, true,
-    {helper::move_constructor});
-
-  // rvalue -> initialised.
-  test_assignment(__LINE__, std::move(d1), d1, true,
-    {helper::move_assignment});
-
-  // const rvalue -> uninitialised.
-  test_assignment(__LINE__, std::move(cd1), d0, true,
-    {helper::copy_constructor});
-
-  // const rvalue -> initialised.
-  test_assignment(__LINE__, std::move(cd1), d1, true,
-    {helper::copy_assignment});
-  
-  /***
-   * Test indirection for uninitialised delayed_init.
-   */
-
-  test_indirection_uninitialised<delayed_init<helper>>(__LINE__);
-  test_indirection_uninitialised<delayed_init<const helper>>(__LINE__);
-  
-  /***
-   * Test indirection for initialised delayed_init.
-   */
-
-  test_indirection_initialised<delayed_init<helper>>(__LINE__,
-    {helper::non_const_get});
-  test_indirection_initialised<delayed_init<const helper>>(__LINE__,
-    {helper::const_get});
-
-  /**
-   * Test getter from uninitialised delayed_init.
-   */
-
-  // non-const.
-  test_getter<delayed_init<helper>>(__LINE__, d0, false, false);
-
-  // const.
-  test_getter<const delayed_init<helper>>(__LINE__, d0, true, false);
-  test_getter<delayed_init<const helper>>(__LINE__, d0, true, false);
-  test_getter<const delayed_init<const helper>>(__LINE__, d0, true, false);
-
-  /**
-   * Test getter from initialised delayed_init.
-   */
-
-  // non-const.
-  test_getter<delayed_init<helper>>(__LINE__, d1, false, true);
-
-  // const.
-  test_getter<delayed_init<const helper>>(__LINE__, d1, true, true);
-  test_getter<const delayed_init<helper>>(__LINE__, d1, true, true);
-  test_getter<const delayed_init<const helper>>(__LINE__, d1, true, true);
-
-  /***
-   * Test dereference.
-   */
-   
-  // non-const.
-  test_dereference<delayed_init<helper>>(__LINE__, {helper::non_const_get});
-
-  // const.
-  test_dereference<delayed_init<const helper>>(__LINE__,
-    {helper::const_get});
-  test_dereference<const delayed_init<helper>>(__LINE__,
-    {helper::const_get});
-  test_dereference<const delayed_init<const helper>>(__LINE__,
-    {helper::const_get});
-
-  /***
-   * Test conversion to bool.
-   */
-    
-  // uninitialised.
-  test_conversion_to_bool(__LINE__, d0, false);
-  
-  // initialised.
-  test_conversion_to_bool(__LINE__, d1, true);
-  
-  /***
-   * Test initialiser.
-   */
-  
-  // lvalue -> uninitialised.
-  test_init_uninitialised(__LINE__, {helper::constructor}, 1);
-  test_init_uninitialised(__LINE__, {helper::copy_constructor}, h);
-  test_init_uninitialised(__LINE__, {helper::copy_constructor}, ch);
-  
-  // rvalue -> uninitialised.
-  test_init_uninitialised(__LINE__, {helper::constructor}, std::move(1));
-  test_init_uninitialised(__LINE__, {helper::move_constructor},
-    std::move(h));
-  test_init_uninitialised(__LINE__, {helper::copy_constructor},
-    std::move(ch));
- 
-  // initialised.
-  test_init_initialised(__LINE__);
- 
-  /***
-   * Test swap member.
-   */
-
-  // uninitialised <-> uninitialised.
-  {
-    delayed_init<helper> d1, d2;
-    test_swap_member(__LINE__, d1, d2, {});
-  }
-
-  // initialised <-> uninitialised.
-  {
-    delayed_init<helper> d1(h), d2;
-    test_swap_member(__LINE__, d1, d2,
-      {helper::destructor, helper::move_constructor});
-  }
-  
-  // initialised <-> uninitialised.
-  {
-    delayed_init<helper> d1, d2(h);
-    test_swap_member(__LINE__, d1, d2,
-      {helper::destructor, helper::move_constructor});
-  }
-
-  // initialised <-> initialised.
-  {
-    delayed_init<helper> d1(h), d2(h);
-    test_swap_member(__LINE__, d1, d2,
-      {helper::swap_member, helper::swap_non_member});
-  }
-  
-  /***
-   * Test swap non member.
-   */
-
-  // uninitialised <-> uninitialised.
-  {
-    delayed_init<helper> d1, d2;
-    test_swap_non_member(__LINE__, d1, d2, {});
-  }
-
-  // initialised <-> uninitialised.
-  {
-    delayed_init<helper> d1(h), d2;
-    test_swap_non_member(__LINE__, d1, d2,
-      {helper::destructor, helper::move_constructor});
-  }
-  
-  // initialised <-> uninitialised.
-  {
-    delayed_init<helper> d1, d2(h);
-    test_swap_non_member(__LINE__, d1, d2,
-      {helper::destructor, helper::move_constructor});
-  }
-
-  // initialised <-> initialised.
-  {
-    delayed_init<helper> d1(h), d2(h);
-    test_swap_non_member(__LINE__, d1, d2,
-      {helper::swap_member, helper::swap_non_member});
-  }
-
-  std::cout << "all tests passed." << std::endl;
-  return 0;
-}
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stack>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "delayed_init.h"
+
+// Helper class for testing delayed_init.
+class helper {
+
+  int i_;
+  
+public:
+
+  // List of helper's methods (used for instrumentation purposes).
+  enum method {
+    none, default_constructor, constructor, copy_constructor,
+    move_constructor, destructor, copy_assignment, move_assignment, equal,
+    const_get, non_const_get, swap_member, swap_non_member
+  };
+
+  // Call stack registering calls to helper's methods.
+  static std::stack<method> call_stack;
+  
+  // Mark call stack by pushing helper::none.
+  static void mark_call_stack() {
+    call_stack.push(none);
+  }
+
+  // Check top of call stack against expectation.
+  static void check_call_stack(std::initializer_list<method> methods) {
+    for (auto f : methods) {
+      assert(call_stack.top() == f);
+      call_stack.pop();
+    }
+    assert(call_stack.top() == none);
+    call_stack.pop();
+  }
+   
+  helper() noexcept : i_(0) {
+    call_stack.push(default_constructor);
+  }
+
+  explicit helper(int i) noexcept : i_(i) {
+    call_stack.push(constructor);
+  }
+
+  helper(const helper& other) noexcept : i_(other.i_) {
+    call_stack.push(copy_constructor);
+  }
+  
+  helper(helper&& other) noexcept : i_(other.i_) {
+    call_stack.push(move_constructor);
+  }
+  
+  ~helper() noexcept {
+    call_stack.push(destructor);
+  }
+  
+  helper& operator=(const helper& other) noexcept {
+    call_stack.push(copy_assignment);
+    i_ = other.i_;
+    return *this;
+  }
+  
+  helper& operator=(helper&& other) noexcept {
+    call_stack.push(move_assignment);
+    i_ = other.i_;
+    return *this;
+  }
+  
+  bool operator==(const helper& other) const noexcept {
+    call_stack.push(equal);
+    return i_ == other.i_;
+  }
+  
+  const int& get() const noexcept {
+    call_stack.push(const_get);
+    return i_;
+  }
+  
+  int& get() noexcept {
+    call_stack.push(non_const_get);
+    return i_;
+  }
+  
+  void swap(helper& other) noexcept {
+    call_stack.push(swap_member);
+    std::swap(i_, other.i_);
+  }
+  
+}; // class helper
+
+std::stack<helper::method> helper::call_stack;
+using overload::delayed_init;
+typedef std::initializer_list<helper::method> method_list;
+
+//------------------------------------------------------------------------------
+// swap()
+//------------------------------------------------------------------------------
+
+void swap(helper& h1, helper& h2) noexcept {
+  helper::call_stack.push(helper::swap_non_member);
+  h1.swap(h2);
+}
+
+//------------------------------------------------------------------------------
+// is_pointer_to_const()
+//------------------------------------------------------------------------------
+
+constexpr bool is_pointer_to_const(const helper*) {
+  return true;
+}
+
+constexpr bool is_pointer_to_const(helper*) {
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_default_constructor()
+//------------------------------------------------------------------------------
+
+void test_default_constructor(int line) {
+  where(line, __func__);
+  helper::mark_call_stack();
+  const delayed_init<const helper> d;
+  helper::check_call_stack({});
+  assert(!d);
+}
+
+//------------------------------------------------------------------------------
+// test_constructor()
+//------------------------------------------------------------------------------
+
+template <typename T, typename U>
+void test_constructor(int line, U&& src, bool is_init, method_list ml) {
+  where(line, __func__);
+  helper::mark_call_stack();
+  const delayed_init<T> d(std::forward<U>(src));
+  helper::check_call_stack(ml);
+  assert(static_cast<bool>(d) == is_init);
+}
+
+//------------------------------------------------------------------------------
+// test_destructor()
+//------------------------------------------------------------------------------
+
+template <typename U>
+void test_destructor(int line, const U& src, method_list ml) {
+  where(line, __func__);
+  {
+    const delayed_init<const helper> d(src);
+    helper::mark_call_stack();
+  }
+  helper::check_call_stack(ml);
+}
+
+//------------------------------------------------------------------------------
+// test_assignment()
+//------------------------------------------------------------------------------
+
+template <typename T, typename U>
+void test_assignment(int line, U&& from, const T& to, bool is_init,
+  method_list ml) {
+  
+  where(line, __func__);
+  delayed_init<helper> d(to);
+  helper::mark_call_stack();
+  d = std::forward<U>(from);
+  helper::check_call_stack(ml);
+  assert(static_cast<bool>(d) == is_init);
+}
+
+//------------------------------------------------------------------------------
+// test_indirection_uninitialised()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_indirection_uninitialised(int line) {
+
+  where(line, __func__);
+  D d;
+  helper::mark_call_stack();
+  try {
+    (*d).get();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  catch (...) {
+    assert(false);
+  }
+  helper::check_call_stack({});
+}
+
+//------------------------------------------------------------------------------
+// test_indirection_initialised()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_indirection_initialised(int line, method_list ml) {
+  where(line, __func__);
+  D d(helper(1));
+  helper::mark_call_stack();
+  (*d).get();
+  helper::check_call_stack(ml);
+}
+
+//------------------------------------------------------------------------------
+// test_getter()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_getter(int line, const delayed_init<helper>& src, bool is_const,
+  bool is_init) {
+  
+  where(line, __func__);
+  D d(src);
+  const auto p = d.get();
+  assert(is_pointer_to_const(p) == is_const);
+  assert(static_cast<bool>(p) == is_init);
+}
+
+//------------------------------------------------------------------------------
+// test_dereference()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_dereference(int line, method_list ml) {
+  where(line, __func__);
+  D d(helper(1));
+  helper::mark_call_stack();
+  d->get();
+  helper::check_call_stack(ml);
+}
+
+//------------------------------------------------------------------------------
+// test_conversion_to_bool()
+//------------------------------------------------------------------------------
+
+void test_conversion_to_bool(int line, const delayed_init<const helper>& d,
+  bool is_init) {
+  where(line, __func__);
+  helper::mark_call_stack();
+  assert(static_cast<bool>(d) == is_init);
+  helper::check_call_stack({});
+}
+
+//------------------------------------------------------------------------------
+// test_init_uninitialised()
+//------------------------------------------------------------------------------
+
+template <typename... Args>
+void test_init_uninitialised(int line, method_list ml, Args&&... args) {
+  where(line, __func__);
+  delayed_init<const helper> d;
+  helper::mark_call_stack();
+  d.init(std::forward<Args>(args)...);
+  helper::check_call_stack(ml);
+  assert(d);
+  assert(d.get());
+}
+
+//------------------------------------------------------------------------------
+// test_init_initialised()
+//------------------------------------------------------------------------------
+
+void test_init_initialised(int line) {
+  where(line, __func__);
+  delayed_init<const helper> d(helper(1));
+  helper::mark_call_stack();
+  try {
+    d.init(1);
+    assert(false);
+  }
+  catch(std::logic_error&) {
+  }
+  catch (...) {
+    assert(false);
+  }
+  helper::check_call_stack({});
+}
+
+//------------------------------------------------------------------------------
+// test_init_with()
+//------------------------------------------------------------------------------
+
+// Before C++17, the move from f()'s result might or might not be elided and
+// the call stack is not checked.
+void test_init_with(int line) {
+  where(line, __func__);
+  delayed_init<const helper> d;
+#if __cplusplus >= 201703L
+  helper::mark_call_stack();
+#endif
+  const helper& h = d.init_with([]{ return helper(1); });
+#if __cplusplus >= 201703L
+  helper::check_call_stack({helper::constructor});
+#endif
+  assert(&h == d.get());
+  assert(h.get() == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_emplace()
+//------------------------------------------------------------------------------
+
+void test_emplace(int line, const delayed_init<helper>& src, method_list ml) {
+  where(line, __func__);
+  delayed_init<helper> d(src);
+  helper::mark_call_stack();
+  helper& h = d.emplace(2);
+  helper::check_call_stack(ml);
+  assert(&h == d.get());
+}
+
+//------------------------------------------------------------------------------
+// test_swap_member()
+//------------------------------------------------------------------------------
+
+template <typename D1, typename D2>
+void test_swap_member(int line, D1& d1, D2& d2, method_list ml) {
+  where(line, __func__);
+  const bool is_init1 = static_cast<bool>(d1);
+  const bool is_init2 = static_cast<bool>(d2);
+  helper::mark_call_stack();
+  d1.swap(d2);
+  helper::check_call_stack(ml);
+  assert(static_cast<bool>(d2) == is_init1);
+  assert(static_cast<bool>(d1) == is_init2);
+}
+
+//------------------------------------------------------------------------------
+// test_swap_non_member()
+//------------------------------------------------------------------------------
+
+template <typename D1, typename D2>
+void test_swap_non_member(int line, D1& d1, D2& d2, method_list ml) {
+  where(line, __func__);
+  const bool is_init1 = static_cast<bool>(d1);
+  const bool is_init2 = static_cast<bool>(d2);
+  helper::mark_call_stack();
+  swap(d1, d2);
+  helper::check_call_stack(ml);
+  assert(static_cast<bool>(d2) == is_init1);
+  assert(static_cast<bool>(d1) == is_init2);
+}
+
+//------------------------------------------------------------------------------
+// test_init_with_non_movable()
+//------------------------------------------------------------------------------
+
+#if __cplusplus >= 201703L
+
+// Neither copyable nor movable.
+struct non_movable {
+  explicit non_movable(int i) : i(i) {
+  }
+  non_movable(const non_movable&) = delete;
+  const int i;
+};
+
+void test_init_with_non_movable(int line) {
+  where(line, __func__);
+  delayed_init<non_movable> d;
+  assert(d.init_with([]{ return non_movable(1); }).i == 1);
+  assert(d);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// Triviality of special members.
+//------------------------------------------------------------------------------
+
+static_assert(std::is_trivially_copyable<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially copyable");
+static_assert(std::is_trivially_copyable<delayed_init<double>>::value,
+  "delayed_init<double> is not trivially copyable");
+static_assert(std::is_trivially_destructible<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially destructible");
+static_assert(std::is_trivially_copy_constructible<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially copy-constructible");
+static_assert(std::is_trivially_move_constructible<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially move-constructible");
+static_assert(std::is_trivially_copy_assignable<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially copy-assignable");
+static_assert(std::is_trivially_move_assignable<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially move-assignable");
+static_assert(std::is_trivially_destructible<delayed_init<const int>>::value,
+  "delayed_init<const int> is not trivially destructible");
+
+static_assert(!std::is_trivially_copyable<delayed_init<helper>>::value,
+  "delayed_init<helper> is trivially copyable");
+static_assert(!std::is_trivially_destructible<delayed_init<helper>>::value,
+  "delayed_init<helper> is trivially destructible");
+
+//------------------------------------------------------------------------------
+// test_trivial_copy()
+//------------------------------------------------------------------------------
+
+void test_trivial_copy(int line, const delayed_init<int>& src) {
+  where(line, __func__);
+  delayed_init<int> d1(src);
+  assert(static_cast<bool>(d1) == static_cast<bool>(src));
+  assert(!d1 || *d1 == *src);
+  delayed_init<int> d2(2);
+  d2 = src;
+  assert(static_cast<bool>(d2) == static_cast<bool>(src));
+  assert(!d2 || *d2 == *src);
+}
+
+//------------------------------------------------------------------------------
+// Niche storage.
+//------------------------------------------------------------------------------
+
+// File descriptor whose invalid value -1 marks the empty state.
+struct file_descriptor {
+  int fd;
+};
+
+namespace overload {
+
+template <>
+struct niche_traits<file_descriptor> {
+
+  static constexpr file_descriptor empty() noexcept {
+    return {-1};
+  }
+
+  static constexpr bool is_empty(const file_descriptor& obj) noexcept {
+    return obj.fd == -1;
+  }
+};
+
+} // namespace overload
+
+using overload::storage::niche;
+
+static_assert(sizeof(delayed_init<double, niche>) == sizeof(double),
+  "delayed_init<double, niche> is larger than double");
+static_assert(sizeof(delayed_init<void*, niche>) == sizeof(void*),
+  "delayed_init<void*, niche> is larger than void*");
+static_assert(sizeof(delayed_init<file_descriptor, niche>) ==
+  sizeof(file_descriptor), "delayed_init<file_descriptor, niche> is larger "
+  "than file_descriptor");
+static_assert(std::is_trivially_copyable<delayed_init<double, niche>>::value,
+  "delayed_init<double, niche> is not trivially copyable");
+
+//------------------------------------------------------------------------------
+// test_niche()
+//------------------------------------------------------------------------------
+
+template <typename T>
+void test_niche(int line, const T& value) {
+  where(line, __func__);
+  delayed_init<T, niche> d0;
+  assert(!d0);
+  assert(d0.get() == nullptr);
+  delayed_init<T, niche> d1(value);
+  assert(d1);
+  assert(std::memcmp(d1.get(), &value, sizeof(T)) == 0);
+  d0 = d1;
+  assert(d0);
+  d1 = delayed_init<T, niche>();
+  assert(!d1);
+  d1.init(value);
+  assert(d1);
+  const delayed_init<T> d2(d1);
+  assert(d2);
+}
+
+//------------------------------------------------------------------------------
+// test_niche_sentinel()
+//------------------------------------------------------------------------------
+
+template <typename T>
+void test_niche_sentinel(int line, const T& value) {
+
+  where(line, __func__);
+  const T sentinel = overload::niche_traits<T>::empty();
+  delayed_init<T, niche> d;
+
+  unsigned n_failures = 0;
+  auto expect_failure = [&](void (*op)(delayed_init<T, niche>&, const T&)) {
+    try {
+      op(d, sentinel);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+      ++n_failures;
+    }
+    catch (...) {
+      assert(false);
+    }
+    assert(!d);
+  };
+
+  expect_failure([](delayed_init<T, niche>& d, const T& s) { d.init(s); });
+  expect_failure([](delayed_init<T, niche>& d, const T& s) { d.emplace(s); });
+  expect_failure([](delayed_init<T, niche>& d, const T& s) { d = s; });
+  d.init(value);
+  expect_failure([](delayed_init<T, niche>& d, const T& s) { d = s; });
+  expect_failure([](delayed_init<T, niche>& d, const T& s) {
+    d.init_from_bytes(&s, sizeof(T));
+  });
+  expect_failure([](delayed_init<T, niche>& d, const T& s) {
+    delayed_init<T, niche>(s).swap(d);
+  });
+  assert(n_failures == 6);
+}
+
+//------------------------------------------------------------------------------
+// Checking policies.
+//------------------------------------------------------------------------------
+
+namespace check = overload::check;
+using overload::storage::flag;
+
+static_assert(!noexcept(*std::declval<delayed_init<int>&>()),
+  "delayed_init<int>::operator*() is noexcept");
+static_assert(noexcept(*std::declval<delayed_init<int, flag, check::none>&>()),
+  "delayed_init<int, flag, check::none>::operator*() is not noexcept");
+static_assert(noexcept(
+  *std::declval<const delayed_init<int, flag, check::assertion>&>()),
+  "delayed_init<int, flag, check::assertion>::operator*() is not noexcept");
+static_assert(noexcept(
+  *std::declval<delayed_init<int, flag, check::terminate>&>()),
+  "delayed_init<int, flag, check::terminate>::operator*() is not noexcept");
+static_assert(noexcept(std::declval<delayed_init<int>&>().value_unchecked()),
+  "delayed_init<int>::value_unchecked() is not noexcept");
+static_assert(!std::is_nothrow_constructible<delayed_init<double, niche>,
+  double>::value, "delayed_init<double, niche>(double) is noexcept");
+static_assert(std::is_nothrow_constructible<
+  delayed_init<double, niche, check::none>, double>::value,
+  "delayed_init<double, niche, check::none>(double) is not noexcept");
+static_assert(std::is_nothrow_constructible<delayed_init<double>,
+  double>::value, "delayed_init<double>(double) is not noexcept");
+
+//------------------------------------------------------------------------------
+// test_unchecked()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_unchecked(int line, method_list ml) {
+  where(line, __func__);
+  D d;
+  helper::mark_call_stack();
+  d.init_unchecked(1);
+  d.value_unchecked().get();
+  (*d).get();
+  helper::check_call_stack(ml);
+  assert(d);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+//------------------------------------------------------------------------------
+// test_check_aborts()
+//------------------------------------------------------------------------------
+
+// Runs f in a child process and checks that the child aborts.
+template <typename F>
+void expect_abort(F f) {
+  std::fflush(nullptr);
+  const pid_t pid = fork();
+  assert(pid != -1);
+  if (pid == 0) {
+    // Silences the message of assert.
+    if (!std::freopen("/dev/null", "w", stderr))
+      std::_Exit(2);
+    f();
+    std::_Exit(0);
+  }
+  int status = 0;
+  const pid_t waited = waitpid(pid, &status, 0);
+  assert(waited == pid);
+  assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+  (void) waited;
+}
+
+template <typename C>
+void test_check_aborts(int line) {
+
+  where(line, __func__);
+  typedef delayed_init<int, flag, C> D;
+
+  expect_abort([] {
+    D d;
+    std::printf("%d", *d);
+  });
+  expect_abort([] {
+    D d(1);
+    d.init(2);
+  });
+  expect_abort([] {
+    D d;
+    d.take();
+  });
+  expect_abort([] {
+    delayed_init<double, niche, C> d;
+    d.init(overload::niche_traits<double>::empty());
+  });
+
+  // No abort when pre-conditions hold.
+  D d;
+  d.init(1);
+  assert(*d == 1);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// Out-of-line storage.
+//------------------------------------------------------------------------------
+
+// Bump-pointer arena counting live blocks (memory is never reused).
+struct arena {
+
+  static char buffer[4096];
+  static std::size_t used;
+  static int live;
+
+  static void* allocate(std::size_t size, std::size_t align) {
+    used = (used + align - 1) / align * align;
+    void* ptr = buffer + used;
+    used += size;
+    assert(used <= sizeof(buffer));
+    ++live;
+    return ptr;
+  }
+
+  static void deallocate(void*, std::size_t, std::size_t) noexcept {
+    --live;
+  }
+};
+
+alignas(64) char arena::buffer[4096];
+std::size_t arena::used = 0;
+int arena::live = 0;
+
+// Large configuration block.
+struct config_block {
+  char data[2048];
+};
+
+using overload::storage::out_of_line;
+
+static_assert(sizeof(delayed_init<config_block, out_of_line<>>) ==
+  sizeof(void*), "delayed_init<config_block, out_of_line<>> is larger than "
+  "void*");
+static_assert(std::is_nothrow_move_constructible<
+  delayed_init<helper, out_of_line<arena>>>::value,
+  "delayed_init<helper, out_of_line<arena>> is not nothrow move constructible");
+
+//------------------------------------------------------------------------------
+// test_out_of_line()
+//------------------------------------------------------------------------------
+
+void test_out_of_line(int line) {
+  where(line, __func__);
+  typedef delayed_init<helper, out_of_line<arena>> D;
+  const int live = arena::live;
+  {
+    D d0;
+    assert(!d0);
+    assert(arena::live == live);
+
+    helper::mark_call_stack();
+    d0.init(1);
+    helper::check_call_stack({helper::constructor});
+    assert(d0);
+    assert(arena::live == live + 1);
+    assert(reinterpret_cast<const char*>(d0.get()) >= arena::buffer);
+
+    // Copies are deep.
+    helper::mark_call_stack();
+    D d1(d0);
+    helper::check_call_stack({helper::copy_constructor});
+    assert(d1.get() != d0.get());
+    assert(arena::live == live + 2);
+
+    // Moves transfer the object.
+    const helper* ptr = d1.get();
+    helper::mark_call_stack();
+    D d2(std::move(d1));
+    helper::check_call_stack({});
+    assert(!d1);
+    assert(d2.get() == ptr);
+    assert(arena::live == live + 2);
+
+    helper::mark_call_stack();
+    d1 = std::move(d2);
+    helper::check_call_stack({});
+    assert(d1.get() == ptr);
+    assert(!d2);
+
+    helper::mark_call_stack();
+    d1 = std::move(d0);
+    helper::check_call_stack({helper::destructor});
+    assert(!d0);
+    assert(arena::live == live + 1);
+
+    helper::mark_call_stack();
+    d2 = d1;
+    helper::check_call_stack({helper::copy_constructor});
+    assert(arena::live == live + 2);
+
+    helper::mark_call_stack();
+    d2 = D();
+    helper::check_call_stack({helper::destructor});
+    assert(!d2);
+    assert(arena::live == live + 1);
+
+    helper::mark_call_stack();
+  }
+  helper::check_call_stack({helper::destructor});
+  assert(arena::live == live);
+}
+
+#if defined(__cpp_lib_memory_resource)
+
+//------------------------------------------------------------------------------
+// test_out_of_line_pmr()
+//------------------------------------------------------------------------------
+
+// Memory resource counting the blocks it has allocated and not deallocated.
+class counting_resource : public std::pmr::memory_resource {
+
+public:
+
+  int live = 0;
+
+private:
+
+  void* do_allocate(std::size_t size, std::size_t align) override {
+    ++live;
+    return std::pmr::new_delete_resource()->allocate(size, align);
+  }
+
+  void do_deallocate(void* ptr, std::size_t size, std::size_t align)
+    override {
+    --live;
+    std::pmr::new_delete_resource()->deallocate(ptr, size, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    override {
+    return this == &other;
+  }
+};
+
+// Over-aligned type.
+struct alignas(64) aligned_block {
+  char data[64];
+};
+
+void test_out_of_line_pmr(int line) {
+
+  where(line, __func__);
+  using overload::storage::pmr_default_resource;
+  using overload::storage::pmr_resource;
+
+  alignas(std::max_align_t) char buffer[4 * sizeof(config_block)];
+  std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer),
+    std::pmr::null_memory_resource());
+  std::pmr::memory_resource* previous =
+    std::pmr::set_default_resource(&resource);
+  {
+    delayed_init<config_block, out_of_line<pmr_default_resource>> d;
+    d.init();
+    assert(reinterpret_cast<char*>(d.get()) >= buffer);
+    assert(reinterpret_cast<char*>(d.get() + 1) <= buffer + sizeof(buffer));
+  }
+  std::pmr::set_default_resource(previous);
+
+  // Memory goes back to the resource it came from.
+  counting_resource r1, r2;
+  previous = std::pmr::set_default_resource(&r1);
+  {
+    delayed_init<aligned_block, out_of_line<pmr_default_resource>> d;
+    d.init();
+    assert(reinterpret_cast<std::uintptr_t>(d.get()) % 64 == 0);
+    std::pmr::set_default_resource(&r2);
+    assert(r1.live == 1 && r2.live == 0);
+  }
+  assert(r1.live == 0 && r2.live == 0);
+  std::pmr::set_default_resource(previous);
+
+  // User-supplied resources.
+  struct tag;
+  typedef delayed_init<int, out_of_line<pmr_resource<tag>>> D;
+  assert(pmr_resource<tag>::get() == std::pmr::get_default_resource());
+  pmr_resource<tag>::set(&r1);
+  {
+    D d1(1);
+    pmr_resource<tag>::set(&r2);
+    D d2(2);
+    assert(r1.live == 1 && r2.live == 1);
+    d1 = D();
+    assert(r1.live == 0 && r2.live == 1);
+  }
+  assert(r1.live == 0 && r2.live == 0);
+  pmr_resource<tag>::set(nullptr);
+  assert(pmr_resource<tag>::get() == std::pmr::get_default_resource());
+}
+
+#endif // defined(__cpp_lib_memory_resource)
+
+//------------------------------------------------------------------------------
+// Relocation.
+//------------------------------------------------------------------------------
+
+namespace overload {
+namespace traits {
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : public std::true_type {
+};
+
+} // namespace traits
+} // namespace overload
+
+using overload::traits::is_trivially_relocatable;
+
+static_assert(is_trivially_relocatable<delayed_init<int>>::value,
+  "delayed_init<int> is not trivially relocatable");
+static_assert(is_trivially_relocatable<delayed_init<double, niche>>::value,
+  "delayed_init<double, niche> is not trivially relocatable");
+static_assert(is_trivially_relocatable<
+  delayed_init<std::unique_ptr<int>>>::value,
+  "delayed_init<std::unique_ptr<int>> is not trivially relocatable");
+static_assert(is_trivially_relocatable<
+  delayed_init<helper, out_of_line<>>>::value,
+  "delayed_init<helper, out_of_line<>> is not trivially relocatable");
+static_assert(!is_trivially_relocatable<delayed_init<helper>>::value,
+  "delayed_init<helper> is trivially relocatable");
+
+//------------------------------------------------------------------------------
+// test_relocate_to()
+//------------------------------------------------------------------------------
+
+void test_relocate_to(int line) {
+  where(line, __func__);
+
+  delayed_init<std::unique_ptr<int>> p0, p1;
+  p0.init(new int(1));
+  p0.relocate_to(p1);
+  assert(!p0);
+  assert(p1 && **p1 == 1);
+  delayed_init<std::unique_ptr<int>> p2;
+  p0.relocate_to(p2);
+  assert(!p0);
+  assert(!p2);
+
+  delayed_init<helper> h0, h1;
+  h0.init(1);
+  helper::mark_call_stack();
+  h0.relocate_to(h1);
+  helper::check_call_stack({helper::destructor, helper::move_constructor});
+  assert(!h0);
+  assert(h1);
+}
+
+//------------------------------------------------------------------------------
+// test_relocate_range()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_relocate_range(int line, method_list ml) {
+  where(line, __func__);
+  D src[3];
+  src[0].init(0);
+  src[2].init(2);
+  alignas(D) char buffer[sizeof(src)];
+  helper::mark_call_stack();
+  D* d_last = overload::relocate(src, src + 3, buffer);
+  helper::check_call_stack(ml);
+  D* dst = reinterpret_cast<D*>(buffer);
+  assert(d_last == dst + 3);
+  assert(dst[0] && (*dst[0]).get() == 0);
+  assert(!dst[1]);
+  assert(dst[2] && (*dst[2]).get() == 2);
+  // The source objects have ceased to exist: reuse their memory.
+  for (auto& d : src)
+    new (&d) D();
+  for (D* d = dst; d != d_last; ++d)
+    d->~D();
+}
+
+#if OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR
+
+//------------------------------------------------------------------------------
+// constexpr support.
+//------------------------------------------------------------------------------
+
+// Literal type with a non-trivial destructor counting destructions.
+class literal {
+
+  int  i_;
+  int* destructions_;
+
+public:
+
+  constexpr literal(int i, int* destructions) noexcept : i_(i),
+    destructions_(destructions) {
+  }
+
+  constexpr literal(const literal& other) noexcept : i_(other.i_),
+    destructions_(other.destructions_) {
+  }
+
+  constexpr literal& operator=(const literal& other) noexcept {
+    i_ = other.i_;
+    return *this;
+  }
+
+  constexpr ~literal() {
+    ++*destructions_;
+  }
+
+  constexpr int get() const noexcept {
+    return i_;
+  }
+};
+
+constexpr int test_constexpr_literal() {
+  int destructions = 0;
+  {
+    delayed_init<literal> d0;
+    d0.init(1, &destructions);
+    delayed_init<literal> d1(d0);
+    d1 = d0;
+    d0.emplace(2, &destructions);
+    if (d0->get() + (*d1).get() != 3)
+      return -1;
+    d0.swap(d1);
+    d0 = delayed_init<literal>();
+  }
+  return destructions;
+}
+
+static_assert(test_constexpr_literal() == 4,
+  "delayed_init<literal> is not usable in constant expressions");
+
+constexpr delayed_init<int> table[] = {
+  delayed_init<int>(1), delayed_init<int>(), delayed_init<int>(3)
+};
+
+static_assert(*table[0] == 1 && !table[1] && *table[2].get() == 3,
+  "constexpr delayed_init<int> table is not constant-initialised");
+
+constinit delayed_init<int> global(42);
+
+#endif // OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR
+
+//------------------------------------------------------------------------------
+// noexcept and special members.
+//------------------------------------------------------------------------------
+
+// Copyable type whose move constructor might throw.
+struct throwing_move {
+
+  static int copies;
+
+  throwing_move() noexcept {
+  }
+
+  throwing_move(const throwing_move&) noexcept {
+    ++copies;
+  }
+
+  throwing_move(throwing_move&&) noexcept(false) {
+  }
+
+  throwing_move& operator=(const throwing_move&) = default;
+};
+
+int throwing_move::copies = 0;
+
+// Type whose copy constructor counts calls (move is noexcept).
+struct counted_copy {
+
+  static int copies;
+
+  counted_copy() noexcept {
+  }
+
+  counted_copy(const counted_copy&) noexcept {
+    ++copies;
+  }
+
+  counted_copy(counted_copy&&) noexcept {
+  }
+
+  counted_copy& operator=(const counted_copy&) = default;
+
+  counted_copy& operator=(counted_copy&&) = default;
+};
+
+int counted_copy::copies = 0;
+
+typedef delayed_init<std::unique_ptr<int>> unique_d;
+
+static_assert(std::is_nothrow_move_constructible<delayed_init<helper>>::value,
+  "delayed_init<helper> is not nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable<delayed_init<helper>>::value,
+  "delayed_init<helper> is not nothrow move assignable");
+static_assert(std::is_nothrow_move_constructible<unique_d>::value,
+  "delayed_init<std::unique_ptr<int>> is not nothrow move constructible");
+static_assert(!std::is_copy_constructible<unique_d>::value,
+  "delayed_init<std::unique_ptr<int>> is copy constructible");
+static_assert(!std::is_copy_assignable<unique_d>::value,
+  "delayed_init<std::unique_ptr<int>> is copy assignable");
+static_assert(noexcept(std::declval<unique_d&>().swap(
+  std::declval<unique_d&>())),
+  "delayed_init<std::unique_ptr<int>>::swap() is not noexcept");
+static_assert(noexcept(overload::swap(std::declval<unique_d&>(),
+  std::declval<unique_d&>())),
+  "swap(delayed_init<std::unique_ptr<int>>&, ...) is not noexcept");
+static_assert(noexcept(overload::swap(std::declval<delayed_init<int>&>(),
+  std::declval<delayed_init<int>&>())),
+  "swap(delayed_init<int>&, ...) is not noexcept");
+static_assert(!std::is_nothrow_move_constructible<
+  delayed_init<throwing_move>>::value,
+  "delayed_init<throwing_move> is nothrow move constructible");
+static_assert(std::is_copy_constructible<delayed_init<const helper>>::value,
+  "delayed_init<const helper> is not copy constructible");
+static_assert(!std::is_copy_assignable<delayed_init<const helper>>::value,
+  "delayed_init<const helper> is copy assignable");
+
+// Type constructible from anything.
+struct sink {
+  template <typename U>
+  sink(U&&) noexcept {
+  }
+};
+
+//------------------------------------------------------------------------------
+// test_copy_not_hijacked()
+//------------------------------------------------------------------------------
+
+// Checks that copies of non-const delayed_init<T> are not taken as T's
+// initialisers.
+void test_copy_not_hijacked(int line) {
+  where(line, __func__);
+  delayed_init<sink> d0;
+  delayed_init<sink> d1(d0);
+  assert(!d1);
+  d1 = d0;
+  assert(!d1);
+}
+
+//------------------------------------------------------------------------------
+// test_vector_growth()
+//------------------------------------------------------------------------------
+
+// Checks how many times std::vector<delayed_init<T>> copies T while growing.
+template <typename T>
+void test_vector_growth(int line, bool expect_copies) {
+  where(line, __func__);
+  T::copies = 0;
+  std::vector<delayed_init<T>> v;
+  for (int i = 0; i < 100; ++i) {
+    v.emplace_back();
+    if (i % 2 == 0)
+      v.back().init();
+  }
+  assert((T::copies > 0) == expect_copies);
+}
+
+//------------------------------------------------------------------------------
+// test_value_or()
+//------------------------------------------------------------------------------
+
+void test_value_or(int line) {
+  where(line, __func__);
+  const helper fallback(2);
+  const delayed_init<helper> d0;
+  assert(&d0.value_or(fallback) == &fallback);
+  const delayed_init<helper> d1(helper(1));
+  assert(&d1.value_or(fallback) == d1.get());
+  helper h(3);
+  delayed_init<helper> d2;
+  d2.value_or(h).get() = 4;
+  assert(h.get() == 4);
+}
+
+//------------------------------------------------------------------------------
+// test_transform_in_place()
+//------------------------------------------------------------------------------
+
+void test_transform_in_place(int line) {
+  where(line, __func__);
+  delayed_init<helper> d0;
+  helper::mark_call_stack();
+  assert(!d0.transform_in_place([](helper& h) { h.get() = 2; }));
+  helper::check_call_stack({});
+  delayed_init<helper> d1(helper(1));
+  helper::mark_call_stack();
+  assert(d1.transform_in_place([](helper& h) { h.get() = 2; }));
+  helper::check_call_stack({helper::non_const_get});
+  assert(d1.value_unchecked().get() == 2);
+}
+
+//------------------------------------------------------------------------------
+// test_transform()
+//------------------------------------------------------------------------------
+
+void test_transform(int line) {
+  where(line, __func__);
+  const delayed_init<int> d0;
+  const delayed_init<int> d1(1);
+  auto twice = [](int i) { return helper(2 * i); };
+
+  helper::mark_call_stack();
+  delayed_init<helper> r0 = d0.transform(twice);
+  helper::check_call_stack({});
+  assert(!r0);
+
+  delayed_init<helper> r1 = d1.transform(twice);
+  assert(r1);
+  assert(r1.value_unchecked().get() == 2);
+
+#if __cplusplus >= 201703L
+  // The result is built in place.
+  helper::mark_call_stack();
+  delayed_init<helper> r2 = d1.transform(twice);
+  helper::check_call_stack({helper::constructor});
+#endif
+
+  delayed_init<std::unique_ptr<int>> p(new int(3));
+  auto r3 = std::move(p).transform([](std::unique_ptr<int>&& q) {
+    return std::move(q);
+  });
+  assert(r3 && **r3 == 3);
+  assert(p && !*p);
+}
+
+//------------------------------------------------------------------------------
+// test_and_then()
+//------------------------------------------------------------------------------
+
+delayed_init<int> positive_half(int i) {
+  return i > 0 ? delayed_init<int>(i / 2) : delayed_init<int>();
+}
+
+void test_and_then(int line) {
+  where(line, __func__);
+  assert(!delayed_init<int>().and_then(positive_half));
+  assert(!delayed_init<int>(-2).and_then(positive_half));
+  const delayed_init<int> d(4);
+  assert(*d.and_then(positive_half).and_then(positive_half) == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_take()
+//------------------------------------------------------------------------------
+
+void test_take(int line) {
+  where(line, __func__);
+  delayed_init<helper> d(helper(1));
+  helper::mark_call_stack();
+  helper h = d.take();
+  helper::check_call_stack({helper::destructor, helper::move_constructor});
+  assert(!d);
+  assert(h.get() == 1);
+  try {
+    d.take();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_comparison()
+//------------------------------------------------------------------------------
+
+template <typename T>
+void test_comparison(int line, const T& small, const T& big) {
+  where(line, __func__);
+  const delayed_init<T> n1, n2;
+  const delayed_init<T> s(small), b(big);
+  assert(n1 == n2 && !(n1 != n2) && !(n1 < n2) && n1 <= n2);
+  assert(!(n1 > n2) && n1 >= n2);
+  assert(n1 != s && n1 < s && n1 <= s && !(n1 > s) && !(n1 >= s));
+  assert(s != n1 && !(s < n1) && !(s <= n1) && s > n1 && s >= n1);
+  assert(s == s && s != b && s < b && s <= b && b > s && b >= s);
+  assert(!(b < s) && !(b <= s) && !(s > b) && !(s >= b));
+  assert(n1 != small && n1 < small && small > n1 && small != n1);
+  assert(s == small && small == s && s < big && big > s && s <= small);
+}
+
+void test_comparison_mixed(int line) {
+  where(line, __func__);
+  const delayed_init<int> i(1);
+  const delayed_init<long, overload::storage::out_of_line<>> l(2);
+  const delayed_init<const double> nan(0.0 / 0.0);
+  const delayed_init<double, overload::storage::niche> d(0.5);
+  assert(i < l && l > i && i != l && i == 1L);
+  typedef delayed_init<double, overload::storage::niche> niche_double;
+  assert(d < i && d != niche_double());
+  // As for std::optional, NaN compares as the inner object does.
+  assert(!(nan == nan) && nan != nan && !(nan <= nan) && !(nan >= nan));
+  assert(nan > delayed_init<double>());
+  assert(delayed_init<std::string>("a") < std::string("b"));
+}
+
+//------------------------------------------------------------------------------
+// test_hash()
+//------------------------------------------------------------------------------
+
+template <typename T>
+void test_hash(int line, const T& value) {
+  where(line, __func__);
+  typedef std::hash<delayed_init<T>> hash;
+  assert(hash()(delayed_init<T>(value)) == std::hash<T>()(value));
+  assert(hash()(delayed_init<T>()) == hash()(delayed_init<T>()));
+  assert(hash()(delayed_init<T>()) != hash()(delayed_init<T>(T())));
+  std::unordered_set<delayed_init<T>, hash> set;
+  set.emplace();
+  set.emplace(value);
+  set.emplace(value);
+  set.emplace();
+  assert(set.size() == 2);
+  assert(set.count(delayed_init<T>()) == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_construct_in()
+//------------------------------------------------------------------------------
+
+void test_construct_in(int line) {
+  where(line, __func__);
+  delayed_init<helper> d;
+  {
+    auto c = d.construct_in();
+    assert(!d);
+    assert(c.data() == c.get());
+    helper::mark_call_stack();
+    new (c.data()) helper(3);
+    assert(&c.commit() == d.get());
+    // Built in place: no move and no destruction of a temporary.
+    helper::check_call_stack({helper::constructor});
+  }
+  assert(d && d.value_unchecked().get() == 3);
+  try {
+    d.construct_in();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_construct_in_rollback()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_construct_in_rollback(int line) {
+  where(line, __func__);
+  D d;
+  try {
+    auto c = d.construct_in();
+    std::memset(c.data(), 0xff, sizeof(typename D::value_type));
+    throw 0;
+  }
+  catch (int) {
+  }
+  assert(!d);
+  d.construct_in();
+  assert(!d);
+}
+
+void test_construct_in_out_of_line(int line) {
+  where(line, __func__);
+  typedef delayed_init<helper, out_of_line<arena>> D;
+  const int live = arena::live;
+  {
+    D d;
+    {
+      auto c = d.construct_in();
+      assert(arena::live == live + 1);
+    }
+    assert(!d && arena::live == live);
+    auto c = d.construct_in();
+    new (c.data()) helper(2);
+    c.commit();
+    assert(d.get() == c.get() && arena::live == live + 1);
+  }
+  assert(arena::live == live);
+}
+
+//------------------------------------------------------------------------------
+// test_init_from_bytes()
+//------------------------------------------------------------------------------
+
+struct record {
+  int    id;
+  double price;
+};
+
+template <typename D>
+void test_init_from_bytes(int line) {
+  where(line, __func__);
+  const record r = {7, 2.5};
+  unsigned char bytes[sizeof(record)];
+  std::memcpy(bytes, &r, sizeof(r));
+  D d;
+  try {
+    d.init_from_bytes(bytes, sizeof(bytes) - 1);
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  assert(!d);
+  assert(&d.init_from_bytes(bytes, sizeof(bytes)) == d.get());
+  assert(d->id == 7 && d->price == 2.5);
+  try {
+    d.init_from_bytes(bytes, sizeof(bytes));
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+}
+
+//------------------------------------------------------------------------------
+// Layout policies.
+//------------------------------------------------------------------------------
+
+using overload::storage::flag_after;
+using overload::storage::aligned;
+
+constexpr std::size_t cache_line = OVERLOAD_DELAYED_INIT_CACHE_LINE;
+
+static_assert(sizeof(delayed_init<double, flag_after>) ==
+  sizeof(delayed_init<double>), "delayed_init<double, flag_after> is larger "
+  "than delayed_init<double>");
+static_assert(std::is_trivially_copyable<delayed_init<int, flag_after>>::value,
+  "delayed_init<int, flag_after> is not trivially copyable");
+static_assert(alignof(delayed_init<int, aligned<>>) == cache_line,
+  "delayed_init<int, aligned<>> is not aligned to a cache line");
+static_assert(sizeof(delayed_init<int, aligned<>>) == cache_line,
+  "delayed_init<int, aligned<>> doesn't fill a cache line");
+static_assert(alignof(delayed_init<double, aligned<flag, 1>>) ==
+  alignof(double), "delayed_init<double, aligned<flag, 1>> is underaligned");
+static_assert(std::is_trivially_copyable<delayed_init<int, aligned<>>>::value,
+  "delayed_init<int, aligned<>> is not trivially copyable");
+static_assert(sizeof(delayed_init<config_block, aligned<out_of_line<>>>) ==
+  cache_line, "delayed_init<config_block, aligned<out_of_line<>>> doesn't fill "
+  "a cache line");
+static_assert(is_trivially_relocatable<
+  delayed_init<std::unique_ptr<int>, aligned<flag_after>>>::value,
+  "delayed_init<std::unique_ptr<int>, aligned<flag_after>> is not trivially "
+  "relocatable");
+static_assert(!is_trivially_relocatable<
+  delayed_init<helper, aligned<>>>::value,
+  "delayed_init<helper, aligned<>> is trivially relocatable");
+
+//------------------------------------------------------------------------------
+// test_flag_after()
+//------------------------------------------------------------------------------
+
+void test_flag_after(int line) {
+  where(line, __func__);
+  typedef delayed_init<helper, flag_after> D;
+  D d0;
+  assert(!d0);
+  helper::mark_call_stack();
+  d0.init(1);
+  helper::check_call_stack({helper::constructor});
+  assert(static_cast<const void*>(d0.get()) == static_cast<const void*>(&d0));
+  helper::mark_call_stack();
+  D d1(d0);
+  helper::check_call_stack({helper::copy_constructor});
+  assert(d1);
+  helper::mark_call_stack();
+  d1 = D();
+  helper::check_call_stack({helper::destructor});
+  assert(!d1);
+  const delayed_init<double, flag_after> x(0.5), y;
+  assert(y < x && x == 0.5);
+}
+
+//------------------------------------------------------------------------------
+// test_aligned()
+//------------------------------------------------------------------------------
+
+template <typename D>
+void test_aligned(int line) {
+  where(line, __func__);
+  D d[2];
+  const auto address = [](const D& e) {
+    return reinterpret_cast<std::uintptr_t>(&e);
+  };
+  assert(address(d[0]) % cache_line == 0);
+  assert(address(d[1]) - address(d[0]) >= cache_line);
+  helper::mark_call_stack();
+  d[1].init(1);
+  helper::check_call_stack({helper::constructor});
+  helper::mark_call_stack();
+  d[0] = d[1];
+  helper::check_call_stack({helper::copy_constructor});
+  assert(d[0] && *d[0] == *d[1]);
+  helper::mark_call_stack();
+  d[1] = D();
+  helper::check_call_stack({helper::destructor});
+  assert(!d[1]);
+}
+
+//------------------------------------------------------------------------------
+// References.
+//------------------------------------------------------------------------------
+
+static_assert(sizeof(delayed_init<helper&>) == sizeof(helper*),
+  "delayed_init<helper&> is larger than a pointer");
+static_assert(std::is_trivially_copyable<delayed_init<helper&>>::value,
+  "delayed_init<helper&> is not trivially copyable");
+static_assert(is_trivially_relocatable<delayed_init<const helper&>>::value,
+  "delayed_init<const helper&> is not trivially relocatable");
+static_assert(!std::is_constructible<delayed_init<const int&>, int>::value,
+  "delayed_init<const int&> binds to rvalues");
+static_assert(std::is_constructible<delayed_init<const int&>, int&>::value,
+  "delayed_init<const int&> doesn't bind to lvalues");
+
+struct base {
+  int id;
+};
+
+struct derived : base {
+};
+
+//------------------------------------------------------------------------------
+// test_reference()
+//------------------------------------------------------------------------------
+
+void test_reference(int line) {
+  where(line, __func__);
+  int x = 1, y = 2;
+  delayed_init<int&> d;
+  assert(!d && d.get() == nullptr);
+  try {
+    *d;
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  assert(&d.value_or(y) == &y);
+
+  assert(&d.init(x) == &x);
+  assert(d && d.get() == &x && &*d == &x);
+  try {
+    d.init(y);
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  *d = 3;
+  assert(x == 3);
+
+  // Copies share the referee and emplace() rebinds.
+  const delayed_init<int&> e(d);
+  assert(e.get() == &x);
+  d.emplace(y);
+  assert(d.get() == &y && e.get() == &x);
+  // Referee of a const object is mutable.
+  *e = 4;
+  assert(x == 4);
+
+  delayed_init<int&> f;
+  swap(d, f);
+  assert(!d && f.get() == &y);
+  f.recycle();
+  assert(!f);
+
+  // Comparisons and hashing are on referees.
+  const delayed_init<const int&> g(y);
+  const int z = 2;
+  assert(g == delayed_init<const int&>(z) && g == 2 && 1 < g);
+  assert(delayed_init<int&>() < g);
+  assert(std::hash<delayed_init<const int&>>()(g) == std::hash<int>()(2));
+
+  derived obj;
+  obj.id = 5;
+  const delayed_init<derived&> r(obj);
+  const delayed_init<const base&> b(r);
+  assert(b->id == 5 && b.get() == &obj);
+}
+
+//------------------------------------------------------------------------------
+// Recycling.
+//------------------------------------------------------------------------------
+
+using overload::storage::recyclable;
+
+// Counts constructions, clears and destructions.
+struct reusable {
+
+  static int n_built;
+  static int n_cleared;
+  static int n_destroyed;
+
+  reusable() noexcept : value(0) {
+    ++n_built;
+  }
+
+  reusable(int v, int w) noexcept : value(v + w) {
+    ++n_built;
+  }
+
+  reusable(const reusable& other) noexcept : value(other.value) {
+    ++n_built;
+  }
+
+  reusable& operator=(const reusable& other) noexcept {
+    value = other.value;
+    return *this;
+  }
+
+  ~reusable() noexcept {
+    ++n_destroyed;
+  }
+
+  void clear() noexcept {
+    value = 0;
+    ++n_cleared;
+  }
+
+  int value;
+};
+
+int reusable::n_built     = 0;
+int reusable::n_cleared   = 0;
+int reusable::n_destroyed = 0;
+
+static_assert(!is_trivially_relocatable<
+  delayed_init<std::string, recyclable>>::value,
+  "delayed_init<std::string, recyclable> is trivially relocatable");
+
+//------------------------------------------------------------------------------
+// test_recycle()
+//------------------------------------------------------------------------------
+
+void test_recycle(int line) {
+  where(line, __func__);
+  typedef delayed_init<std::vector<int>, recyclable> D;
+  D d;
+  d.init(1000, 1);
+  const int* data = d->data();
+  const std::size_t capacity = d->capacity();
+
+  d.recycle();
+  assert(!d && d.get() == nullptr);
+  d.init();
+  assert(d->empty() && d->capacity() == capacity && d->data() == data);
+
+  // Assignment from an uninitialised object recycles.
+  d = D();
+  assert(!d);
+  const D small(std::vector<int>(10, 2));
+  d = small;
+  assert(d->size() == 10 && d->data() == data);
+  d.recycle();
+  d.init(*small);
+  assert(d->size() == 10 && d->data() == data);
+
+  // Initialisation from other arguments rebuilds.
+  d.recycle();
+  d.init(3, 7);
+  assert((*d == std::vector<int>{7, 7, 7}));
+
+  delayed_init<std::string, recyclable> s;
+  s.init(64, 'x');
+  const char* chars = s->data();
+  s.recycle();
+  s.init("short");
+  assert(*s == "short" && s->data() == chars);
+
+  // Other storages destroy.
+  delayed_init<helper> h(1);
+  helper::mark_call_stack();
+  h.recycle();
+  helper::check_call_stack({helper::destructor});
+  assert(!h);
+}
+
+void test_recycle_lifetime(int line) {
+  where(line, __func__);
+  typedef delayed_init<reusable, recyclable> D;
+  {
+    D d;
+    d.init(1, 2);
+    assert(reusable::n_built == 1 && d->value == 3);
+    d.recycle();
+    assert(reusable::n_cleared == 1 && reusable::n_destroyed == 0);
+    d.init();
+    assert(reusable::n_built == 1 && d->value == 0);
+    d.recycle();
+    d.init(reusable(2, 3));
+    assert(reusable::n_built == 2 && d->value == 5);
+    assert(reusable::n_destroyed == 1);
+
+    // Copies and moves build (recycled objects are not copied).
+    D e(d);
+    assert(reusable::n_built == 3 && e->value == 5);
+    d.recycle();
+    D f(d);
+    assert(!f && reusable::n_built == 3);
+
+    // Factories and emplace() rebuild.
+    int n_destroyed = reusable::n_destroyed;
+    d.init_with([] { return reusable(4, 4); });
+    assert(reusable::n_destroyed > n_destroyed && d->value == 8);
+    n_destroyed = reusable::n_destroyed;
+    e.emplace(1, 1);
+    assert(reusable::n_cleared == 4);
+    assert(reusable::n_destroyed == n_destroyed + 1 && e->value == 2);
+    e.recycle();
+  }
+  // Both live and recycled objects are destroyed.
+  assert(reusable::n_destroyed == reusable::n_built);
+}
+
+//------------------------------------------------------------------------------
+// Fast shutdown.
+//------------------------------------------------------------------------------
+
+// Object whose destructor only frees memory.
+struct cache_entry {
+  static int n_destroyed;
+  ~cache_entry() noexcept {
+    ++n_destroyed;
+  }
+};
+
+int cache_entry::n_destroyed = 0;
+
+namespace overload {
+namespace traits {
+
+template <>
+struct is_leakable_at_exit<cache_entry> : public std::true_type {
+};
+
+} // namespace traits
+} // namespace overload
+
+//------------------------------------------------------------------------------
+// test_shutdown()
+//------------------------------------------------------------------------------
+
+// Must be the last test.
+void test_shutdown(int line) {
+  where(line, __func__);
+  {
+    delayed_init<cache_entry> d;
+    d.init();
+  }
+  assert(cache_entry::n_destroyed == 1);
+
+  overload::delayed_init_shutdown();
+  {
+    delayed_init<cache_entry> d;
+    d.init();
+    // Only destructors leak.
+    d.emplace();
+    assert(cache_entry::n_destroyed == 2);
+    delayed_init<const cache_entry> c;
+    c.init();
+    helper::mark_call_stack();
+    delayed_init<helper> h(1);
+  }
+  assert(cache_entry::n_destroyed == 2);
+  helper::check_call_stack({helper::destructor, helper::constructor});
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+  
+  /***
+   * Test default-constructor.
+   */
+
+  test_default_constructor(__LINE__);
+
+  /***
+   * Create non-const/const helpers.
+   */
+   
+  helper h;
+  const helper ch;
+  
+  /***
+   * Test constructor from helper.
+   */
+
+  // lvalue.
+  test_constructor<helper>(__LINE__, h, true, {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, h, true,
+    {helper::copy_constructor});
+
+  // const lvalue.
+  test_constructor<helper>(__LINE__, ch, true, {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, ch, true,
+    {helper::copy_constructor});
+
+  // rvalue.
+  test_constructor<helper>(__LINE__, std::move(h), true,
+    {helper::move_constructor});
+  test_constructor<const helper>(__LINE__, std::move(h), true,
+    {helper::move_constructor});
+
+  // const rvalue.
+  test_constructor<helper>(__LINE__, std::move(ch), true,
+    {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, std::move(ch), true,
+    {helper::copy_constructor});
+
+  /***
+   * Create default/non-default initialised delayed_init non-const/const.
+   */
+   
+  delayed_init<helper> d0;
+  delayed_init<const helper> cd0;
+  delayed_init<helper> d1(helper(1));
+  delayed_init<const helper> cd1(helper(1));
+    
+  /***
+   * Test constructor from delayed_init.
+   */
+
+  // uninitialised lvalue.
+  test_constructor<helper>(__LINE__, d0, false, {});
+  test_constructor<const helper>(__LINE__, d0, false, {});
+  
+  // uninitialised const lvalue.
+  test_constructor<helper>(__LINE__, cd0, false, {});
+  test_constructor<const helper>(__LINE__, cd0, false, {});
+  
+  // initialised lvalue.
+  test_constructor<helper>(__LINE__, d1, true, {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, d1, true,
+    {helper::copy_constructor});
+
+  // initialised const lvalue.
+  test_constructor<helper>(__LINE__, cd1, true, {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, cd1, true,
+    {helper::copy_constructor});
+
+  // uninitialised rvalue.
+  test_constructor<helper>(__LINE__, std::move(d0), false, {});
+  test_constructor<const helper>(__LINE__, std::move(d0), false, {});
+  
+  // uninitialised const rvalue.
+  test_constructor<helper>(__LINE__, std::move(cd0), false, {});
+  test_constructor<const helper>(__LINE__, std::move(cd0), false, {});
+  
+  // initialised rvalue.
+  test_constructor<helper>(__LINE__, std::move(d1), true,
+    {helper::move_constructor});
+  test_constructor<const helper>(__LINE__, std::move(d1), true,
+    {helper::move_constructor});
+
+  // initialised const rvalue.
+  test_constructor<helper>(__LINE__, std::move(cd1), true,
+    {helper::copy_constructor});
+  test_constructor<const helper>(__LINE__, std::move(cd1), true,
+    {helper::copy_constructor});
+
+  /**
+   * Test destructor.
+   */
+   
+  // uninitialised.
+  test_destructor(__LINE__, d0, {});
+  
+  // initialised.
+  test_destructor(__LINE__, d1, {helper::destructor});
+
+  /***
+   * Test assignment from helper.
+   */
+   
+  // lvalue -> uninitialised.
+  test_assignment(__LINE__, h, d0, true, {helper::copy_constructor});
+  
+  // lvalue -> initialised.
+  test_assignment(__LINE__, h, d1, true, {helper::copy_assignment});
+  
+  // const lvalue -> uninitialised.
+  test_assignment(__LINE__, ch, d0, true, {helper::copy_constructor});
+  
+  // const lvalue -> initialised.
+  test_assignment(__LINE__, ch, d1, true, {helper::copy_assignment});
+
+  // rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(h), d0, true,
+    {helper::move_constructor});
+  
+  // rvalue -> initialised.
+  test_assignment(__LINE__, std::move(h), d1, true,
+    {helper::move_assignment});
+
+  // const rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(ch), d0, true,
+    {helper::copy_constructor});
+
+  // const rvalue -> initialised.
+  test_assignment(__LINE__, std::move(ch), d1, true,
+    {helper::copy_assignment});
+
+  /***
+   * Test assignment from uninitialised delayed_init.
+   */
+   
+  // lvalue -> uninitialised.
+  test_assignment(__LINE__, d0, d0, false, {});
+  
+  // lvalue -> initialised.
+  test_assignment(__LINE__, d0, d1, false, {helper::destructor});
+  
+  // const lvalue -> uninitialised.
+  test_assignment(__LINE__, cd0, d0, false, {});
+
+  // const lvalue -> initialised.
+  test_assignment(__LINE__, cd0, d1, false, {helper::destructor});
+
+  // rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(d0), d0, false, {});
+
+  // rvalue -> initialised.
+  test_assignment(__LINE__, std::move(d0), d1, false, {helper::destructor});
+
+  // const rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(cd0), d0, false, {});
+
+  // const rvalue -> initialised.
+  test_assignment(__LINE__, std::move(cd0), d1, false,
+    {helper::destructor});
+
+  /***
+   * Test assignment from initialised delayed_init.
+   */
+   
+  // lvalue -> uninitialised.
+  test_assignment(__LINE__, d1, d0, true, {helper::copy_constructor});
+  
+  // lvalue -> initialised.
+  test_assignment(__LINE__, d1, d1, true, {helper::copy_assignment});
+  
+  // const lvalue -> uninitialised.
+  test_assignment(__LINE__, cd1, d0, true, {helper::copy_constructor});
+
+  // const lvalue -> initialised.
+  test_assignment(__LINE__, cd1, d1, true, {helper::copy_assignment});
+
+  // rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(d1), d0, true,
+    {helper::move_constructor});
+
+  // rvalue -> initialised.
+  test_assignment(__LINE__, std::move(d1), d1, true,
+    {helper::move_assignment});
+
+  // const rvalue -> uninitialised.
+  test_assignment(__LINE__, std::move(cd1), d0, true,
+    {helper::copy_constructor});
+
+  // const rvalue -> initialised.
+  test_assignment(__LINE__, std::move(cd1), d1, true,
+    {helper::copy_assignment});
+  
+  /***
+   * Test indirection for uninitialised delayed_init.
+   */
+
+  test_indirection_uninitialised<delayed_init<helper>>(__LINE__);
+  test_indirection_uninitialised<delayed_init<const helper>>(__LINE__);
+  
+  /***
+   * Test indirection for initialised delayed_init.
+   */
+
+  test_indirection_initialised<delayed_init<helper>>(__LINE__,
+    {helper::non_const_get});
+  test_indirection_initialised<delayed_init<const helper>>(__LINE__,
+    {helper::const_get});
+
+  /**
+   * Test getter from uninitialised delayed_init.
+   */
+
+  // non-const.
+  test_getter<delayed_init<helper>>(__LINE__, d0, false, false);
+
+  // const.
+  test_getter<const delayed_init<helper>>(__LINE__, d0, true, false);
+  test_getter<delayed_init<const helper>>(__LINE__, d0, true, false);
+  test_getter<const delayed_init<const helper>>(__LINE__, d0, true, false);
+
+  /**
+   * Test getter from initialised delayed_init.
+   */
+
+  // non-const.
+  test_getter<delayed_init<helper>>(__LINE__, d1, false, true);
+
+  // const.
+  test_getter<delayed_init<const helper>>(__LINE__, d1, true, true);
+  test_getter<const delayed_init<helper>>(__LINE__, d1, true, true);
+  test_getter<const delayed_init<const helper>>(__LINE__, d1, true, true);
+
+  /***
+   * Test dereference.
+   */
+   
+  // non-const.
+  test_dereference<delayed_init<helper>>(__LINE__, {helper::non_const_get});
+
+  // const.
+  test_dereference<delayed_init<const helper>>(__LINE__,
+    {helper::const_get});
+  test_dereference<const delayed_init<helper>>(__LINE__,
+    {helper::const_get});
+  test_dereference<const delayed_init<const helper>>(__LINE__,
+    {helper::const_get});
+
+  /***
+   * Test conversion to bool.
+   */
+    
+  // uninitialised.
+  test_conversion_to_bool(__LINE__, d0, false);
+  
+  // initialised.
+  test_conversion_to_bool(__LINE__, d1, true);
+  
+  /***
+   * Test initialiser.
+   */
+  
+  // lvalue -> uninitialised.
+  test_init_uninitialised(__LINE__, {helper::constructor}, 1);
+  test_init_uninitialised(__LINE__, {helper::copy_constructor}, h);
+  test_init_uninitialised(__LINE__, {helper::copy_constructor}, ch);
+  
+  // rvalue -> uninitialised.
+  test_init_uninitialised(__LINE__, {helper::constructor}, std::move(1));
+  test_init_uninitialised(__LINE__, {helper::move_constructor},
+    std::move(h));
+  test_init_uninitialised(__LINE__, {helper::copy_constructor},
+    std::move(ch));
+ 
+  // initialised.
+  test_init_initialised(__LINE__);
+
+  /***
+   * Test initialiser from factory.
+   */
+
+  test_init_with(__LINE__);
+#if __cplusplus >= 201703L
+  test_init_with_non_movable(__LINE__);
+#endif
+
+  /***
+   * Test emplace.
+   */
+
+  // uninitialised.
+  test_emplace(__LINE__, d0, {helper::constructor});
+
+  // initialised.
+  test_emplace(__LINE__, d1, {helper::constructor, helper::destructor});
+ 
+  /***
+   * Test swap member.
+   */
+
+  // uninitialised <-> uninitialised.
+  {
+    delayed_init<helper> d1, d2;
+    test_swap_member(__LINE__, d1, d2, {});
+  }
+
+  // initialised <-> uninitialised.
+  {
+    delayed_init<helper> d1(h), d2;
+    test_swap_member(__LINE__, d1, d2,
+      {helper::destructor, helper::move_constructor});
+  }
+  
+  // initialised <-> uninitialised.
+  {
+    delayed_init<helper> d1, d2(h);
+    test_swap_member(__LINE__, d1, d2,
+      {helper::destructor, helper::move_constructor});
+  }
+
+  // initialised <-> initialised.
+  {
+    delayed_init<helper> d1(h), d2(h);
+    test_swap_member(__LINE__, d1, d2,
+      {helper::swap_member, helper::swap_non_member});
+  }
+  
+  /***
+   * Test swap non member.
+   */
+
+  // uninitialised <-> uninitialised.
+  {
+    delayed_init<helper> d1, d2;
+    test_swap_non_member(__LINE__, d1, d2, {});
+  }
+
+  // initialised <-> uninitialised.
+  {
+    delayed_init<helper> d1(h), d2;
+    test_swap_non_member(__LINE__, d1, d2,
+      {helper::destructor, helper::move_constructor});
+  }
+  
+  // initialised <-> uninitialised.
+  {
+    delayed_init<helper> d1, d2(h);
+    test_swap_non_member(__LINE__, d1, d2,
+      {helper::destructor, helper::move_constructor});
+  }
+
+  // initialised <-> initialised.
+  {
+    delayed_init<helper> d1(h), d2(h);
+    test_swap_non_member(__LINE__, d1, d2,
+      {helper::swap_member, helper::swap_non_member});
+  }
+
+  /***
+   * Test unchecked access and checking policies.
+   */
+
+  test_unchecked<delayed_init<helper>>(__LINE__,
+    {helper::non_const_get, helper::non_const_get, helper::constructor});
+  test_unchecked<delayed_init<const helper>>(__LINE__,
+    {helper::const_get, helper::const_get, helper::constructor});
+  test_unchecked<delayed_init<helper, flag, check::none>>(__LINE__,
+    {helper::non_const_get, helper::non_const_get, helper::constructor});
+  test_unchecked<delayed_init<helper, flag, check::assertion>>(__LINE__,
+    {helper::non_const_get, helper::non_const_get, helper::constructor});
+  test_unchecked<delayed_init<helper, flag, check::terminate>>(__LINE__,
+    {helper::non_const_get, helper::non_const_get, helper::constructor});
+#if defined(__unix__) || defined(__APPLE__)
+  test_check_aborts<check::assertion>(__LINE__);
+  test_check_aborts<check::terminate>(__LINE__);
+#endif
+
+  /***
+   * Test trivial copy.
+   */
+
+  // uninitialised.
+  test_trivial_copy(__LINE__, delayed_init<int>());
+
+  // initialised.
+  test_trivial_copy(__LINE__, delayed_init<int>(1));
+
+  /***
+   * Test niche storage.
+   */
+
+  test_niche(__LINE__, 1.0);
+  test_niche(__LINE__, 1.0f);
+  test_niche(__LINE__, &h);
+  test_niche(__LINE__, file_descriptor{0});
+  test_niche_sentinel(__LINE__, 1.0);
+  test_niche_sentinel(__LINE__, &h);
+  test_niche_sentinel(__LINE__, file_descriptor{0});
+
+  /***
+   * Test out-of-line storage.
+   */
+
+  test_out_of_line(__LINE__);
+#if defined(__cpp_lib_memory_resource)
+  test_out_of_line_pmr(__LINE__);
+#endif
+
+  /***
+   * Test relocation.
+   */
+
+  test_relocate_to(__LINE__);
+  test_relocate_range<delayed_init<helper>>(__LINE__, {helper::destructor,
+    helper::move_constructor, helper::destructor, helper::move_constructor});
+  test_relocate_range<delayed_init<helper, out_of_line<>>>(__LINE__, {});
+
+  /***
+   * Test construction in place.
+   */
+
+  test_construct_in(__LINE__);
+  test_construct_in_rollback<delayed_init<record>>(__LINE__);
+  test_construct_in_rollback<delayed_init<double, niche>>(__LINE__);
+  test_construct_in_out_of_line(__LINE__);
+  test_init_from_bytes<delayed_init<record>>(__LINE__);
+  test_init_from_bytes<delayed_init<record, out_of_line<>>>(__LINE__);
+
+  /***
+   * Test accessors and transformations.
+   */
+
+  test_value_or(__LINE__);
+  test_transform_in_place(__LINE__);
+  test_transform(__LINE__);
+  test_and_then(__LINE__);
+  test_take(__LINE__);
+
+  /***
+   * Test comparisons and hashing.
+   */
+
+  test_comparison<int>(__LINE__, -1, 1);
+  test_comparison<double>(__LINE__, 0.0, 0.5);
+  test_comparison<std::string>(__LINE__, "delayed", "init");
+  test_comparison_mixed(__LINE__);
+  test_hash<int>(__LINE__, 1);
+  test_hash<double>(__LINE__, 0.5);
+  test_hash<std::string>(__LINE__, "init");
+
+  /***
+   * Test layout policies.
+   */
+
+  test_flag_after(__LINE__);
+  test_aligned<delayed_init<helper, aligned<>>>(__LINE__);
+  test_aligned<delayed_init<helper, aligned<flag_after>>>(__LINE__);
+  test_aligned<delayed_init<helper, aligned<out_of_line<>>>>(__LINE__);
+  test_relocate_range<delayed_init<helper, flag_after>>(__LINE__, {
+    helper::destructor, helper::move_constructor, helper::destructor,
+    helper::move_constructor});
+
+  /***
+   * Test that std::vector moves unless the move might throw.
+   */
+
+  test_copy_not_hijacked(__LINE__);
+  test_vector_growth<counted_copy>(__LINE__, false);
+  test_vector_growth<throwing_move>(__LINE__, true);
+
+  /***
+   * Test references.
+   */
+
+  test_reference(__LINE__);
+
+  /***
+   * Test recycling.
+   */
+
+  test_recycle(__LINE__);
+  test_recycle_lifetime(__LINE__);
+
+  /***
+   * Test fast shutdown (must be the last test).
+   */
+
+  test_shutdown(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
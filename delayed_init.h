@@ -1,499 +1,3472 @@
-/*******************************************************************************
- * This is free and unencumbered software released into the public domain.
- *
- * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
- * this software, either in source code form or as a compiled binary, for any
- * purpose, commercial or non-commercial, and by any means.
- *
- * In jurisdictions that recognize copyright laws, the author or authors of this
- * software dedicate any and all copyright interest in the software to the
- * public domain. We make this dedication for the benefit of the public at large
- * and to the detriment of our heirs and successors. We intend this dedication
- * to be an overt act of relinquishment in perpetuity of all present and future
- * rights to this software under copyright law.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
- * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
- * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- * 
- * For more information, please refer to <http://unlicense.org/>
- *
- * If you use this software in a product, an acknowledgment in the product
- * documentation would be appreciated but is not required.
- *
- * by Cassio Neri
- ******************************************************************************/
-
- /**
-  * @file delayed_init.h
-  * @brief Definition of class delayed_init.
-  */
-
-#ifndef OVERLOAD_DELAYED_INIT_H_
-#define OVERLOAD_DELAYED_INIT_H_
-
-#include <stdexcept>
-#include <type_traits>
-#include <utility>
-
-namespace overload {
-namespace traits {
-
-using std::swap;
-
-/**
- * @brief Detects if two types are no-throw swappable.
- *
- * More precisely, is_nothrow_swappable<T, U> publicly derives from
- * std::false_type unless a (unqualified) call to swap(T&, U&) is marked as no
- * throw.
- * 
- * @tparam T First type.
- * @tparam U Second type.
- */ 
-template <typename T, typename U = T, typename = void>
-struct is_nothrow_swappable : public std::false_type {
-};
-
-template <typename T, typename U>
-struct is_nothrow_swappable<T, U, typename std::enable_if<noexcept(
-  swap(std::declval<T&>(),std::declval<U&>()))>::type> : public std::true_type {
-};
-
-} // namespace traits
-
-/**
- * @brief Prevents default-initialisation.
- *
- * Class delay_init<T> holds an object of type T whose initialisation is delayed
- * until init() is called.
- *
- * The compiler tries hard to initialise every non-static data member of a class
- * before execution reachs the constructor body. If delaying the initialisation
- * of a non-static data member of type T to a later time is needed, then declare
- * the member as a delayed_init<T> rather than a T.
- *
- * The type T must not be a reference type.
- * 
- * Reference:
- * Cassio Neri, "Complex logic in the member initialiser list", Overload 112,
- * ACCU, (2012).
- * http://accu.org/var/uploads/journals/Overload112.pdf
- */
-template <typename T>
-class delayed_init {
-
-public:
-  
-  static_assert(!std::is_reference<T>::value, "instantiation of delayed_init "
-    "for reference type");
-
-  /**
-   * @brief Default constructor.
-   *
-   * @post static_cast<bool>(*this) == false && get() == nullptr.
-   * @throw - Nothing.
-   */
-  constexpr delayed_init() noexcept {
-  }
-
-  /**
-   * @brief Copy-constructor.
-   *
-   * If static_cast<bool>(src) == true, then *get() is copy-constructed from
-   * *src.get().
-   *
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Initialiser.
-   * @throw - Whatever T::T(const T&) throws.
-   */
-  delayed_init(const delayed_init& src)
-    noexcept(std::is_nothrow_copy_constructible<T>::value) {
-    init_me(static_cast<bool>(src), *src.get());
-  }
-
-  /**
-   * @brief Copy-constructor from delayed_init<U>.
-   *
-   * If static_cast<bool>(src) == true, then *get() is copy-constructed from
-   * *src.get().
-   * 
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Initialiser.
-   * @throw - Whatever T::T(const U&) throws.
-   */
-  template <typename U>
-  delayed_init(const delayed_init<U>& src)
-    noexcept(std::is_nothrow_constructible<T, const U&>::value) {
-    init_me(static_cast<bool>(src), *src.get());
-  }
-
-  /**
-   * @brief Move-constructor from delayed_init<U>.
-   *
-   * If static_cast<bool>(src) == true, then *get() is copy- or move-constructed
-   * from *src.get().
-   * 
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Initialiser.
-   * @throw - Whatever T::T(U&&) throw.
-   */
-  template <typename U>
-  delayed_init(delayed_init<U>&& src)
-    noexcept(std::is_nothrow_constructible<T, U&&>::value) {
-    init_me(static_cast<bool>(src), std::move(*src.get()));
-  }
-  
-  /**
-   * @brief Constructor from U.
-   *
-   * *get() is copy- or move-constructed from obj.
-   *
-   * @post static_cast<bool>(*this) == true && get() != nullptr.
-   * @param obj Initialiser.
-   * @throw - Whatever T::T(U&&) throw.
-   */
-  template <typename U, typename = typename
-    std::enable_if<std::is_constructible<T, U&&>::value>::type>
-  explicit delayed_init(U&& obj)
-    noexcept(std::is_nothrow_constructible<T, U&&>::value) {
-    init_obj(std::forward<U>(obj));
-  }
-
-  /**
-   * @brief Destructor.
-   *
-   * T:~T() must not throw.
-   *
-   * @throw - Nothing.
-   */
-  ~delayed_init() noexcept {
-    destroy();
-  }
-
-  /**
-   * @brief Copy-assignment.
-   *
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
-   * then *get() is copy-assigned to *src.get().
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
-   * then *get() is destroyed.
-   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
-   * then *get() is copy-constructed from *src.get().
-   *
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Assignment source.
-   * @return *this.
-   * @throw - Whatever T::T(const T&) and T::operator=(const T&) throw.
-   */
-  delayed_init& operator=(const delayed_init& src)
-    noexcept(
-      std::is_nothrow_copy_constructible<T>::value &&
-      std::is_nothrow_copy_assignable<T>::value
-    ) {
-    assign(static_cast<bool>(src), *src.get());
-    return *this;
-  }
-  
-  /**
-   * @brief Copy-assignment to delayed_init<U>.
-   *
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
-   * then *get() is copy-assigned to *src.get().
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
-   * then *get() is destroyed.
-   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
-   * then *get() is copy-constructed from *src.get().
-   *
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Assignment source.
-   * @return *this.
-   * @throw - Whatever T::T(const U&) and T::operator=(const U&) throw.
-   */
-  template <typename U>
-  delayed_init& operator=(const delayed_init<U>& src)
-    noexcept(
-      std::is_nothrow_constructible<T, const U&>::value &&
-      std::is_nothrow_assignable<T, const U&>::value
-    ) {
-    assign(static_cast<bool>(src), *src.get());
-    return *this;
-  }
-
-  /**
-   * @brief Move-assignment to delayed_init<U>.
-   *
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
-   * then *get() is copy- or move-assigned to *src.get().
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
-   * then *get() is destroyed.
-   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
-   * then *get() is copy- or move-constructed from *src.get().
-   *
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param src Assignment source.
-   * @return *this.
-   * @throw - Whatever T::T(U&&) and T::operator=(U&&) throw.
-   */
-  template <typename U>
-  delayed_init& operator=(delayed_init<U>&& src)
-    noexcept(
-      std::is_nothrow_constructible<T, U&&>::value &&
-      std::is_nothrow_assignable<T, U&&>::value
-    ) {
-    assign(static_cast<bool>(src), std::move(*src.get()));
-    return *this;
-  }
-
-  /**
-   * @brief Assignment to U.
-   *
-   * If static_cast<bool>(*this) == true, then *get() is copy- or move-assigned
-   * to obj. Othwerwise, *get() is copy- or move-constructed from obj.
-   *
-   * @pre std::is_convertible<U, T>::value == true.
-   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
-   * (get() == nullptr) == (src.get() == nullptr).
-   * @param obj Assignment source.
-   * @return *this.
-   * @throw - Whatever T::T(U&&) and T::operator=(U&&) throw.
-   */
-  template <typename U, typename = typename
-    std::enable_if<std::is_convertible<U, T>::value>::type>
-  delayed_init& operator=(U&& obj)
-    noexcept(
-      std::is_nothrow_constructible<T, U&&>::value &&
-      std::is_nothrow_assignable<T, U&&>::value
-    ) {
-    assign(true, std::forward<U>(obj_));
-    return *this;
-  }
-  
-  /**
-   * @brief Indirection.
-   *
-   * @pre static_cast<bool>(*this) == true.
-   * @return *get().
-   * @throw std::logic_error If pre-condition doesn't hold.
-   */
-  T& operator*() {
-    if (is_init_)
-      return obj_;
-    throw std::logic_error("attempt to use uninitialised object");
-  } 
-
-  /**
-   * @brief Indirection (const).
-   *
-   * @pre static_cast<bool>(*this) == true.
-   * @return *get().
-   * @throw std::logic_error If pre-condition doesn't hold.
-   */
-  const T& operator*() const {
-    return *const_cast<delayed_init*>(this);
-  } 
-
-  /**
-   * @brief Getter.
-   *
-   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
-   * Otherwise, nullptr.
-   * @throw - Nothing.
-   */
-  T* get() noexcept {
-    return is_init_ ? &obj_ : nullptr;
-  }
-  
-  /**
-   * @brief Getter (const).
-   *
-   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
-   * Otherwise nullptr.
-   * @throw - Nothing.
-   */
-  const T* get() const noexcept {
-    return is_init_ ? &obj_ : nullptr;
-  }
-  
-  /**
-   * @brief Deference.
-   *
-   * @return get().
-   * @throw - Nothing.
-   */
-  T* operator->() noexcept {
-    return get();
-  }
-
-  /**
-   * @brief Deference (const).
-   *
-   * @return get().
-   * @throw - Nothing.
-   */
-  const T* operator->() const noexcept {
-    return get();
-  }
-
-  /**
-   * @brief Conversion to bool.
-   *
-   * @return false if the inner object was not initialised. Otherwise, true.
-   * @throw - Nothing.
-   */
-  explicit operator bool() const noexcept {
-    return is_init_;
-  }
-
-  /**
-   * @brief Initialiser.
-   *
-   * Builds inner object by forwarding arguments to T's constructor.
-   *
-   * @pre static_cast<bool>(*this) == false.
-   * @post static_cast<bool>(*this) == true && get() != nullptr.
-   * @param args Initialisation arguments.
-   * @throw - std::logic_error (if pre condition doesn't hold) and whatever
-   * T::T(Args&&...) throws.
-   */
-  template <typename... Args>
-  void init(Args&&... args) {
-    if (is_init_)
-      throw std::logic_error("second attempt to initialise object");
-    init_obj(std::forward<Args>(args)...);
-  }
-  
-  /**
-   * @brief Swap.
-   *
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
-   * then *get() and *src.get() are swapped.
-   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
-   * then *get() is copied or moved to src.get() and then destroyed.
-   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
-   * then *src.get() is copied or moved to *get() and destroyed.
-   *
-   * @param src Source.
-   * @throw - Whatever T::(const T&), T::(T&&) and swap(T&, T&) throw.
-   */
-  void swap(delayed_init& src)
-    noexcept(
-      std::is_nothrow_copy_constructible<T>::value &&
-      std::is_nothrow_move_constructible<T>::value &&
-      traits::is_nothrow_swappable<T>::value
-    ) {
-    if (is_init_) {
-      if (src.is_init_) {
-        
-        using std::swap;
-        swap(obj_, src.obj_);
-      }
-      else {
-        src.init_obj(std::move(obj_));
-        destroy();
-      }
-    }
-    else if (src.is_init_) {
-      init_obj(std::move(src.obj_));
-      src.destroy();
-    }
-  }
-
-private:
-
-  bool is_init_ = false;
-  union {
-    T obj_;
-  };
-
-  /**
-   * @brief Initialise inner object.
-   *
-   * @pre static_cast<bool>(*this) == false.
-   * @post static_cast<bool>(*this) == true && get() != nullptr.
-   * @param args Initialisation arguments.
-   * @throw - Whatever T::T(Args&&...) throws.
-   */
-  template <typename... Args>
-  void init_obj(Args&&... args) {
-    new ((void *) &obj_) T(std::forward<Args>(args)...);
-    is_init_ = true;
-  }
-  
-  /**
-   * @brief Initialise *this (from another delayed_init members).
-   *
-   * @pre static_cast<bool>(*this) == false.
-   * @post static_cast<bool>(*this) == src_is_init &&
-   * (get() != nullptr) == src_is_init.
-   * @param src_is_init The source's is_init_ member.
-   * @param src_obj The source's obj_ member.
-   * @throw - Whatever init_obj(U&&) throws.
-   */
-  template <typename U>
-  void init_me(bool src_is_init, U&& src_obj) {
-    if (src_is_init)
-      init_obj(std::forward<U>(src_obj));
-  }
-  
-  /**
-   * @brief assign *this (from another delayed_init members).
-   *
-   * @post static_cast<bool>(*this) == src_is_init &&
-   * (get() != nullptr) == src_is_init.
-   * @param src_is_init The source's is_init_ member.
-   * @param src_obj The source's obj_ member.
-   * @throw - Whatever init_me(bool, U&&) and T::operator =(U&&) throw.
-   */
-  template <typename U>
-  void assign(bool src_is_init, U&& src_obj) {
-    if (!is_init_)
-      init_me(src_is_init, std::forward<U>(src_obj));
-    else if (src_is_init)
-      obj_ = std::forward<U>(src_obj);
-    else
-      destroy();
-  }
-
-  /**
-   * @brief Destroy inner object.
-   *
-   * T:~T() must not throw.
-   *
-   * @post static_cast<bool>(*this) == false && get() == nullptr
-   * @throw - Nothing.
-   */
-  void destroy() noexcept {
-    if (is_init_)
-      (&obj_)->~T();
-    is_init_ = false;
-  }
-
-}; // class delayed_init
-
-/**
- * @brief Swap two delayed_init objects.
- *
- * @param d1 1st delayed_init object.
- * @param d2 2nd delayed_init object.
- *
- * @throw - Whatever T::swap(T&) throws.
- */
-template <typename T>
-void swap(delayed_init<T>& d1, delayed_init<T>& d2)
-  noexcept(noexcept(std::declval<T&>().swap(std::declval<T&>()))) {
-  d1.swap(d2);
-}
-
-} // namespace overload
-
-#endif // OVERLOAD_DELAYED_INIT_H_
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init.h
+  * @brief Definition of class delayed_init.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_H_
+#define OVERLOAD_DELAYED_INIT_H_
+
+/**
+ * @brief Lean configuration.
+ *
+ * Define this macro before including this header to avoid the heavier
+ * standard headers (e.g. <atomic>, <functional>, <stdexcept> and
+ * <memory_resource>). In this configuration, check::exception,
+ * storage::pmr_default_resource, storage::pmr_resource, std::hash<delayed_init>
+ * and delayed_init_shutdown() are not available and the default checking
+ * policy is check::terminate. This macro is defined when exceptions are
+ * disabled (e.g. by -fno-exceptions).
+ */
+#if !defined(OVERLOAD_DELAYED_INIT_LEAN) && \
+  ((defined(__GNUC__) && !defined(__EXCEPTIONS)) || \
+  (defined(_MSC_VER) && !defined(_CPPUNWIND)))
+#define OVERLOAD_DELAYED_INIT_LEAN
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+#endif // OVERLOAD_DELAYED_INIT_LEAN
+
+#if __cplusplus >= 202002L
+#include <memory>
+#endif
+
+/**
+ * @brief Tells the optimiser that cond holds.
+ *
+ * If cond doesn't hold, then the behaviour is undefined.
+ */
+#if defined(__GNUC__)
+#define OVERLOAD_DELAYED_INIT_ASSUME(cond) \
+  ((cond) ? static_cast<void>(0) : __builtin_unreachable())
+#elif defined(_MSC_VER)
+#define OVERLOAD_DELAYED_INIT_ASSUME(cond) __assume(cond)
+#else
+#define OVERLOAD_DELAYED_INIT_ASSUME(cond) static_cast<void>(0)
+#endif
+
+/**
+ * @brief Whether delayed_init can be used in constant expressions.
+ *
+ * Set to 1 when the compiler and library support constexpr destructors and
+ * std::construct_at (C++20). In this case, most members of delayed_init are
+ * constexpr and, for instance, constexpr or constinit delayed_init objects
+ * are constant-initialised. Otherwise, set to 0.
+ */
+#if defined(__cpp_constexpr_dynamic_alloc) && \
+  defined(__cpp_lib_constexpr_dynamic_alloc)
+#define OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR 1
+#define OVERLOAD_DELAYED_INIT_CONSTEXPR constexpr
+#else
+#define OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR 0
+#define OVERLOAD_DELAYED_INIT_CONSTEXPR
+#endif
+
+/**
+ * @brief Size of cache lines assumed to prevent false sharing.
+ *
+ * Defaults to 64 (128 on Apple's aarch64). Define this macro before including
+ * this header to change it. std::hardware_destructive_interference_size is not
+ * used since its value depends on compiler flags (e.g. -mtune) and, hence,
+ * might change the layout of classes across translation units.
+ */
+#ifndef OVERLOAD_DELAYED_INIT_CACHE_LINE
+#if defined(__APPLE__) && defined(__aarch64__)
+#define OVERLOAD_DELAYED_INIT_CACHE_LINE 128
+#else
+#define OVERLOAD_DELAYED_INIT_CACHE_LINE 64
+#endif
+#endif
+
+/**
+ * @brief Default instrumentation policy of delayed_init.
+ *
+ * Define this macro before including this header to change the instrumentation
+ * policy used by default (e.g. overload::instrument::counters<> from
+ * delayed_init_counters.h).
+ */
+#ifndef OVERLOAD_DELAYED_INIT_INSTRUMENT
+#define OVERLOAD_DELAYED_INIT_INSTRUMENT ::overload::instrument::none
+#endif
+
+/**
+ * @brief Default checking policy of delayed_init.
+ *
+ * Define this macro before including this header to change the checking policy
+ * used by default (e.g. overload::check::assertion for release builds).
+ */
+#ifndef OVERLOAD_DELAYED_INIT_CHECK
+#ifdef OVERLOAD_DELAYED_INIT_LEAN
+#define OVERLOAD_DELAYED_INIT_CHECK ::overload::check::terminate
+#else
+#define OVERLOAD_DELAYED_INIT_CHECK ::overload::check::exception
+#endif
+#endif
+
+namespace overload {
+namespace traits {
+
+using std::swap;
+
+/**
+ * @brief Detects if two types are no-throw swappable.
+ *
+ * More precisely, is_nothrow_swappable<T, U> publicly derives from
+ * std::false_type unless a (unqualified) call to swap(T&, U&) is marked as no
+ * throw.
+ * 
+ * @tparam T First type.
+ * @tparam U Second type.
+ */ 
+template <typename T, typename U = T, typename = void>
+struct is_nothrow_swappable : public std::false_type {
+};
+
+template <typename T, typename U>
+struct is_nothrow_swappable<T, U, typename std::enable_if<noexcept(
+  swap(std::declval<T&>(),std::declval<U&>()))>::type> : public std::true_type {
+};
+
+/**
+ * @brief Detects if a type is trivially relocatable.
+ *
+ * An object of a trivially relocatable type can be moved to new memory by
+ * copying its bytes and then forgetting the original (without calling its
+ * destructor). This is equivalent to a move-construction followed by the
+ * destruction of the source.
+ *
+ * By default, only trivially copyable types are considered trivially
+ * relocatable. Other types T (e.g. std::unique_ptr) opt in by specialising
+ * this template. Beware that some types are not: e.g. libstdc++'s std::string
+ * holds a pointer to its own internal buffer.
+ *
+ * @tparam T Type.
+ */
+template <typename T>
+struct is_trivially_relocatable : public std::is_trivially_copyable<T> {
+};
+
+/**
+ * @brief Detects if a type can be leaked at exit.
+ *
+ * After delayed_init_shutdown() is called, the destructor of delayed_init<T>
+ * doesn't destroy the inner object when is_leakable_at_exit<T>::value == true.
+ * This suits types whose destructors only release what the operating system
+ * reclaims anyway (e.g. memory) and saves the cost of tearing down many such
+ * objects when the process is about to exit.
+ *
+ * By default, no type is leakable. Types T opt in by specialising this
+ * template. (Trivially destructible types gain nothing.) This trait is
+ * ignored in the lean configuration (see OVERLOAD_DELAYED_INIT_LEAN).
+ *
+ * @tparam T Type.
+ */
+template <typename T>
+struct is_leakable_at_exit : public std::false_type {
+};
+
+} // namespace traits
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+
+namespace detail {
+
+/**
+ * @brief Whether delayed_init_shutdown() has been called.
+ *
+ * (A static member of a class template to be defined in a header.)
+ */
+template <typename = void>
+struct shutdown_state {
+  static std::atomic<bool> in_progress;
+};
+
+template <typename V>
+std::atomic<bool> shutdown_state<V>::in_progress(false);
+
+} // namespace detail
+
+/**
+ * @brief Starts the fast shutdown: from now on, the destructors of
+ * delayed_init<T> leak the inner objects of types T such that
+ * traits::is_leakable_at_exit<T>::value == true.
+ *
+ * This is meant to be called just before returning from main() (or calling
+ * exit()) and can't be undone. Objects of other types are destroyed as usual.
+ *
+ * @throw - Nothing.
+ */
+inline void delayed_init_shutdown() noexcept {
+  detail::shutdown_state<>::in_progress.store(true, std::memory_order_relaxed);
+}
+
+#endif // OVERLOAD_DELAYED_INIT_LEAN
+
+/**
+ * @brief Sentinel value marking an empty delayed_init<T, storage::niche>.
+ *
+ * Specialisations must provide two static member functions:
+ *   static T empty() noexcept; // returns the sentinel value.
+ *   static bool is_empty(const T& obj) noexcept; // checks for the sentinel.
+ *
+ * The sentinel value must never be used as a legitimate value of T. This
+ * template is specialised for pointers (nullptr) and for floating point types
+ * (a NaN with a particular payload). Other types T opt in by specialising it.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T>
+struct niche_traits;
+
+template <typename T>
+struct niche_traits<T*> {
+
+  static constexpr T* empty() noexcept {
+    return nullptr;
+  }
+
+  static constexpr bool is_empty(T* obj) noexcept {
+    return obj == nullptr;
+  }
+};
+
+template <>
+struct niche_traits<double> {
+
+  static double empty() noexcept {
+    const std::uint64_t bits = UINT64_C(0x7ff8de1a7ed00000);
+    double obj;
+    std::memcpy(&obj, &bits, sizeof(obj));
+    return obj;
+  }
+
+  static bool is_empty(const double& obj) noexcept {
+    std::uint64_t bits;
+    std::memcpy(&bits, &obj, sizeof(bits));
+    return bits == UINT64_C(0x7ff8de1a7ed00000);
+  }
+};
+
+template <>
+struct niche_traits<float> {
+
+  static float empty() noexcept {
+    const std::uint32_t bits = UINT32_C(0x7fcde1a7);
+    float obj;
+    std::memcpy(&obj, &bits, sizeof(obj));
+    return obj;
+  }
+
+  static bool is_empty(const float& obj) noexcept {
+    std::uint32_t bits;
+    std::memcpy(&bits, &obj, sizeof(bits));
+    return bits == UINT32_C(0x7fcde1a7);
+  }
+};
+
+/**
+ * @brief Resets objects kept alive by delayed_init<T, storage::recyclable>.
+ *
+ * Specialisations must provide the static member function
+ *   static void clear(T& obj) noexcept;
+ * which brings obj to a state equivalent to T() without releasing resources
+ * (e.g. the capacity of a container) that T can reuse. By default, it calls
+ * obj.clear() which suits standard containers and strings.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T>
+struct recycle_traits {
+
+  static void clear(T& obj) noexcept {
+    obj.clear();
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief Raw storage for an object of type T.
+ *
+ * The union neither constructs nor destroys its member obj_. It is trivially
+ * copyable (or destructible) if, and only if, T is.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T, bool = std::is_trivially_destructible<T>::value>
+union raw_storage {
+  constexpr raw_storage() noexcept : dummy_() {
+  }
+  OVERLOAD_DELAYED_INIT_CONSTEXPR ~raw_storage() noexcept {
+  }
+  char dummy_;
+  T    obj_;
+};
+
+template <typename T>
+union raw_storage<T, true> {
+  constexpr raw_storage() noexcept :
+    raw_storage(typename std::is_arithmetic<T>::type()) {
+  }
+  char dummy_;
+  T    obj_;
+private:
+  // For arithmetic types, the bytes of obj_ are always determinate (see
+  // has_readable_obj).
+  constexpr explicit raw_storage(std::true_type) noexcept : obj_() {
+  }
+  constexpr explicit raw_storage(std::false_type) noexcept : dummy_() {
+  }
+};
+
+/**
+ * @brief Data members of flag_storage: a flag followed by the object.
+ *
+ * @tparam T Type of the object.
+ * @tparam FlagAfter Whether the flag follows the object.
+ */
+template <typename T, bool FlagAfter>
+struct flag_members {
+  constexpr flag_members() noexcept : is_init_(false) {
+  }
+  bool           is_init_;
+  raw_storage<T> raw_;
+};
+
+/**
+ * @brief Data members of flag_storage: the object followed by a flag.
+ */
+template <typename T>
+struct flag_members<T, true> {
+  constexpr flag_members() noexcept : is_init_(false) {
+  }
+  raw_storage<T> raw_;
+  bool           is_init_;
+};
+
+/**
+ * @brief Storage of delayed_init<T>: a flag and the object.
+ *
+ * This class only provides primitive operations on which delayed_init<T> is
+ * built. In particular, its special members never construct, copy or destroy
+ * the object and, hence, they are trivial if, and only if, T's are.
+ *
+ * @tparam T Type of the object.
+ * @tparam FlagAfter Whether the flag follows (rather than precedes) the object.
+ */
+template <typename T, bool FlagAfter = false>
+class flag_storage : private flag_members<T, FlagAfter> {
+
+public:
+
+  typedef T value_type;
+
+  constexpr flag_storage() noexcept {
+  }
+
+  constexpr bool is_init() const noexcept {
+    return this->is_init_;
+  }
+
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T* obj() noexcept {
+    return &this->raw_.obj_;
+  }
+
+  constexpr const T* obj() const noexcept {
+    return &this->raw_.obj_;
+  }
+
+  /**
+   * @brief Initialise inner object.
+   *
+   * @pre is_init() == false.
+   * @post is_init() == true.
+   * @param args Initialisation arguments.
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void init_obj(Args&&... args) {
+#if OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR
+    std::construct_at(&this->raw_.obj_, std::forward<Args>(args)...);
+#else
+    new ((void *) &this->raw_.obj_) T(std::forward<Args>(args)...);
+#endif
+    this->is_init_ = true;
+  }
+
+  /**
+   * @brief Initialise inner object from the result of a factory.
+   *
+   * From C++17, if f() returns a prvalue of type T, then no copy or move is
+   * involved.
+   *
+   * @pre is_init() == false.
+   * @post is_init() == true.
+   * @param f Factory.
+   * @throw - Whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  void init_obj_with(F&& f) {
+    new ((void *) &this->raw_.obj_) T(std::forward<F>(f)());
+    this->is_init_ = true;
+  }
+
+  /**
+   * @brief Memory for the inner object (two-phase initialisation).
+   *
+   * The caller builds the object in the returned memory and then calls either
+   * commit_obj() (once the object exists) or cancel_obj().
+   *
+   * @pre is_init() == false.
+   * @throw - Nothing.
+   */
+  void* prepare_obj() noexcept {
+    return &this->raw_.obj_;
+  }
+
+  /**
+   * @brief Marks the object built in memory given by prepare_obj() as
+   * initialised.
+   *
+   * @post is_init() == true.
+   * @throw - Nothing.
+   */
+  void commit_obj(void*) noexcept {
+    this->is_init_ = true;
+  }
+
+  /**
+   * @brief Releases memory given by prepare_obj() (where there's no object).
+   *
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  void cancel_obj(void*) noexcept {
+  }
+
+  /**
+   * @brief Assign to inner object.
+   *
+   * @pre is_init() == true.
+   * @param src Assignment source.
+   * @throw - Whatever T::operator=(U&&) throws.
+   */
+  template <typename U>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void assign_obj(U&& src) {
+    *obj() = std::forward<U>(src);
+  }
+
+  /**
+   * @brief Destroy inner object.
+   *
+   * @pre is_init() == true.
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void destroy_obj() noexcept {
+    (&this->raw_.obj_)->~T();
+    this->is_init_ = false;
+  }
+
+}; // class flag_storage
+
+/**
+ * @brief Flag-free storage of delayed_init<T>.
+ *
+ * The object always holds a value of T and it is considered not initialised
+ * when this value is the sentinel given by niche_traits<T>. Hence,
+ * sizeof(niche_storage<T>) == sizeof(T).
+ *
+ * @tparam T Type of the object (must be trivially copyable).
+ */
+template <typename T>
+class niche_storage {
+
+  typedef typename std::remove_const<T>::type value_t;
+  typedef niche_traits<value_t> niche;
+
+  static_assert(std::is_trivially_copyable<value_t>::value, "instantiation "
+    "of niche_storage for non-trivially copyable type");
+
+public:
+
+  typedef T value_type;
+
+  niche_storage() noexcept : obj_(niche::empty()) {
+  }
+
+  bool is_init() const noexcept {
+    return !niche::is_empty(obj_);
+  }
+
+  T* obj() noexcept {
+    return &obj_;
+  }
+
+  const T* obj() const noexcept {
+    return &obj_;
+  }
+
+  /**
+   * @brief Initialise inner object.
+   *
+   * @pre is_init() == false.
+   * @pre The new value is not the sentinel.
+   * @post is_init() == true.
+   * @param args Initialisation arguments.
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  void init_obj(Args&&... args) {
+    new ((void *) &obj_) value_t(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Initialise inner object from the result of a factory.
+   *
+   * @pre is_init() == false.
+   * @pre The new value is not the sentinel.
+   * @post is_init() == true.
+   * @param f Factory.
+   * @throw - Whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  void init_obj_with(F&& f) {
+    new ((void *) &obj_) value_t(std::forward<F>(f)());
+  }
+
+  /**
+   * @brief Memory for the inner object (two-phase initialisation).
+   *
+   * See flag_storage::prepare_obj().
+   *
+   * @pre is_init() == false.
+   * @throw - Nothing.
+   */
+  void* prepare_obj() noexcept {
+    return &obj_;
+  }
+
+  /**
+   * @brief Marks the object built in memory given by prepare_obj() as
+   * initialised.
+   *
+   * @pre The new value is not the sentinel.
+   * @post is_init() == true.
+   * @throw - Nothing.
+   */
+  void commit_obj(void*) noexcept {
+  }
+
+  /**
+   * @brief Restores the sentinel (whatever was written to the memory given by
+   * prepare_obj()).
+   *
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  void cancel_obj(void*) noexcept {
+    new ((void *) &obj_) value_t(niche::empty());
+  }
+
+  /**
+   * @brief Assign to inner object.
+   *
+   * @pre is_init() == true.
+   * @param src Assignment source.
+   * @throw - Whatever T::operator=(U&&) throws.
+   */
+  template <typename U>
+  void assign_obj(U&& src) {
+    *obj() = std::forward<U>(src);
+  }
+
+  /**
+   * @brief Destroy inner object.
+   *
+   * @pre is_init() == true.
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  void destroy_obj() noexcept {
+    new ((void *) &obj_) value_t(niche::empty());
+  }
+
+private:
+
+  value_t obj_;
+
+}; // class niche_storage
+
+/**
+ * @brief Whether the bytes of S::obj() can always be read.
+ *
+ * This is the case when the object has storage and determinate bytes even
+ * when S::is_init() == false, allowing branch-free operations that read the
+ * object unconditionally and then discard the result.
+ *
+ * @tparam S Storage.
+ */
+template <typename S>
+struct has_readable_obj : public std::false_type {
+};
+
+template <typename T, bool F>
+struct has_readable_obj<flag_storage<T, F>> : public std::is_arithmetic<T> {
+};
+
+template <typename T>
+struct has_readable_obj<niche_storage<T>> : public std::true_type {
+};
+
+/**
+ * @brief Whether S reserves a value of the object to mark the empty state.
+ *
+ * If so, building or assigning this value leaves the storage uninitialised.
+ *
+ * @tparam S Storage.
+ */
+template <typename S>
+struct has_sentinel : public std::false_type {
+};
+
+template <typename T>
+struct has_sentinel<niche_storage<T>> : public std::true_type {
+};
+
+/**
+ * @brief Returns a block to its resource unless released.
+ *
+ * Used by out_of_line_storage to free the memory when T's constructor throws.
+ *
+ * @tparam R Memory resource.
+ */
+template <typename R>
+class deallocation_guard {
+
+public:
+
+  deallocation_guard(void* ptr, std::size_t size, std::size_t align) noexcept :
+    ptr_(ptr), size_(size), align_(align) {
+  }
+
+  ~deallocation_guard() noexcept {
+    if (ptr_)
+      R::deallocate(ptr_, size_, align_);
+  }
+
+  void release() noexcept {
+    ptr_ = nullptr;
+  }
+
+private:
+
+  void*       ptr_;
+  std::size_t size_;
+  std::size_t align_;
+
+}; // class deallocation_guard
+
+#if defined(__cpp_lib_memory_resource)
+
+/**
+ * @brief Blocks of a std::pmr::memory_resource that record their resource.
+ *
+ * The address given to the caller is preceded by a header holding the
+ * std::pmr::memory_resource* that allocated the block. Hence, the memory goes
+ * back to that resource even if a different one is used for newer blocks.
+ */
+struct pmr_block {
+
+  static void* allocate(std::pmr::memory_resource* mr, std::size_t size,
+    std::size_t align) {
+    const std::size_t offset = header(align);
+    char* ptr = static_cast<char*>(mr->allocate(offset + size,
+      block_align(align))) + offset;
+    std::memcpy(ptr - sizeof(mr), &mr, sizeof(mr));
+    return ptr;
+  }
+
+  static void deallocate(void* ptr, std::size_t size, std::size_t align)
+    noexcept {
+    char* p = static_cast<char*>(ptr);
+    std::pmr::memory_resource* mr;
+    std::memcpy(&mr, p - sizeof(mr), sizeof(mr));
+    const std::size_t offset = header(align);
+    mr->deallocate(p - offset, offset + size, block_align(align));
+  }
+
+private:
+
+  static constexpr std::size_t block_align(std::size_t align) noexcept {
+    return align < alignof(std::pmr::memory_resource*) ?
+      alignof(std::pmr::memory_resource*) : align;
+  }
+
+  // Smallest multiple of block_align(align) that holds the pointer.
+  static constexpr std::size_t header(std::size_t align) noexcept {
+    return (sizeof(std::pmr::memory_resource*) + block_align(align) - 1) /
+      block_align(align) * block_align(align);
+  }
+
+}; // struct pmr_block
+
+#endif // defined(__cpp_lib_memory_resource)
+
+/**
+ * @brief Out-of-line storage of delayed_init<T>: a pointer to the object.
+ *
+ * The object lives in memory obtained from R when it is initialised and this
+ * memory goes back to R when the object is destroyed. The null pointer marks
+ * the empty state and, hence, sizeof(out_of_line_storage<T, R>) ==
+ * sizeof(T*) regardless of sizeof(T).
+ *
+ * Copies are deep (they are left to the layers below) but moves transfer
+ * ownership of the pointer and leave the source empty. Hence, moves never
+ * allocate and never throw.
+ *
+ * @tparam T Type of the object.
+ * @tparam R Memory resource (see storage::out_of_line).
+ */
+template <typename T, typename R>
+class out_of_line_storage {
+
+  typedef typename std::remove_const<T>::type value_t;
+
+public:
+
+  typedef T value_type;
+
+  constexpr out_of_line_storage() noexcept : ptr_(nullptr) {
+  }
+
+  out_of_line_storage(const out_of_line_storage&) = delete;
+
+  out_of_line_storage(out_of_line_storage&& src) noexcept : ptr_(src.ptr_) {
+    src.ptr_ = nullptr;
+  }
+
+  out_of_line_storage& operator=(const out_of_line_storage&) = delete;
+
+  out_of_line_storage& operator=(out_of_line_storage&& src) noexcept {
+    if (this != &src) {
+      if (is_init())
+        destroy_obj();
+      ptr_ = src.ptr_;
+      src.ptr_ = nullptr;
+    }
+    return *this;
+  }
+
+  // Non-trivial to let destructor_layer release the object.
+  ~out_of_line_storage() noexcept {
+  }
+
+  bool is_init() const noexcept {
+    return ptr_ != nullptr;
+  }
+
+  T* obj() noexcept {
+    return ptr_;
+  }
+
+  const T* obj() const noexcept {
+    return ptr_;
+  }
+
+  /**
+   * @brief Initialise inner object.
+   *
+   * @pre is_init() == false.
+   * @post is_init() == true.
+   * @param args Initialisation arguments.
+   * @throw - Whatever R::allocate() and T::T(Args&&...) throw.
+   */
+  template <typename... Args>
+  void init_obj(Args&&... args) {
+    void* ptr = R::allocate(sizeof(T), alignof(T));
+    deallocation_guard<R> guard(ptr, sizeof(T), alignof(T));
+    ptr_ = new (ptr) value_t(std::forward<Args>(args)...);
+    guard.release();
+  }
+
+  /**
+   * @brief Initialise inner object from the result of a factory.
+   *
+   * @pre is_init() == false.
+   * @post is_init() == true.
+   * @param f Factory.
+   * @throw - Whatever R::allocate(), f() and T's constructor throw.
+   */
+  template <typename F>
+  void init_obj_with(F&& f) {
+    void* ptr = R::allocate(sizeof(T), alignof(T));
+    deallocation_guard<R> guard(ptr, sizeof(T), alignof(T));
+    ptr_ = new (ptr) value_t(std::forward<F>(f)());
+    guard.release();
+  }
+
+  /**
+   * @brief Memory for the inner object (two-phase initialisation).
+   *
+   * See flag_storage::prepare_obj(). The memory is obtained from R.
+   *
+   * @pre is_init() == false.
+   * @throw - Whatever R::allocate() throws.
+   */
+  void* prepare_obj() {
+    return R::allocate(sizeof(T), alignof(T));
+  }
+
+  /**
+   * @brief Takes ownership of the object built in memory given by
+   * prepare_obj().
+   *
+   * @post is_init() == true.
+   * @throw - Nothing.
+   */
+  void commit_obj(void* ptr) noexcept {
+    ptr_ = static_cast<T*>(ptr);
+  }
+
+  /**
+   * @brief Returns memory given by prepare_obj() (where there's no object) to
+   * R.
+   *
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  void cancel_obj(void* ptr) noexcept {
+    R::deallocate(ptr, sizeof(T), alignof(T));
+  }
+
+  /**
+   * @brief Assign to inner object.
+   *
+   * @pre is_init() == true.
+   * @param src Assignment source.
+   * @throw - Whatever T::operator=(U&&) throws.
+   */
+  template <typename U>
+  void assign_obj(U&& src) {
+    *obj() = std::forward<U>(src);
+  }
+
+  /**
+   * @brief Destroy inner object and return its memory to R.
+   *
+   * @pre is_init() == true.
+   * @post is_init() == false.
+   * @throw - Nothing.
+   */
+  void destroy_obj() noexcept {
+    ptr_->~T();
+    R::deallocate(const_cast<value_t*>(ptr_), sizeof(T), alignof(T));
+    ptr_ = nullptr;
+  }
+
+private:
+
+  T* ptr_;
+
+}; // class out_of_line_storage
+
+/**
+ * @brief Storage S aligned to (at least) Align bytes.
+ *
+ * Alignment propagates to size and, therefore, each object of this type sits
+ * alone in its own Align-sized block. With Align equal to the cache line size
+ * no two such objects share a line.
+ *
+ * @tparam S Storage.
+ * @tparam Align Alignment.
+ */
+template <typename S, std::size_t Align>
+class alignas(Align < alignof(S) ? alignof(S) : Align) over_aligned_storage :
+  public S {
+};
+
+template <typename S, std::size_t Align>
+struct has_readable_obj<over_aligned_storage<S, Align>> :
+  public has_readable_obj<S> {
+};
+
+template <typename S, std::size_t Align>
+struct has_sentinel<over_aligned_storage<S, Align>> : public has_sentinel<S> {
+};
+
+/**
+ * @brief Storage of delayed_init<T, storage::recyclable>.
+ *
+ * Besides empty and initialised, the object might be recycled: it is alive
+ * but logically absent (is_init() == false). destroy_obj() recycles (see
+ * recycle_traits) rather than destroys and init_obj() reuses recycled
+ * objects: from no argument by keeping it as is and from an argument
+ * assignable to T by assignment. (Other initialisations destroy and rebuild
+ * it.) The destructor destroys recycled objects.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T>
+class recyclable_storage {
+
+  typedef typename std::remove_const<T>::type value_t;
+
+  static_assert(!std::is_const<T>::value, "instantiation of "
+    "recyclable_storage for const type");
+
+public:
+
+  typedef T value_type;
+
+  recyclable_storage() noexcept : state_(empty) {
+  }
+
+  recyclable_storage(const recyclable_storage&) = delete;
+
+  recyclable_storage& operator=(const recyclable_storage&) = delete;
+
+  ~recyclable_storage() noexcept {
+    if (state_ == recycled)
+      (&raw_.obj_)->~T();
+  }
+
+  bool is_init() const noexcept {
+    return state_ == live;
+  }
+
+  T* obj() noexcept {
+    return &raw_.obj_;
+  }
+
+  const T* obj() const noexcept {
+    return &raw_.obj_;
+  }
+
+  void init_obj() {
+    if (state_ == recycled) {
+      state_ = live;
+      return;
+    }
+    new ((void *) &raw_.obj_) T();
+    state_ = live;
+  }
+
+  template <typename U>
+  void init_obj(U&& src) {
+    init_obj_from(std::forward<U>(src),
+      typename std::is_assignable<T&, U&&>::type());
+  }
+
+  template <typename A1, typename A2, typename... Args>
+  void init_obj(A1&& a1, A2&& a2, Args&&... args) {
+    release();
+    new ((void *) &raw_.obj_) T(std::forward<A1>(a1), std::forward<A2>(a2),
+      std::forward<Args>(args)...);
+    state_ = live;
+  }
+
+  template <typename F>
+  void init_obj_with(F&& f) {
+    release();
+    new ((void *) &raw_.obj_) T(std::forward<F>(f)());
+    state_ = live;
+  }
+
+  void* prepare_obj() {
+    release();
+    return &raw_.obj_;
+  }
+
+  void commit_obj(void*) noexcept {
+    state_ = live;
+  }
+
+  void cancel_obj(void*) noexcept {
+  }
+
+  template <typename U>
+  void assign_obj(U&& src) {
+    raw_.obj_ = std::forward<U>(src);
+  }
+
+  void destroy_obj() noexcept {
+    recycle_traits<T>::clear(raw_.obj_);
+    state_ = recycled;
+  }
+
+private:
+
+  enum : unsigned char {
+    empty,    // no object.
+    live,     // initialised.
+    recycled  // alive but logically absent.
+  };
+
+  template <typename U>
+  void init_obj_from(U&& src, std::true_type) {
+    if (state_ == recycled) {
+      raw_.obj_ = std::forward<U>(src);
+      state_ = live;
+      return;
+    }
+    new ((void *) &raw_.obj_) T(std::forward<U>(src));
+    state_ = live;
+  }
+
+  template <typename U>
+  void init_obj_from(U&& src, std::false_type) {
+    release();
+    new ((void *) &raw_.obj_) T(std::forward<U>(src));
+    state_ = live;
+  }
+
+  // Destroys a recycled object to make room for a new one.
+  void release() noexcept {
+    if (state_ == recycled) {
+      (&raw_.obj_)->~T();
+      state_ = empty;
+    }
+  }
+
+  unsigned char  state_;
+  raw_storage<T> raw_;
+
+}; // class recyclable_storage
+
+} // namespace detail
+
+namespace traits {
+
+template <typename T, bool F>
+struct is_trivially_relocatable<detail::flag_storage<T, F>> :
+  public is_trivially_relocatable<typename std::remove_const<T>::type> {
+};
+
+template <typename T, typename R>
+struct is_trivially_relocatable<detail::out_of_line_storage<T, R>> :
+  public std::true_type {
+};
+
+template <typename S, std::size_t A>
+struct is_trivially_relocatable<detail::over_aligned_storage<S, A>> :
+  public is_trivially_relocatable<S> {
+};
+
+} // namespace traits
+
+namespace detail {
+
+/*
+ * The layers below add to a storage S the special members that, for
+ * non-trivial T, need to construct, assign or destroy the inner object. Each
+ * layer is specialised for the case where S's own member does the job and,
+ * hence, adds nothing. This is the case when S's member is trivial (and then a
+ * special member of delayed_init<T> is trivial whenever the corresponding
+ * operations of T are) or when S provides it (e.g. out_of_line_storage's
+ * moves).
+ */
+
+template <typename S, bool = std::is_trivially_destructible<S>::value>
+class destructor_layer : public S {
+  typedef typename std::remove_const<typename S::value_type>::type T;
+public:
+  destructor_layer() = default;
+  destructor_layer(const destructor_layer&) = default;
+  destructor_layer(destructor_layer&&) = default;
+  destructor_layer& operator=(const destructor_layer&) = default;
+  destructor_layer& operator=(destructor_layer&&) = default;
+  OVERLOAD_DELAYED_INIT_CONSTEXPR ~destructor_layer() noexcept {
+    if (this->is_init() &&
+      !is_leaked(typename traits::is_leakable_at_exit<T>::type()))
+      this->destroy_obj();
+  }
+private:
+  static constexpr bool is_leaked(std::false_type) noexcept {
+    return false;
+  }
+  static bool is_leaked(std::true_type) noexcept {
+#ifdef OVERLOAD_DELAYED_INIT_LEAN
+    return false;
+#else
+    return shutdown_state<>::in_progress.load(std::memory_order_relaxed);
+#endif
+  }
+};
+
+template <typename S>
+class destructor_layer<S, true> : public S {
+};
+
+template <typename S, bool = std::is_copy_constructible<S>::value>
+class copy_constructor_layer : public destructor_layer<S> {
+  typedef typename S::value_type T;
+public:
+  copy_constructor_layer() = default;
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  copy_constructor_layer(const copy_constructor_layer& src)
+    noexcept(std::is_nothrow_copy_constructible<T>::value) :
+    destructor_layer<S>() {
+    if (src.is_init())
+      this->init_obj(*src.obj());
+  }
+  copy_constructor_layer(copy_constructor_layer&&) = default;
+  copy_constructor_layer& operator=(const copy_constructor_layer&) = default;
+  copy_constructor_layer& operator=(copy_constructor_layer&&) = default;
+};
+
+template <typename S>
+class copy_constructor_layer<S, true> : public destructor_layer<S> {
+};
+
+template <typename S, bool = std::is_move_constructible<S>::value>
+class move_constructor_layer : public copy_constructor_layer<S> {
+  typedef typename S::value_type T;
+public:
+  move_constructor_layer() = default;
+  move_constructor_layer(const move_constructor_layer&) = default;
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  move_constructor_layer(move_constructor_layer&& src)
+    noexcept(std::is_nothrow_move_constructible<T>::value) :
+    copy_constructor_layer<S>() {
+    if (src.is_init())
+      this->init_obj(std::move(*src.obj()));
+  }
+  move_constructor_layer& operator=(const move_constructor_layer&) = default;
+  move_constructor_layer& operator=(move_constructor_layer&&) = default;
+};
+
+template <typename S>
+class move_constructor_layer<S, true> : public copy_constructor_layer<S> {
+};
+
+template <typename S, bool =
+  std::is_trivially_copy_assignable<S>::value &&
+  std::is_trivially_copy_constructible<S>::value &&
+  std::is_trivially_destructible<S>::value>
+class copy_assignment_layer : public move_constructor_layer<S> {
+  typedef typename S::value_type T;
+public:
+  copy_assignment_layer() = default;
+  copy_assignment_layer(const copy_assignment_layer&) = default;
+  copy_assignment_layer(copy_assignment_layer&&) = default;
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  copy_assignment_layer& operator=(const copy_assignment_layer& src)
+    noexcept(
+      std::is_nothrow_copy_constructible<T>::value &&
+      std::is_nothrow_copy_assignable<T>::value
+    ) {
+    if (!this->is_init()) {
+      if (src.is_init())
+        this->init_obj(*src.obj());
+    }
+    else if (src.is_init())
+      this->assign_obj(*src.obj());
+    else
+      this->destroy_obj();
+    return *this;
+  }
+  copy_assignment_layer& operator=(copy_assignment_layer&&) = default;
+};
+
+template <typename S>
+class copy_assignment_layer<S, true> : public move_constructor_layer<S> {
+};
+
+template <typename S, bool =
+  (std::is_trivially_move_assignable<S>::value &&
+  std::is_trivially_move_constructible<S>::value &&
+  std::is_trivially_destructible<S>::value) ||
+  (std::is_move_assignable<S>::value &&
+  !std::is_trivially_move_assignable<S>::value)>
+class move_assignment_layer : public copy_assignment_layer<S> {
+  typedef typename S::value_type T;
+public:
+  move_assignment_layer() = default;
+  move_assignment_layer(const move_assignment_layer&) = default;
+  move_assignment_layer(move_assignment_layer&&) = default;
+  move_assignment_layer& operator=(const move_assignment_layer&) = default;
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  move_assignment_layer& operator=(move_assignment_layer&& src)
+    noexcept(
+      std::is_nothrow_move_constructible<T>::value &&
+      std::is_nothrow_move_assignable<T>::value
+    ) {
+    if (!this->is_init()) {
+      if (src.is_init())
+        this->init_obj(std::move(*src.obj()));
+    }
+    else if (src.is_init())
+      this->assign_obj(std::move(*src.obj()));
+    else
+      this->destroy_obj();
+    return *this;
+  }
+};
+
+template <typename S>
+class move_assignment_layer<S, true> : public copy_assignment_layer<S> {
+};
+
+/*
+ * The classes below delete the special members of delayed_init<T> that T
+ * doesn't support. (Otherwise, e.g., delayed_init<std::unique_ptr<U>> would
+ * claim to be copy-constructible.) They are empty and have no effect on
+ * triviality.
+ */
+
+template <bool>
+struct enable_copy_constructor {
+};
+
+template <>
+struct enable_copy_constructor<false> {
+  enable_copy_constructor() = default;
+  enable_copy_constructor(const enable_copy_constructor&) = delete;
+  enable_copy_constructor(enable_copy_constructor&&) = default;
+  enable_copy_constructor& operator=(const enable_copy_constructor&) = default;
+  enable_copy_constructor& operator=(enable_copy_constructor&&) = default;
+};
+
+template <bool>
+struct enable_move_constructor {
+};
+
+template <>
+struct enable_move_constructor<false> {
+  enable_move_constructor() = default;
+  enable_move_constructor(const enable_move_constructor&) = default;
+  enable_move_constructor(enable_move_constructor&&) = delete;
+  enable_move_constructor& operator=(const enable_move_constructor&) = default;
+  enable_move_constructor& operator=(enable_move_constructor&&) = default;
+};
+
+template <bool>
+struct enable_copy_assignment {
+};
+
+template <>
+struct enable_copy_assignment<false> {
+  enable_copy_assignment() = default;
+  enable_copy_assignment(const enable_copy_assignment&) = default;
+  enable_copy_assignment(enable_copy_assignment&&) = default;
+  enable_copy_assignment& operator=(const enable_copy_assignment&) = delete;
+  enable_copy_assignment& operator=(enable_copy_assignment&&) = default;
+};
+
+template <bool>
+struct enable_move_assignment {
+};
+
+template <>
+struct enable_move_assignment<false> {
+  enable_move_assignment() = default;
+  enable_move_assignment(const enable_move_assignment&) = default;
+  enable_move_assignment(enable_move_assignment&&) = default;
+  enable_move_assignment& operator=(const enable_move_assignment&) = default;
+  enable_move_assignment& operator=(enable_move_assignment&&) = delete;
+};
+
+/**
+ * @brief Deletes the special members of delayed_init<T> unsupported by T.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T>
+struct enable_special_members :
+  enable_copy_constructor<std::is_copy_constructible<T>::value>,
+  enable_move_constructor<std::is_move_constructible<T>::value>,
+  enable_copy_assignment<std::is_copy_constructible<T>::value &&
+    std::is_copy_assignable<T>::value>,
+  enable_move_assignment<std::is_move_constructible<T>::value &&
+    std::is_move_assignable<T>::value> {
+};
+
+} // namespace detail
+
+template <typename T, typename Storage, typename Check, typename Instrument>
+class delayed_init;
+
+namespace detail {
+
+/**
+ * @brief Detects if a type is an instantiation of delayed_init.
+ *
+ * @tparam T Type.
+ */
+template <typename T>
+struct is_delayed_init : public std::false_type {
+};
+
+template <typename T, typename S, typename C, typename I>
+struct is_delayed_init<delayed_init<T, S, C, I>> : public std::true_type {
+};
+
+struct inner_access;
+
+/**
+ * @brief Tag of delayed_init's constructor from a factory.
+ */
+struct with_factory_t {
+};
+
+/**
+ * @brief Type of the object built by delayed_init::transform(f).
+ *
+ * @tparam F Type of f.
+ * @tparam A Type of the argument passed to f.
+ */
+template <typename F, typename A>
+using transform_result = typename std::decay<decltype(std::declval<F>()(
+  std::declval<A>()))>::type;
+
+/**
+ * @brief Factory calling f(obj) where obj is forwarded as an A.
+ *
+ * @tparam R Type of the result.
+ * @tparam F Type of f.
+ * @tparam A Type of obj.
+ */
+template <typename R, typename F, typename A>
+struct bound_call {
+  F&& f;
+  A&& obj;
+  R operator()() const {
+    return std::forward<F>(f)(std::forward<A>(obj));
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Storage policies of delayed_init.
+ *
+ * A storage policy has a member alias template type<T> naming the class that
+ * holds the object of type T and keeps track of its initialisation.
+ */
+namespace storage {
+
+/**
+ * @brief Default storage: a bool flag followed by the object.
+ */
+struct flag {
+  template <typename T>
+  using type = detail::flag_storage<T>;
+};
+
+/**
+ * @brief Storage with the object followed by a bool flag.
+ *
+ * The object sits at offset 0 and, hence, its address is that of the
+ * delayed_init. This costs nothing on size (padding is the same in either
+ * order) and suits code which hands out the address of the object. (Since T
+ * is held in a union, compilers don't place the flag in T's tail padding.)
+ *
+ * There's no per-object policy keeping the flag elsewhere: flags of many
+ * objects are better packed together, as delayed_init_array does, and types
+ * with spare values go flag-free with storage::niche.
+ */
+struct flag_after {
+  template <typename T>
+  using type = detail::flag_storage<T, true>;
+};
+
+/**
+ * @brief Flag-free storage: the empty state is a sentinel value of T.
+ *
+ * The sentinel value is given by niche_traits<T> which T must specialise.
+ */
+struct niche {
+  template <typename T>
+  using type = detail::niche_storage<T>;
+};
+
+/**
+ * @brief Memory resource using the global operator new and operator delete.
+ *
+ * A memory resource (for storage::out_of_line) provides two static members:
+ *   static void* allocate(std::size_t size, std::size_t align);
+ *   static void deallocate(void* ptr, std::size_t size,
+ *     std::size_t align) noexcept;
+ * They are static since a delayed_init using it holds nothing but a pointer to
+ * the object. Arenas and pools are plugged in by wrapping them in a class
+ * with this interface.
+ */
+struct new_delete_resource {
+
+  static void* allocate(std::size_t size, std::size_t align) {
+#if defined(__cpp_aligned_new)
+    if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator new(size, std::align_val_t(align));
+#else
+    (void) align;
+#endif
+    return ::operator new(size);
+  }
+
+  static void deallocate(void* ptr, std::size_t size, std::size_t align)
+    noexcept {
+    (void) size;
+#if defined(__cpp_aligned_new)
+    if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(ptr, std::align_val_t(align));
+      return;
+    }
+#else
+    (void) align;
+#endif
+    ::operator delete(ptr);
+  }
+};
+
+#if defined(__cpp_lib_memory_resource)
+
+/**
+ * @brief Memory resource forwarding to std::pmr::get_default_resource().
+ *
+ * Installing, say, a std::pmr::monotonic_buffer_resource with
+ * std::pmr::set_default_resource() gives bump-pointer allocation. The default
+ * resource is queried on allocation and recorded in a header placed before the
+ * object (max(sizeof(void*), alignof(T)) bytes). Hence, changing the default
+ * only affects later initialisations and each object's memory goes back to the
+ * resource it came from, which must therefore outlive the object.
+ */
+struct pmr_default_resource {
+
+  static void* allocate(std::size_t size, std::size_t align) {
+    return detail::pmr_block::allocate(std::pmr::get_default_resource(), size,
+      align);
+  }
+
+  static void deallocate(void* ptr, std::size_t size, std::size_t align)
+    noexcept {
+    detail::pmr_block::deallocate(ptr, size, align);
+  }
+};
+
+/**
+ * @brief Memory resource forwarding to a user-supplied
+ * std::pmr::memory_resource.
+ *
+ * Each Tag has its own resource, set by set(), so that different delayed_init
+ * types can use different resources. Until set() is called, this is
+ * std::pmr::get_default_resource(). As for pmr_default_resource, the resource
+ * is recorded on allocation: set() only affects later initialisations and
+ * each resource must outlive the objects allocated from it.
+ *
+ * @tparam Tag Type identifying the resource.
+ */
+template <typename Tag = void>
+struct pmr_resource {
+
+  /**
+   * @brief Resource used by the next allocations.
+   *
+   * @throw - Nothing.
+   */
+  static std::pmr::memory_resource* get() noexcept {
+    std::pmr::memory_resource* mr = resource_.load(std::memory_order_acquire);
+    return mr ? mr : std::pmr::get_default_resource();
+  }
+
+  /**
+   * @brief Sets the resource used by the next allocations.
+   *
+   * @param mr The resource (nullptr means std::pmr::get_default_resource()).
+   * @throw - Nothing.
+   */
+  static void set(std::pmr::memory_resource* mr) noexcept {
+    resource_.store(mr, std::memory_order_release);
+  }
+
+  static void* allocate(std::size_t size, std::size_t align) {
+    return detail::pmr_block::allocate(get(), size, align);
+  }
+
+  static void deallocate(void* ptr, std::size_t size, std::size_t align)
+    noexcept {
+    detail::pmr_block::deallocate(ptr, size, align);
+  }
+
+private:
+
+  static std::atomic<std::pmr::memory_resource*> resource_;
+};
+
+template <typename Tag>
+std::atomic<std::pmr::memory_resource*> pmr_resource<Tag>::resource_(nullptr);
+
+#endif // defined(__cpp_lib_memory_resource)
+
+/**
+ * @brief Out-of-line storage: a pointer to an object allocated on init.
+ *
+ * Only a pointer is kept inline which suits large T that is often left
+ * uninitialised. The object is allocated from Resource (see
+ * new_delete_resource) and the memory is returned when it is destroyed. Moves
+ * transfer ownership and leave the source empty.
+ *
+ * @tparam Resource Memory resource.
+ */
+template <typename Resource = new_delete_resource>
+struct out_of_line {
+  template <typename T>
+  using type = detail::out_of_line_storage<T, Resource>;
+};
+
+/**
+ * @brief Storage of policy S aligned to Align bytes.
+ *
+ * The default aligns to the cache line size to prevent false sharing between
+ * delayed_init objects written by different threads (e.g., elements of an
+ * array). The price is size: sizeof is rounded up to a multiple of Align.
+ *
+ * @tparam S Storage policy.
+ * @tparam Align Alignment (a power of 2). Ignored if less than S's.
+ */
+template <typename S = flag,
+  std::size_t Align = OVERLOAD_DELAYED_INIT_CACHE_LINE>
+struct aligned {
+  template <typename T>
+  using type = detail::over_aligned_storage<typename S::template type<T>,
+    Align>;
+};
+
+/**
+ * @brief Storage which keeps objects alive for reuse when they are destroyed.
+ *
+ * Destruction (e.g., through recycle() or assignment from an uninitialised
+ * delayed_init) clears the object with recycle_traits<T>::clear() and the
+ * next init() with no argument, or one assignable to T, reuses it. Hence,
+ * buffers of containers and strings are allocated once and their capacity is
+ * kept from one initialisation to the next.
+ *
+ * T must not be const.
+ */
+struct recyclable {
+  template <typename T>
+  using type = detail::recyclable_storage<T>;
+};
+
+} // namespace storage
+
+/**
+ * @brief Checking policies of delayed_init.
+ *
+ * A checking policy sets what happens when a pre-condition of
+ * delayed_init::operator*() or delayed_init::init() doesn't hold. It provides:
+ *   static constexpr bool is_nothrow; // whether fail() can throw.
+ *   static void fail(const char* what); // called on violations.
+ */
+namespace check {
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+
+/**
+ * @brief Throws std::logic_error.
+ */
+struct exception {
+
+  static constexpr bool is_nothrow = false;
+
+  [[noreturn]] static void fail(const char* what) {
+    throw std::logic_error(what);
+  }
+};
+
+#endif // OVERLOAD_DELAYED_INIT_LEAN
+
+/**
+ * @brief Asserts (calls none::fail() if NDEBUG is defined).
+ */
+struct assertion {
+
+  static constexpr bool is_nothrow = true;
+
+  static void fail(const char* what) noexcept {
+    (void) what;
+    assert(!"delayed_init pre-condition violated" && what);
+    OVERLOAD_DELAYED_INIT_ASSUME(false);
+  }
+};
+
+/**
+ * @brief Calls std::terminate().
+ */
+struct terminate {
+
+  static constexpr bool is_nothrow = true;
+
+  [[noreturn]] static void fail(const char*) noexcept {
+    std::terminate();
+  }
+};
+
+/**
+ * @brief No check: violations are undefined behaviour.
+ *
+ * The optimiser assumes that pre-conditions hold and removes the checks.
+ */
+struct none {
+
+  static constexpr bool is_nothrow = true;
+
+  static void fail(const char*) noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(false);
+  }
+};
+
+} // namespace check
+
+/**
+ * @brief Instrumentation policies of delayed_init.
+ *
+ * An instrumentation policy is notified of the operations performed on the
+ * inner objects. It provides:
+ *   static void record(event e) noexcept; // called after each operation.
+ */
+namespace instrument {
+
+/**
+ * @brief Operations reported to instrumentation policies.
+ */
+enum event {
+  construct,      // construction from arguments other than a single T.
+  copy_construct, // copy-construction from T.
+  move_construct, // move-construction from T.
+  assign,         // assignment from other than T.
+  copy_assign,    // copy-assignment from T.
+  move_assign,    // move-assignment from T.
+  destroy,        // destruction.
+  failed_check,   // pre-condition violation (before Check::fail() is called).
+  n_events
+};
+
+/**
+ * @brief No instrumentation (default).
+ *
+ * delayed_init<T, Storage, Check, none> is exactly as if there were no
+ * instrumentation. In particular, its storage and special members are not
+ * affected.
+ */
+struct none {
+  static void record(event) noexcept {
+  }
+};
+
+} // namespace instrument
+
+namespace detail {
+
+/**
+ * @brief The event corresponding to building (or assigning) a T from Args.
+ *
+ * @tparam T Type of the object.
+ * @tparam E Event when Args is a single lvalue (or const) T: copy_construct
+ * or copy_assign (the corresponding move event is E + 1).
+ * @tparam Args Types of the arguments.
+ */
+template <typename T, instrument::event E, typename... Args>
+struct event_for : std::integral_constant<instrument::event,
+  E == instrument::copy_construct ? instrument::construct :
+  instrument::assign> {
+};
+
+template <typename T, instrument::event E, typename U>
+struct event_for<T, E, U> : std::integral_constant<instrument::event,
+  !std::is_same<typename std::remove_cv<typename
+    std::remove_reference<U>::type>::type,
+    typename std::remove_cv<T>::type>::value ?
+  event_for<T, E>::value :
+  std::is_lvalue_reference<U>::value ||
+  std::is_const<typename std::remove_reference<U>::type>::value ? E :
+  static_cast<instrument::event>(E + 1)> {
+};
+
+/**
+ * @brief Moves of the storage S instrumented by I.
+ *
+ * If S provides its own moves (e.g. out_of_line_storage transfers its
+ * pointer), then they are forwarded and reported as the events the layers
+ * would report for the same states. Otherwise, moves are deleted (as copies
+ * always are) to leave them to the layers.
+ *
+ * @tparam S Storage.
+ * @tparam I Instrumentation policy.
+ */
+template <typename S, typename I, bool =
+  std::is_move_constructible<S>::value &&
+  !std::is_trivially_move_constructible<S>::value>
+class instrumented_moves : public S {
+public:
+  instrumented_moves() = default;
+  instrumented_moves(const instrumented_moves&) = delete;
+  instrumented_moves& operator=(const instrumented_moves&) = delete;
+};
+
+template <typename S, typename I>
+class instrumented_moves<S, I, true> : public S {
+
+public:
+
+  instrumented_moves() = default;
+
+  instrumented_moves(const instrumented_moves&) = delete;
+
+  instrumented_moves(instrumented_moves&& src)
+    noexcept(std::is_nothrow_move_constructible<S>::value) :
+    S(std::move(static_cast<S&>(src))) {
+    if (this->is_init())
+      I::record(instrument::move_construct);
+  }
+
+  instrumented_moves& operator=(const instrumented_moves&) = delete;
+
+  instrumented_moves& operator=(instrumented_moves&& src)
+    noexcept(std::is_nothrow_move_assignable<S>::value) {
+    if (this == &src)
+      return *this;
+    const bool was_init = this->is_init();
+    const bool src_was_init = src.is_init();
+    S::operator=(std::move(static_cast<S&>(src)));
+    if (src_was_init)
+      I::record(was_init ? instrument::move_assign :
+        instrument::move_construct);
+    else if (was_init)
+      I::record(instrument::destroy);
+    return *this;
+  }
+};
+
+/**
+ * @brief Storage S reporting operations to the instrumentation policy I.
+ *
+ * Copies are deleted and so are moves unless S provides them (see
+ * instrumented_moves). These are left to the layers below which implement
+ * them in terms of the instrumented primitives. Hence, the special members of
+ * an instrumented delayed_init are never trivial but moves keep the semantics
+ * of S's (e.g. the source is left empty for storage::out_of_line).
+ *
+ * @tparam S Storage.
+ * @tparam I Instrumentation policy.
+ */
+template <typename S, typename I>
+class instrumented_storage : public instrumented_moves<S, I> {
+
+  typedef typename S::value_type T;
+
+public:
+
+  instrumented_storage() = default;
+
+  instrumented_storage(const instrumented_storage&) = delete;
+
+  instrumented_storage(instrumented_storage&&) = default;
+
+  instrumented_storage& operator=(const instrumented_storage&) = delete;
+
+  instrumented_storage& operator=(instrumented_storage&&) = default;
+
+  ~instrumented_storage() noexcept {
+  }
+
+  template <typename... Args>
+  void init_obj(Args&&... args) {
+    S::init_obj(std::forward<Args>(args)...);
+    I::record(event_for<T, instrument::copy_construct, Args...>::value);
+  }
+
+  template <typename F>
+  void init_obj_with(F&& f) {
+    S::init_obj_with(std::forward<F>(f));
+    I::record(instrument::construct);
+  }
+
+  void commit_obj(void* ptr) noexcept {
+    S::commit_obj(ptr);
+    I::record(instrument::construct);
+  }
+
+  template <typename U>
+  void assign_obj(U&& src) {
+    S::assign_obj(std::forward<U>(src));
+    I::record(event_for<T, instrument::copy_assign, U>::value);
+  }
+
+  void destroy_obj() noexcept {
+    S::destroy_obj();
+    I::record(instrument::destroy);
+  }
+
+}; // class instrumented_storage
+
+} // namespace detail
+
+namespace traits {
+
+template <typename S, typename I>
+struct is_trivially_relocatable<detail::instrumented_storage<S, I>> :
+  public is_trivially_relocatable<S> {
+};
+
+} // namespace traits
+
+namespace detail {
+
+/**
+ * @brief The storage of delayed_init<T, Storage, Check, I>.
+ */
+template <typename T, typename Storage, typename I>
+struct storage_for {
+  typedef instrumented_storage<typename Storage::template type<T>, I> type;
+};
+
+template <typename T, typename Storage>
+struct storage_for<T, Storage, instrument::none> {
+  typedef typename Storage::template type<T> type;
+};
+
+} // namespace detail
+
+/**
+ * @brief Prevents default-initialisation.
+ *
+ * Class delay_init<T> holds an object of type T whose initialisation is delayed
+ * until init() is called.
+ *
+ * The compiler tries hard to initialise every non-static data member of a class
+ * before execution reachs the constructor body. If delaying the initialisation
+ * of a non-static data member of type T to a later time is needed, then declare
+ * the member as a delayed_init<T> rather than a T.
+ *
+ * For an lvalue reference type T, see delayed_init<T&>. The type T must not
+ * be an rvalue reference type.
+ *
+ * The policy Storage sets how the object and its initialisation state are
+ * stored (see namespace storage). By default, a bool flag is placed before the
+ * object. Alternatively, storage::niche saves the flag by reserving a sentinel
+ * value of T to mark the empty state and storage::out_of_line keeps only a
+ * pointer to an object allocated on initialisation. (With the latter, moves
+ * transfer the object and leave the source uninitialised.)
+ *
+ * The policy Check sets what happens when a pre-condition of operator*() or
+ * init() doesn't hold (see namespace check). This includes, for storage::niche,
+ * initialising or assigning the sentinel. By default, std::logic_error is
+ * thrown (std::terminate() is called in the lean configuration, see
+ * OVERLOAD_DELAYED_INIT_LEAN). This default can be changed by the macro
+ * OVERLOAD_DELAYED_INIT_CHECK.
+ * Regardless of Check, value_unchecked() and init_unchecked() never check.
+ *
+ * The policy Instrument is notified of every construction, assignment and
+ * destruction of the inner object and of every pre-condition violation (see
+ * namespace instrument). By default, there is no instrumentation and no cost.
+ * This default can be changed by the macro OVERLOAD_DELAYED_INIT_INSTRUMENT.
+ *
+ * Objects are compared (by ==, !=, <, <=, > and >=) as std::optional:
+ * uninitialised objects compare equal to each other and smaller than any
+ * initialised object. Otherwise, the inner objects are compared.
+ *
+ * When OVERLOAD_DELAYED_INIT_HAS_CONSTEXPR == 1 (C++20), all members but
+ * init_with() and relocate_to() are constexpr for storage::flag and
+ * storage::flag_after.
+ * 
+ * Reference:
+ * Cassio Neri, "Complex logic in the member initialiser list", Overload 112,
+ * ACCU, (2012).
+ * http://accu.org/var/uploads/journals/Overload112.pdf
+ */
+template <typename T, typename Storage = storage::flag,
+  typename Check = OVERLOAD_DELAYED_INIT_CHECK,
+  typename Instrument = OVERLOAD_DELAYED_INIT_INSTRUMENT>
+class delayed_init : private detail::move_assignment_layer<
+  typename detail::storage_for<T, Storage, Instrument>::type>,
+  private detail::enable_special_members<T> {
+
+public:
+
+  static_assert(!std::is_rvalue_reference<T>::value, "instantiation of "
+    "delayed_init for rvalue reference type");
+
+  /**
+   * @brief Type of the inner object.
+   */
+  typedef T value_type;
+
+  /**
+   * @brief Whether delayed_init is trivially relocatable, i.e., whether its
+   * storage is (see traits::is_trivially_relocatable).
+   */
+  typedef traits::is_trivially_relocatable<typename
+    detail::storage_for<T, Storage, Instrument>::type> is_trivially_relocatable;
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  constexpr delayed_init() noexcept {
+  }
+
+  /**
+   * @brief Copy-constructor.
+   *
+   * If static_cast<bool>(src) == true, then *get() is copy-constructed from
+   * *src.get(). Trivial if T::T(const T&) is.
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Initialiser.
+   * @throw - Whatever T::T(const T&) throws.
+   */
+  delayed_init(const delayed_init& src) = default;
+
+  /**
+   * @brief Move-constructor.
+   *
+   * If static_cast<bool>(src) == true, then *get() is move-constructed from
+   * *src.get(). Trivial if T::T(T&&) is.
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Initialiser.
+   * @throw - Whatever T::T(T&&) throws.
+   */
+  delayed_init(delayed_init&& src) = default;
+
+  /**
+   * @brief Copy-constructor from delayed_init<U>.
+   *
+   * If static_cast<bool>(src) == true, then *get() is copy-constructed from
+   * *src.get().
+   * 
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Initialiser.
+   * @throw - Whatever T::T(const U&) throws.
+   */
+  template <typename U, typename S, typename C, typename I>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  delayed_init(const delayed_init<U, S, C, I>& src)
+    noexcept(std::is_nothrow_constructible<T, const U&>::value &&
+      is_nothrow_sentinel_check::value) {
+    if (src) {
+      this->init_obj(*src.get());
+      check_not_sentinel();
+    }
+  }
+
+  /**
+   * @brief Move-constructor from delayed_init<U>.
+   *
+   * If static_cast<bool>(src) == true, then *get() is copy- or move-constructed
+   * from *src.get().
+   * 
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Initialiser.
+   * @throw - Whatever T::T(U&&) throw.
+   */
+  template <typename U, typename S, typename C, typename I>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  delayed_init(delayed_init<U, S, C, I>&& src)
+    noexcept(std::is_nothrow_constructible<T, U&&>::value &&
+      is_nothrow_sentinel_check::value) {
+    if (src) {
+      this->init_obj(std::move(*src.get()));
+      check_not_sentinel();
+    }
+  }
+  
+  /**
+   * @brief Constructor from U.
+   *
+   * *get() is copy- or move-constructed from obj.
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param obj Initialiser.
+   * @throw - Whatever T::T(U&&) throw.
+   */
+  template <typename U, typename = typename std::enable_if<
+    !detail::is_delayed_init<typename std::decay<U>::type>::value &&
+    std::is_constructible<T, U&&>::value>::type>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR explicit delayed_init(U&& obj)
+    noexcept(std::is_nothrow_constructible<T, U&&>::value &&
+      is_nothrow_sentinel_check::value) {
+    this->init_obj(std::forward<U>(obj));
+    check_not_sentinel();
+  }
+
+  /**
+   * @brief Destructor.
+   *
+   * T:~T() must not throw. Trivial if T::~T() is.
+   *
+   * @throw - Nothing.
+   */
+  ~delayed_init() = default;
+
+  /**
+   * @brief Copy-assignment.
+   *
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
+   * then *get() is copy-assigned to *src.get().
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
+   * then *get() is destroyed.
+   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
+   * then *get() is copy-constructed from *src.get().
+   * Trivial if T::T(const T&), T::operator=(const T&) and T::~T() are.
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(const T&) and T::operator=(const T&) throw.
+   */
+  delayed_init& operator=(const delayed_init& src) = default;
+
+  /**
+   * @brief Move-assignment.
+   *
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
+   * then *get() is move-assigned to *src.get().
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
+   * then *get() is destroyed.
+   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
+   * then *get() is move-constructed from *src.get().
+   * Trivial if T::T(T&&), T::operator=(T&&) and T::~T() are.
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(T&&) and T::operator=(T&&) throw.
+   */
+  delayed_init& operator=(delayed_init&& src) = default;
+  
+  /**
+   * @brief Copy-assignment to delayed_init<U>.
+   *
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
+   * then *get() is copy-assigned to *src.get().
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
+   * then *get() is destroyed.
+   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
+   * then *get() is copy-constructed from *src.get().
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(const U&) and T::operator=(const U&) throw.
+   */
+  template <typename U, typename S, typename C, typename I>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  delayed_init& operator=(const delayed_init<U, S, C, I>& src)
+    noexcept(
+      std::is_nothrow_constructible<T, const U&>::value &&
+      std::is_nothrow_assignable<T, const U&>::value &&
+      is_nothrow_sentinel_check::value
+    ) {
+    if (src)
+      assign(*src.get());
+    else
+      destroy();
+    return *this;
+  }
+
+  /**
+   * @brief Move-assignment to delayed_init<U>.
+   *
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
+   * then *get() is copy- or move-assigned to *src.get().
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
+   * then *get() is destroyed.
+   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
+   * then *get() is copy- or move-constructed from *src.get().
+   *
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(U&&) and T::operator=(U&&) throw.
+   */
+  template <typename U, typename S, typename C, typename I>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  delayed_init& operator=(delayed_init<U, S, C, I>&& src)
+    noexcept(
+      std::is_nothrow_constructible<T, U&&>::value &&
+      std::is_nothrow_assignable<T, U&&>::value &&
+      is_nothrow_sentinel_check::value
+    ) {
+    if (src)
+      assign(std::move(*src.get()));
+    else
+      destroy();
+    return *this;
+  }
+
+  /**
+   * @brief Assignment to U.
+   *
+   * If static_cast<bool>(*this) == true, then *get() is copy- or move-assigned
+   * to obj. Othwerwise, *get() is copy- or move-constructed from obj.
+   *
+   * @pre std::is_convertible<U, T>::value == true.
+   * @post static_cast<bool>(*this) == static_cast<bool>(src) &&
+   * (get() == nullptr) == (src.get() == nullptr).
+   * @param obj Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(U&&) and T::operator=(U&&) throw.
+   */
+  template <typename U, typename = typename std::enable_if<
+    !detail::is_delayed_init<typename std::decay<U>::type>::value &&
+    std::is_convertible<U, T>::value>::type>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR delayed_init& operator=(U&& obj)
+    noexcept(
+      std::is_nothrow_constructible<T, U&&>::value &&
+      std::is_nothrow_assignable<T, U&&>::value &&
+      is_nothrow_sentinel_check::value
+    ) {
+    assign(std::forward<U>(obj));
+    return *this;
+  }
+  
+  /**
+   * @brief Indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& operator*() noexcept(Check::is_nothrow) {
+    if (!this->is_init())
+      fail("attempt to use uninitialised object");
+    return *this->obj();
+  } 
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  const T& operator*() const noexcept(Check::is_nothrow) {
+    if (!this->is_init())
+      fail("attempt to use uninitialised object");
+    return *this->obj();
+  } 
+
+  /**
+   * @brief Unchecked indirection.
+   *
+   * The pre-condition is not checked but the optimiser assumes it holds.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& value_unchecked() noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(this->is_init());
+    return *this->obj();
+  }
+
+  /**
+   * @brief Unchecked indirection (const).
+   *
+   * The pre-condition is not checked but the optimiser assumes it holds.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR const T& value_unchecked() const noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(this->is_init());
+    return *this->obj();
+  }
+
+  /**
+   * @brief Value or fallback.
+   *
+   * The result refers to fallback (not to a copy) when static_cast<bool>(*this)
+   * == false. Hence, it must not be used after fallback is destroyed (e.g. when
+   * fallback is a temporary).
+   *
+   * @param fallback Fallback.
+   * @return *get() if static_cast<bool>(*this) == true. Otherwise, fallback.
+   * @throw - Nothing.
+   */
+  const T& value_or(const T& fallback) const noexcept {
+    return this->is_init() ? *this->obj() : fallback;
+  }
+
+  /**
+   * @brief Value or fallback (non-const).
+   *
+   * @param fallback Fallback.
+   * @return *get() if static_cast<bool>(*this) == true. Otherwise, fallback.
+   * @throw - Nothing.
+   */
+  T& value_or(T& fallback) noexcept {
+    return this->is_init() ? *this->obj() : fallback;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T* get() noexcept {
+    return this->is_init() ? this->obj() : nullptr;
+  }
+  
+  /**
+   * @brief Getter (const).
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise nullptr.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR const T* get() const noexcept {
+    return this->is_init() ? this->obj() : nullptr;
+  }
+  
+  /**
+   * @brief Deference.
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T* operator->() noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Deference (const).
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR const T* operator->() const noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the inner object was not initialised. Otherwise, true.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR explicit operator bool() const noexcept {
+    return this->is_init();
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds inner object by forwarding arguments to T's constructor.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return *get().
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& init(Args&&... args) {
+    if (this->is_init())
+      fail("second attempt to initialise object");
+    this->init_obj(std::forward<Args>(args)...);
+    check_not_sentinel();
+    return *this->obj();
+  }
+
+  /**
+   * @brief Initialiser from factory.
+   *
+   * Builds inner object from the result of f(). From C++17, if f() returns a
+   * prvalue of type T (possibly cv-qualified), then the object is built
+   * directly in place, with no copy or move. (This works even for types that
+   * are neither copyable nor movable.)
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param f Factory.
+   * @return *get().
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  T& init_with(F&& f) {
+    if (this->is_init())
+      fail("second attempt to initialise object");
+    this->init_obj_with(std::forward<F>(f));
+    check_not_sentinel();
+    return *this->obj();
+  }
+
+  /**
+   * @brief Handle to the memory of an object under construction.
+   *
+   * Obtained from construct_in(), it gives the caller (e.g. a decoder) the
+   * memory where the inner object is to be built. Once the object exists, the
+   * caller calls commit() and the delayed_init object becomes initialised.
+   * Otherwise, when the handle is destroyed (e.g. because the decoder threw),
+   * the memory is released and the delayed_init object remains uninitialised.
+   *
+   * For trivially copyable T, writing sizeof(T) bytes to data() builds the
+   * object. Otherwise, the object must be built by placement new (and commit()
+   * must be called before anything else can throw since the handle never
+   * destroys the object).
+   *
+   * The delayed_init object must not be used while the handle is alive.
+   */
+  class construction {
+
+  public:
+
+    construction(const construction&) = delete;
+
+    construction& operator=(const construction&) = delete;
+
+    /**
+     * @brief Move-constructor.
+     *
+     * The ownership of the memory is transferred to *this.
+     *
+     * @throw - Nothing.
+     */
+    construction(construction&& other) noexcept : owner_(other.owner_),
+      ptr_(other.ptr_) {
+      other.owner_ = nullptr;
+    }
+
+    construction& operator=(construction&&) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Releases the memory unless commit() was called.
+     */
+    ~construction() noexcept {
+      if (owner_)
+        owner_->cancel_obj(ptr_);
+    }
+
+    /**
+     * @brief Memory where the object is to be built.
+     *
+     * @return A pointer to sizeof(T) bytes aligned to alignof(T).
+     * @throw - Nothing.
+     */
+    void* data() const noexcept {
+      return ptr_;
+    }
+
+    /**
+     * @brief Typed pointer to the memory where the object is to be built.
+     *
+     * @return static_cast<T*>(data()).
+     * @throw - Nothing.
+     */
+    T* get() const noexcept {
+      return static_cast<T*>(ptr_);
+    }
+
+    /**
+     * @brief Commit the object.
+     *
+     * @pre commit() has not been called and the object has been built.
+     * @post The delayed_init object is initialised and its inner object is
+     * *get().
+     * @return *get().
+     * @throw - std::logic_error (if the object is the sentinel of
+     * storage::niche and Check is check::exception). In this case, the
+     * delayed_init object is uninitialised.
+     */
+    T& commit() noexcept(Check::is_nothrow) {
+      delayed_init* owner = owner_;
+      owner_->commit_obj(ptr_);
+      owner_ = nullptr;
+      owner->check_not_sentinel();
+      return *get();
+    }
+
+  private:
+
+    friend class delayed_init;
+
+    explicit construction(delayed_init& owner) : owner_(&owner),
+      ptr_(owner.prepare_obj()) {
+    }
+
+    delayed_init* owner_;
+    void*         ptr_;
+
+  }; // class construction
+
+  /**
+   * @brief Start building the inner object in place.
+   *
+   * No object is built: the caller builds it in the memory given by the
+   * returned handle (see construction).
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @return The handle.
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever the storage's allocation throws.
+   */
+  construction construct_in() {
+    if (this->is_init())
+      fail("second attempt to initialise object");
+    return construction(*this);
+  }
+
+  /**
+   * @brief Initialiser from bytes.
+   *
+   * Copies the bytes directly into the storage. There's no intermediate T.
+   *
+   * @pre static_cast<bool>(*this) == false && n == sizeof(T).
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param bytes Pointer to the object representation of T.
+   * @param n Number of bytes.
+   * @return *get().
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever the storage's allocation throws.
+   */
+  T& init_from_bytes(const void* bytes, std::size_t n) {
+    static_assert(std::is_trivially_copyable<T>::value, "init_from_bytes() "
+      "requires a trivially copyable type");
+    if (n != sizeof(T))
+      fail("size mismatch in initialisation from bytes");
+    construction c = construct_in();
+    std::memcpy(c.data(), bytes, sizeof(T));
+    return c.commit();
+  }
+
+  /**
+   * @brief Emplace.
+   *
+   * Destroys the inner object (if initialised) and then builds a new one by
+   * forwarding arguments to T's constructor.
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return *get().
+   * @throw - Whatever T::T(Args&&...) throws. In this case,
+   * static_cast<bool>(*this) == false.
+   */
+  template <typename... Args>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& emplace(Args&&... args) {
+    destroy();
+    this->init_obj(std::forward<Args>(args)...);
+    check_not_sentinel();
+    return *this->obj();
+  }
+
+  /**
+   * @brief Unchecked initialiser.
+   *
+   * Builds inner object by forwarding arguments to T's constructor. The
+   * pre-condition is not checked but the optimiser assumes it holds.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return *get().
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& init_unchecked(Args&&... args) {
+    OVERLOAD_DELAYED_INIT_ASSUME(!this->is_init());
+    this->init_obj(std::forward<Args>(args)...);
+    return *this->obj();
+  }
+  
+  /**
+   * @brief Swap.
+   *
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == true,
+   * then *get() and *src.get() are swapped.
+   * If static_cast<bool>(*this) == true and static_cast<bool>(src) == false,
+   * then *get() is moved to src.get() and then destroyed.
+   * If static_cast<bool>(*this) == false and static_cast<bool>(src) == true,
+   * then *src.get() is moved to *get() and destroyed.
+   *
+   * @param src Source.
+   * @throw - Whatever T::T(T&&) and swap(T&, T&) throw.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void swap(delayed_init& src)
+    noexcept(
+      std::is_nothrow_move_constructible<T>::value &&
+      traits::is_nothrow_swappable<T>::value
+    ) {
+    if (this->is_init()) {
+      if (src.is_init()) {
+        
+        using std::swap;
+        swap(*this->obj(), *src.obj());
+      }
+      else {
+        src.init_obj(std::move(*this->obj()));
+        destroy();
+      }
+    }
+    else if (src.is_init()) {
+      this->init_obj(std::move(*src.obj()));
+      src.destroy();
+    }
+  }
+
+  /**
+   * @brief Transform in place.
+   *
+   * Calls f(*get()) if static_cast<bool>(*this) == true.
+   *
+   * @param f Function (which might modify its argument).
+   * @return static_cast<bool>(*this).
+   * @throw - Whatever f() throws.
+   */
+  template <typename F>
+  bool transform_in_place(F&& f) {
+    if (!this->is_init())
+      return false;
+    std::forward<F>(f)(*this->obj());
+    return true;
+  }
+
+  /**
+   * @brief Transform.
+   *
+   * If static_cast<bool>(*this) == true, then the result holds an object of
+   * type U built from f(*get()). From C++17, if f returns a prvalue of type U,
+   * then it's built directly in the result with no copy or move.
+   *
+   * @param f Function.
+   * @return A delayed_init<U> holding f(*get()) if static_cast<bool>(*this) ==
+   * true. Otherwise, an uninitialised delayed_init<U>.
+   * @throw - Whatever f() and U's constructor throw.
+   */
+  template <typename F,
+    typename U = detail::transform_result<F, const T&>>
+  delayed_init<U, storage::flag, Check, Instrument> transform(F&& f) const & {
+    return transform_impl<const T&>(this->obj(), std::forward<F>(f));
+  }
+
+  /**
+   * @brief Transform (non-const).
+   *
+   * See transform(F&&) const &.
+   */
+  template <typename F,
+    typename U = detail::transform_result<F, T&>>
+  delayed_init<U, storage::flag, Check, Instrument> transform(F&& f) & {
+    return transform_impl<T&>(this->obj(), std::forward<F>(f));
+  }
+
+  /**
+   * @brief Transform (rvalue).
+   *
+   * See transform(F&&) const &. The inner object is passed to f as an rvalue.
+   */
+  template <typename F,
+    typename U = detail::transform_result<F, T&&>>
+  delayed_init<U, storage::flag, Check, Instrument> transform(F&& f) && {
+    return transform_impl<T&&>(this->obj(), std::forward<F>(f));
+  }
+
+  /**
+   * @brief Chain an operation that might not produce a value.
+   *
+   * @param f Function returning a delayed_init object.
+   * @return f(*get()) if static_cast<bool>(*this) == true. Otherwise, an
+   * uninitialised object of the same type.
+   * @throw - Whatever f() throws.
+   */
+  template <typename F,
+    typename R = detail::transform_result<F, const T&>>
+  R and_then(F&& f) const & {
+    static_assert(detail::is_delayed_init<R>::value, "and_then() requires a "
+      "function returning a delayed_init");
+    return this->is_init() ? std::forward<F>(f)(*this->obj()) : R();
+  }
+
+  /**
+   * @brief Chain an operation that might not produce a value (non-const).
+   *
+   * See and_then(F&&) const &.
+   */
+  template <typename F,
+    typename R = detail::transform_result<F, T&>>
+  R and_then(F&& f) & {
+    static_assert(detail::is_delayed_init<R>::value, "and_then() requires a "
+      "function returning a delayed_init");
+    return this->is_init() ? std::forward<F>(f)(*this->obj()) : R();
+  }
+
+  /**
+   * @brief Chain an operation that might not produce a value (rvalue).
+   *
+   * See and_then(F&&) const &. The inner object is passed to f as an rvalue.
+   */
+  template <typename F,
+    typename R = detail::transform_result<F, T&&>>
+  R and_then(F&& f) && {
+    static_assert(detail::is_delayed_init<R>::value, "and_then() requires a "
+      "function returning a delayed_init");
+    return this->is_init() ? std::forward<F>(f)(std::move(*this->obj())) : R();
+  }
+
+  /**
+   * @brief Take the inner object.
+   *
+   * Moves the inner object out and then destroys it.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @return The inner object.
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever T::T(T&&) throws. In this case, *this is
+   * unchanged.
+   */
+  T take() {
+    if (!this->is_init())
+      fail("attempt to use uninitialised object");
+    T obj(std::move(*this->obj()));
+    this->destroy_obj();
+    return obj;
+  }
+
+  /**
+   * @brief Recycle inner object.
+   *
+   * Makes *this uninitialised. For storage::recyclable, the inner object is
+   * cleared (see recycle_traits) and kept alive to be reused by the next
+   * initialisation. For other storages, it is destroyed.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  void recycle() noexcept {
+    destroy();
+  }
+
+  /**
+   * @brief Relocate.
+   *
+   * Moves the inner object (if initialised) to dst and leaves *this
+   * uninitialised. If traits::is_trivially_relocatable<delayed_init>::value ==
+   * true, then the bytes of *this (object and state) are copied in one step
+   * and no constructor or destructor of T is called. Otherwise, *dst.get() is
+   * move-constructed from *get() which is then destroyed.
+   *
+   * @pre static_cast<bool>(dst) == false && &dst != this.
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @param dst Destination.
+   * @throw - Whatever T::T(T&&) throws.
+   */
+  void relocate_to(delayed_init& dst)
+    noexcept(is_trivially_relocatable::value ||
+      std::is_nothrow_move_constructible<T>::value) {
+    relocate_to(dst, is_trivially_relocatable());
+  }
+
+private:
+
+  template <typename, typename, typename, typename>
+  friend class delayed_init;
+
+  friend struct detail::inner_access;
+
+  typedef typename Storage::template type<T> primitive_storage;
+
+  typedef std::integral_constant<bool, Check::is_nothrow ||
+    !detail::has_sentinel<primitive_storage>::value> is_nothrow_sentinel_check;
+
+  /**
+   * @brief Constructor from factory.
+   *
+   * *get() is built from the result of f().
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param f Factory.
+   * @throw - Whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  delayed_init(detail::with_factory_t, F&& f) {
+    this->init_obj_with(std::forward<F>(f));
+  }
+
+  /**
+   * @brief Implementation of transform().
+   *
+   * @tparam A Type as which the inner object is passed to f.
+   * @param obj Pointer to the inner object (dereferenced only if *this is
+   * initialised).
+   * @param f Function.
+   * @return A delayed_init holding f(static_cast<A>(*obj)).
+   */
+  template <typename A, typename P, typename F,
+    typename U = detail::transform_result<F, A>>
+  delayed_init<U, storage::flag, Check, Instrument> transform_impl(P obj,
+    F&& f) const {
+    typedef delayed_init<U, storage::flag, Check, Instrument> result;
+    return this->is_init() ? result(detail::with_factory_t(),
+      detail::bound_call<U, F, A>{std::forward<F>(f), static_cast<A&&>(*obj)})
+      : result();
+  }
+
+  /**
+   * @brief Reports a pre-condition violation.
+   *
+   * @param what Description of the violation.
+   * @throw - Whatever Check::fail() throws.
+   */
+  static OVERLOAD_DELAYED_INIT_CONSTEXPR void fail(const char* what)
+    noexcept(Check::is_nothrow) {
+    Instrument::record(instrument::failed_check);
+    Check::fail(what);
+  }
+
+  /**
+   * @brief Reports a new value equal to the sentinel of the storage.
+   *
+   * Called after the inner object has been built or assigned. The check is
+   * compiled out for storages without sentinel (see detail::has_sentinel).
+   *
+   * @throw - Whatever Check::fail() throws.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void check_not_sentinel()
+    noexcept(Check::is_nothrow) {
+    if (detail::has_sentinel<primitive_storage>::value && !this->is_init())
+      fail("attempt to initialise object with the sentinel");
+  }
+
+  /**
+   * @brief Assign *this to an object.
+   *
+   * If static_cast<bool>(*this) == true, then *get() is assigned to src_obj.
+   * Otherwise, *get() is constructed from src_obj.
+   *
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param src_obj Assignment source.
+   * @throw - Whatever T::T(U&&) and T::operator =(U&&) throw.
+   */
+  template <typename U>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void assign(U&& src_obj) {
+    if (this->is_init())
+      this->assign_obj(std::forward<U>(src_obj));
+    else
+      this->init_obj(std::forward<U>(src_obj));
+    check_not_sentinel();
+  }
+
+  /**
+   * @brief Destroy inner object.
+   *
+   * T:~T() must not throw.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void destroy() noexcept {
+    if (this->is_init())
+      this->destroy_obj();
+  }
+
+  /**
+   * @brief Relocate by copying bytes.
+   *
+   * @pre static_cast<bool>(dst) == false.
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @param dst Destination.
+   * @throw - Nothing.
+   */
+  void relocate_to(delayed_init& dst, std::true_type) noexcept {
+    std::memcpy(static_cast<void*>(&dst), static_cast<const void*>(this),
+      sizeof(delayed_init));
+    new ((void *) this) delayed_init();
+  }
+
+  /**
+   * @brief Relocate by move-construction and destruction.
+   *
+   * @pre static_cast<bool>(dst) == false.
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @param dst Destination.
+   * @throw - Whatever T::T(T&&) throws.
+   */
+  void relocate_to(delayed_init& dst, std::false_type) {
+    if (this->is_init()) {
+      dst.init_obj(std::move(*this->obj()));
+      this->destroy_obj();
+    }
+  }
+
+}; // class delayed_init
+
+/**
+ * @brief delayed_init for references: a rebindable pointer-sized slot.
+ *
+ * Class delayed_init<T&> holds a reference to T whose binding is delayed until
+ * init() is called. Only a pointer to the referee is stored and nullptr marks
+ * the uninitialised state. Hence, the class is trivially copyable and as large
+ * as a pointer. Copies refer to the same object and emplace() rebinds. Binding
+ * to rvalues is prevented. Comparisons and hashing are on the referees.
+ *
+ * The policies Check and Instrument are as for delayed_init<T> (only checks
+ * are instrumented since there's no object to construct or destroy) and
+ * Storage is ignored.
+ */
+template <typename T, typename Storage, typename Check, typename Instrument>
+class delayed_init<T&, Storage, Check, Instrument> {
+
+public:
+
+  typedef T& value_type;
+
+  /**
+   * @brief Type (std::true_type) indicating that delayed_init<T&> is
+   * trivially relocatable.
+   */
+  typedef std::true_type is_trivially_relocatable;
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  constexpr delayed_init() noexcept : ptr_(nullptr) {
+  }
+
+  /**
+   * @brief Constructor from referee.
+   *
+   * @post get() == &obj.
+   * @param obj Referee.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR explicit delayed_init(T& obj) noexcept :
+    ptr_(std::addressof(obj)) {
+  }
+
+  explicit delayed_init(T&&) = delete;
+
+  /**
+   * @brief Converting constructor (e.g., from delayed_init<Derived&> to
+   * delayed_init<Base&>).
+   *
+   * @post get() == src.get().
+   * @param src Source.
+   * @throw - Nothing.
+   */
+  template <typename U, typename S, typename C, typename I,
+    typename = typename std::enable_if<
+      std::is_convertible<U*, T*>::value>::type>
+  OVERLOAD_DELAYED_INIT_CONSTEXPR
+  delayed_init(const delayed_init<U&, S, C, I>& src) noexcept :
+    ptr_(src.get()) {
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& operator*() const
+    noexcept(Check::is_nothrow) {
+    if (!ptr_)
+      fail("attempt to use uninitialised object");
+    return *ptr_;
+  }
+
+  /**
+   * @brief Unchecked indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& value_unchecked() const noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(ptr_ != nullptr);
+    return *ptr_;
+  }
+
+  /**
+   * @brief Referee or fallback.
+   *
+   * @param fallback Object returned if *this is uninitialised.
+   * @return *get() if static_cast<bool>(*this) == true. Otherwise, fallback.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& value_or(T& fallback) const noexcept {
+    return ptr_ ? *ptr_ : fallback;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the referee if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  constexpr T* get() const noexcept {
+    return ptr_;
+  }
+
+  /**
+   * @brief Dereference.
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  constexpr T* operator->() const noexcept {
+    return ptr_;
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the reference is not bound. Otherwise, true.
+   * @throw - Nothing.
+   */
+  constexpr explicit operator bool() const noexcept {
+    return ptr_ != nullptr;
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post get() == &obj.
+   * @param obj Referee.
+   * @return obj.
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& init(T& obj) noexcept(Check::is_nothrow) {
+    if (ptr_)
+      fail("second attempt to initialise object");
+    ptr_ = std::addressof(obj);
+    return obj;
+  }
+
+  void init(T&&) = delete;
+
+  /**
+   * @brief Unchecked initialiser.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post get() == &obj.
+   * @param obj Referee.
+   * @return obj.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& init_unchecked(T& obj) noexcept {
+    ptr_ = std::addressof(obj);
+    return obj;
+  }
+
+  void init_unchecked(T&&) = delete;
+
+  /**
+   * @brief Rebinder.
+   *
+   * @post get() == &obj.
+   * @param obj Referee.
+   * @return obj.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR T& emplace(T& obj) noexcept {
+    ptr_ = std::addressof(obj);
+    return obj;
+  }
+
+  void emplace(T&&) = delete;
+
+  /**
+   * @brief Swaps bindings.
+   *
+   * @param src Object to swap with.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void swap(delayed_init& src) noexcept {
+    T* const ptr = ptr_;
+    ptr_ = src.ptr_;
+    src.ptr_ = ptr;
+  }
+
+  /**
+   * @brief Unbinds.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  OVERLOAD_DELAYED_INIT_CONSTEXPR void recycle() noexcept {
+    ptr_ = nullptr;
+  }
+
+private:
+
+  static OVERLOAD_DELAYED_INIT_CONSTEXPR void fail(const char* what)
+    noexcept(Check::is_nothrow) {
+    Instrument::record(instrument::failed_check);
+    Check::fail(what);
+  }
+
+  T* ptr_;
+
+}; // class delayed_init<T&>
+
+namespace detail {
+
+/**
+ * @brief Relocate [first, last) to d_first by copying bytes.
+ */
+template <typename D>
+D* relocate(D* first, D* last, D* d_first, std::true_type) noexcept {
+  if (first != last)
+    std::memmove(static_cast<void*>(d_first), static_cast<const void*>(first),
+      (last - first) * sizeof(D));
+  return d_first + (last - first);
+}
+
+/**
+ * @brief Destroys the ranges of an interrupted relocation unless released.
+ */
+template <typename D>
+class relocation_guard {
+
+public:
+
+  relocation_guard(D*& first, D* last, D* d_first, D*& d_last) noexcept :
+    first_(first), last_(last), d_first_(d_first), d_last_(d_last),
+    released_(false) {
+  }
+
+  ~relocation_guard() noexcept {
+    if (released_)
+      return;
+    for (; d_first_ != d_last_; ++d_first_)
+      d_first_->~D();
+    for (; first_ != last_; ++first_)
+      first_->~D();
+  }
+
+  void release() noexcept {
+    released_ = true;
+  }
+
+private:
+
+  D*& first_;
+  D*  last_;
+  D*  d_first_;
+  D*& d_last_;
+  bool released_;
+
+}; // class relocation_guard
+
+/**
+ * @brief Relocate [first, last) to d_first by move-construction and
+ * destruction.
+ */
+template <typename D>
+D* relocate(D* first, D* last, D* d_first, std::false_type) {
+  D* d_last = d_first;
+  relocation_guard<D> guard(first, last, d_first, d_last);
+  for (; first != last; ++first, ++d_last) {
+    new ((void *) d_last) D(std::move(*first));
+    first->~D();
+  }
+  guard.release();
+  return d_last;
+}
+
+} // namespace detail
+
+namespace traits {
+
+/**
+ * @brief delayed_init<T, S, C, I> is trivially relocatable when its storage is.
+ *
+ * This is the case for storage::flag, storage::flag_after and storage::niche if
+ * T is trivially relocatable and always for storage::out_of_line. Wrapping
+ * in storage::aligned preserves it.
+ */
+template <typename T, typename S, typename C, typename I>
+struct is_trivially_relocatable<delayed_init<T, S, C, I>> :
+  public delayed_init<T, S, C, I>::is_trivially_relocatable {
+};
+
+} // namespace traits
+
+/**
+ * @brief Relocate a range of delayed_init objects to uninitialised memory.
+ *
+ * Relocates the objects in [first, last) to the memory starting at d_first
+ * which must be suitable for last - first objects. On return, the objects in
+ * [first, last) have ceased to exist and must not be destroyed (their memory
+ * might be freed or reused) while the ones in [d_first, d_first + (last -
+ * first)) are alive. If delayed_init<T, S, C, I> is trivially relocatable, then
+ * this is a single memmove (and the ranges might overlap). Otherwise, each
+ * object is move-constructed to its destination and then destroyed (and the
+ * ranges must not overlap).
+ *
+ * @param first Beginning of source range.
+ * @param last End of source range.
+ * @param d_first Beginning of destination.
+ * @return d_first + (last - first).
+ * @throw - Whatever T::T(T&&) throws. In this case, all objects in both ranges
+ * are destroyed.
+ */
+template <typename T, typename S, typename C, typename I>
+delayed_init<T, S, C, I>* relocate(delayed_init<T, S, C, I>* first,
+  delayed_init<T, S, C, I>* last, void* d_first)
+  noexcept(delayed_init<T, S, C, I>::is_trivially_relocatable::value ||
+    std::is_nothrow_move_constructible<T>::value) {
+  return detail::relocate(first, last, static_cast<delayed_init<T, S, C, I>*>(
+    d_first), typename delayed_init<T, S, C, I>::is_trivially_relocatable());
+}
+
+/**
+ * @brief Swap two delayed_init objects.
+ *
+ * @param d1 1st delayed_init object.
+ * @param d2 2nd delayed_init object.
+ *
+ * @throw - Whatever d1.swap(d2) throws.
+ */
+template <typename T, typename S, typename C, typename I>
+OVERLOAD_DELAYED_INIT_CONSTEXPR
+void swap(delayed_init<T, S, C, I>& d1, delayed_init<T, S, C, I>& d2)
+  noexcept(noexcept(d1.swap(d2))) {
+  d1.swap(d2);
+}
+
+namespace detail {
+
+/**
+ * @brief Access to the inner object regardless of initialisation.
+ */
+struct inner_access {
+
+  /**
+   * @brief Whether the inner object of D can always be read.
+   */
+  template <typename D>
+  struct is_readable : public has_readable_obj<typename D::primitive_storage> {
+  };
+
+  /**
+   * @brief Copy of the bytes of the inner object.
+   *
+   * @pre is_readable<D>::value == true.
+   */
+  template <typename D>
+  static typename std::remove_const<typename D::value_type>::type
+  read(const D& d) noexcept {
+    typename std::remove_const<typename D::value_type>::type obj;
+    std::memcpy(&obj, d.obj(), sizeof(obj));
+    return obj;
+  }
+
+  /**
+   * @brief Destroys the inner object, if any (for helpers undoing
+   * initialisations).
+   *
+   * @post static_cast<bool>(d) == false.
+   */
+  template <typename D>
+  static void destroy(D& d) noexcept {
+    d.destroy();
+  }
+};
+
+/**
+ * @brief Whether X is handled by branch-free algorithms.
+ *
+ * This is the case for arithmetic types and delayed_init of arithmetic types
+ * whose inner object can always be read.
+ */
+template <typename X>
+struct is_branch_free : public std::is_arithmetic<X> {
+};
+
+template <typename T, typename S, typename C, typename I>
+struct is_branch_free<delayed_init<T, S, C, I>> :
+  public std::integral_constant<bool, std::is_arithmetic<T>::value &&
+    inner_access::is_readable<delayed_init<T, S, C, I>>::value> {
+};
+
+template <typename T, typename S, typename C, typename I>
+struct is_branch_free<delayed_init<T&, S, C, I>> : public std::false_type {
+};
+
+/**
+ * @brief Whether both A and B are handled by branch-free algorithms.
+ */
+template <typename A, typename B>
+using are_branch_free = std::integral_constant<bool,
+  is_branch_free<A>::value && is_branch_free<B>::value>;
+
+/**
+ * @brief Enables non-member comparisons between delayed_init and U values.
+ */
+template <typename U>
+using if_not_delayed_init = typename std::enable_if<
+  !is_delayed_init<U>::value, bool>::type;
+
+/**
+ * @brief Compare two possibly missing objects.
+ *
+ * If both a and b are not null, then the result is op(*a, *b). Otherwise, it's
+ * op(a != nullptr, b != nullptr), that is, a missing object is smaller than
+ * any other and equal to another missing object (as for std::optional).
+ *
+ * @param op Comparison.
+ * @param a Pointer to 1st object (or nullptr if missing).
+ * @param b Pointer to 2nd object (or nullptr if missing).
+ */
+template <typename Op, typename A, typename B>
+bool compare(Op op, const A* a, const B* b) {
+  return a && b ? op(*a, *b) : op(a != nullptr, b != nullptr);
+}
+
+/**
+ * @brief Compare two possibly missing objects of arithmetic types.
+ *
+ * As above but x and y are always read (and ignored when missing) and results
+ * are combined with bitwise operations. Hence, there's no data-dependent
+ * branch, which matters when comparing mixed data (e.g. when sorting).
+ *
+ * @param op Comparison.
+ * @param has_a Whether the 1st object is present.
+ * @param x 1st object (or any value if missing).
+ * @param has_b Whether the 2nd object is present.
+ * @param y 2nd object (or any value if missing).
+ */
+template <typename Op, typename A, typename B>
+bool compare(Op op, bool has_a, A x, bool has_b, B y) {
+  const bool both = has_a & has_b;
+  return (both & op(x, y)) | (!both & op(has_a, has_b));
+}
+
+/**
+ * @brief Compare two delayed_init objects.
+ */
+template <typename Op, typename D1, typename D2>
+bool compare(Op op, const D1& d1, const D2& d2, std::false_type) {
+  return compare(op, d1.get(), d2.get());
+}
+
+template <typename Op, typename D1, typename D2>
+bool compare(Op op, const D1& d1, const D2& d2, std::true_type) {
+  return compare(op, static_cast<bool>(d1), inner_access::read(d1),
+    static_cast<bool>(d2), inner_access::read(d2));
+}
+
+/**
+ * @brief Compare a delayed_init and a value.
+ */
+template <typename Op, typename D, typename U>
+bool compare_with_value(Op op, const D& d, const U& v, std::false_type) {
+  return compare(op, d.get(), &v);
+}
+
+template <typename Op, typename D, typename U>
+bool compare_with_value(Op op, const D& d, const U& v, std::true_type) {
+  return compare(op, static_cast<bool>(d), inner_access::read(d), true, v);
+}
+
+/**
+ * @brief Compare a value and a delayed_init.
+ */
+template <typename Op, typename U, typename D>
+bool compare_value_with(Op op, const U& v, const D& d, std::false_type) {
+  return compare(op, &v, d.get());
+}
+
+template <typename Op, typename U, typename D>
+bool compare_value_with(Op op, const U& v, const D& d, std::true_type) {
+  return compare(op, true, v, static_cast<bool>(d), inner_access::read(d));
+}
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+
+/**
+ * @brief Hash of a missing object (as libstdc++'s std::optional).
+ */
+constexpr std::size_t uninitialised_hash = static_cast<std::size_t>(-3333);
+
+/**
+ * @brief Hash of a delayed_init.
+ *
+ * @return std::hash<V>()(*d) if d is initialised. Otherwise,
+ * uninitialised_hash.
+ */
+template <typename D>
+std::size_t hash(const D& d, std::false_type) {
+  typedef typename std::decay<typename D::value_type>::type value_type;
+  return d ? std::hash<value_type>()(*d) : uninitialised_hash;
+}
+
+/**
+ * @brief Hash of a delayed_init (branch-free).
+ *
+ * As above but the inner object is always hashed and the result is selected
+ * by a mask.
+ */
+template <typename D>
+std::size_t hash(const D& d, std::true_type) {
+  typedef typename std::remove_const<typename D::value_type>::type value_type;
+  const std::size_t h    = std::hash<value_type>()(inner_access::read(d));
+  const std::size_t mask = -static_cast<std::size_t>(!d);
+  return h ^ (mask & (h ^ uninitialised_hash));
+}
+
+#endif // OVERLOAD_DELAYED_INIT_LEAN
+
+} // namespace detail
+
+/*
+ * Comparisons.
+ *
+ * Each operator @ in ==, !=, <, <=, > and >= is overloaded for two delayed_init
+ * objects, for a delayed_init object and a value and for a value and a
+ * delayed_init object. A value compares as if it was held by an initialised
+ * delayed_init object (see delayed_init for the ordering). For arithmetic
+ * types, the result is computed without data-dependent branches. Overloads
+ * throw whatever the comparison of inner objects throws.
+ *
+ * OVERLOAD_DELAYED_INIT_COMPARISON(@, name) defines the three overloads of @
+ * and detail::name, a function object calling @.
+ */
+#define OVERLOAD_DELAYED_INIT_COMPARISON(OP, NAME)                             \
+                                                                               \
+namespace detail {                                                             \
+                                                                               \
+struct NAME {                                                                  \
+  template <typename A, typename B>                                            \
+  constexpr bool operator()(const A& a, const B& b) const {                    \
+    return a OP b;                                                             \
+  }                                                                            \
+};                                                                             \
+                                                                               \
+} /* namespace detail */                                                       \
+                                                                               \
+template <typename T, typename S1, typename C1, typename I1,                   \
+  typename U, typename S2, typename C2, typename I2>                           \
+bool operator OP(const delayed_init<T, S1, C1, I1>& d1,                        \
+  const delayed_init<U, S2, C2, I2>& d2) {                                     \
+  return detail::compare(detail::NAME(), d1, d2,                               \
+    detail::are_branch_free<delayed_init<T, S1, C1, I1>,                       \
+    delayed_init<U, S2, C2, I2>>());                                           \
+}                                                                              \
+                                                                               \
+template <typename T, typename S, typename C, typename I, typename U>          \
+detail::if_not_delayed_init<U> operator OP(const delayed_init<T, S, C, I>& d,  \
+  const U& v) {                                                                \
+  return detail::compare_with_value(detail::NAME(), d, v,                      \
+    detail::are_branch_free<delayed_init<T, S, C, I>, U>());                   \
+}                                                                              \
+                                                                               \
+template <typename T, typename S, typename C, typename I, typename U>          \
+detail::if_not_delayed_init<U> operator OP(const U& v,                         \
+  const delayed_init<T, S, C, I>& d) {                                         \
+  return detail::compare_value_with(detail::NAME(), v, d,                      \
+    detail::are_branch_free<delayed_init<T, S, C, I>, U>());                   \
+}
+
+OVERLOAD_DELAYED_INIT_COMPARISON(==, equal_to)
+OVERLOAD_DELAYED_INIT_COMPARISON(!=, not_equal_to)
+OVERLOAD_DELAYED_INIT_COMPARISON(<, less)
+OVERLOAD_DELAYED_INIT_COMPARISON(<=, less_equal)
+OVERLOAD_DELAYED_INIT_COMPARISON(>, greater)
+OVERLOAD_DELAYED_INIT_COMPARISON(>=, greater_equal)
+
+#undef OVERLOAD_DELAYED_INIT_COMPARISON
+
+} // namespace overload
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+
+namespace std {
+
+/**
+ * @brief Hash of delayed_init.
+ *
+ * The hash of an initialised object is the hash of its inner object and all
+ * uninitialised objects have the same hash. For arithmetic types, it's
+ * computed without data-dependent branches.
+ */
+template <typename T, typename S, typename C, typename I>
+struct hash<::overload::delayed_init<T, S, C, I>> {
+  std::size_t operator()(const ::overload::delayed_init<T, S, C, I>& d) const {
+    return ::overload::detail::hash(d, ::overload::detail::is_branch_free<
+      ::overload::delayed_init<T, S, C, I>>());
+  }
+};
+
+} // namespace std
+
+#endif // OVERLOAD_DELAYED_INIT_LEAN
+
+#endif // OVERLOAD_DELAYED_INIT_H_
@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::delayed_init_array.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "delayed_init_array.h"
+
+// Helper class counting the number of live objects.
+class counted {
+
+  int i_;
+
+public:
+
+  static int live;
+
+  explicit counted(int i) noexcept : i_(i) {
+    ++live;
+  }
+
+  counted(const counted& other) noexcept : i_(other.i_) {
+    ++live;
+  }
+
+  ~counted() noexcept {
+    --live;
+  }
+
+  int get() const noexcept {
+    return i_;
+  }
+
+}; // class counted
+
+int counted::live = 0;
+using overload::delayed_init_array;
+typedef delayed_init_array<counted, 200> array;
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// indices()
+//------------------------------------------------------------------------------
+
+template <typename A>
+std::vector<std::size_t> indices(const A& a) {
+  std::vector<std::size_t> result;
+  for (auto it = a.begin(); it != a.end(); ++it)
+    result.push_back(it.index());
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// test_default_constructor()
+//------------------------------------------------------------------------------
+
+void test_default_constructor(int line) {
+  where(line, __func__);
+  const array a;
+  assert(a.empty());
+  assert(a.size() == 0);
+  assert(array::capacity() == 200);
+  assert(a.begin() == a.end());
+  for (std::size_t i = 0; i < a.capacity(); ++i)
+    assert(!a.is_init(i) && a.get(i) == nullptr);
+}
+
+//------------------------------------------------------------------------------
+// test_init_destroy()
+//------------------------------------------------------------------------------
+
+void test_init_destroy(int line) {
+  where(line, __func__);
+  {
+    array a;
+    const std::vector<std::size_t> live = {0, 5, 63, 64, 127, 128, 199};
+    for (auto i : live)
+      assert(a.init(i, static_cast<int>(i)).get() == static_cast<int>(i));
+    assert(a.size() == live.size());
+    assert(counted::live == static_cast<int>(live.size()));
+    assert(indices(a) == live);
+    try {
+      a.init(5, 0);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+    }
+    try {
+      a.value(6);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+    }
+    a.destroy(64);
+    a.destroy(65);
+    assert(a.size() == live.size() - 1);
+    assert(!a.is_init(64) && a.get(64) == nullptr);
+    assert(a.value(63).get() == 63);
+    assert(a.value_unchecked(128).get() == 128);
+    int sum = 0;
+    a.for_each([&](std::size_t i, const counted& c) {
+      assert(static_cast<int>(i) == c.get());
+      sum += c.get();
+    });
+    assert(sum == 0 + 5 + 63 + 127 + 128 + 199);
+    a.destroy_all();
+    assert(a.empty() && a.begin() == a.end());
+    assert(counted::live == 0);
+    a.init(1, 1);
+  }
+  assert(counted::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_copy()
+//------------------------------------------------------------------------------
+
+void test_copy(int line) {
+  where(line, __func__);
+  {
+    array a1;
+    a1.init(3, 3);
+    a1.init(150, 150);
+    array a2(a1);
+    assert(counted::live == 4);
+    assert(indices(a2) == indices(a1));
+    array a3;
+    a3.init(7, 7);
+    a3 = a2;
+    assert(counted::live == 6);
+    assert(indices(a3) == indices(a1));
+    array a4(std::move(a3));
+    assert(indices(a4) == indices(a1));
+  }
+  assert(counted::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_sparse()
+//------------------------------------------------------------------------------
+
+void test_sparse(int line) {
+  where(line, __func__);
+  auto a = new delayed_init_array<std::string, 50000>();
+  const delayed_init_array<std::string, 50000>& ca = *a;
+  for (std::size_t i = 0; i < ca.capacity(); i += 20)
+    a->init(i, "x");
+  assert(ca.size() == 2500);
+  std::size_t n = 0;
+  for (const auto& s : ca) {
+    assert(s == "x");
+    ++n;
+  }
+  assert(n == 2500);
+  a->destroy_all();
+  assert(ca.empty());
+  delete a;
+  delayed_init_array<double, 100> d;
+  d.init(99, 1.0);
+  d.destroy_all();
+  assert(d.empty() && !d.is_init(99));
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_default_constructor(__LINE__);
+  test_init_destroy(__LINE__);
+  test_copy(__LINE__);
+  test_sparse(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
@@ -0,0 +1,635 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+
+ /**
+  * @file delayed_init_array.h
+  * @brief Definition of class delayed_init_array.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_ARRAY_H_
+#define OVERLOAD_DELAYED_INIT_ARRAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "delayed_init.h"
+
+namespace overload {
+namespace detail {
+
+/**
+ * @brief Number of trailing zero bits.
+ *
+ * @pre w != 0.
+ * @param w The word.
+ * @return The index of the lowest set bit of w.
+ */
+inline unsigned ctz(std::uint64_t w) noexcept {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctzll(w));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long i;
+  _BitScanForward64(&i, w);
+  return static_cast<unsigned>(i);
+#else
+  unsigned i = 0;
+  for (; (w & 1) == 0; w >>= 1)
+    ++i;
+  return i;
+#endif
+}
+
+/**
+ * @brief Uninitialised storage for an object of type T.
+ *
+ * Contrarily to raw_storage<T>, construction writes nothing. Hence, large
+ * arrays of slot_storage<T> cost nothing to build.
+ *
+ * @tparam T Type of the object.
+ */
+template <typename T>
+union slot_storage {
+  slot_storage() noexcept {
+  }
+  ~slot_storage() noexcept {
+  }
+  T obj_;
+};
+
+} // namespace detail
+
+/**
+ * @brief Array of N delayed_init<T> with a separate occupancy bitmap.
+ *
+ * Class delayed_init_array<T, N> holds N slots, each of which might hold an
+ * object of type T whose initialisation is delayed until init() is called.
+ * Objects are contiguous (without interleaved flags) and the initialisation
+ * states are bits of a dense bitmap. Hence, iterating over initialised objects
+ * scans the bitmap one 64-bit word at a time, jumping from one set bit to the
+ * next (with count-trailing-zeros) and never touching the objects in
+ * uninitialised slots.
+ *
+ * Iterators (see begin() and end()) and for_each() visit initialised objects
+ * only, in increasing order of index.
+ *
+ * The policy Check sets what happens when a pre-condition of value() or init()
+ * doesn't hold (see namespace check). Indices are never checked.
+ *
+ * The type T must not be a reference type.
+ */
+template <typename T, std::size_t N,
+  typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class delayed_init_array {
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "delayed_init_array for reference type");
+
+  typedef std::uint64_t word_type;
+
+  static constexpr std::size_t bits_per_word = 64;
+  static constexpr std::size_t n_words = (N + bits_per_word - 1) /
+    bits_per_word;
+
+  template <typename A, typename U>
+  class basic_iterator;
+
+public:
+
+  typedef basic_iterator<delayed_init_array, T> iterator;
+  typedef basic_iterator<const delayed_init_array, const T> const_iterator;
+
+  /**
+   * @brief Default constructor.
+   *
+   * Only the bitmap is written to. Slots are left untouched.
+   *
+   * @post size() == 0.
+   * @throw - Nothing.
+   */
+  delayed_init_array() noexcept : bits_(), size_(0) {
+  }
+
+  /**
+   * @brief Copy-constructor.
+   *
+   * Each initialised object of src is copy-constructed into *this.
+   *
+   * @post is_init(i) == src.is_init(i) for all i.
+   * @param src Initialiser.
+   * @throw - Whatever T::T(const T&) throws. In this case, objects already
+   * constructed are destroyed.
+   */
+  delayed_init_array(const delayed_init_array& src) : delayed_init_array() {
+    src.for_each([this](std::size_t i, const T& obj) {
+      this->init_obj(i, obj);
+    });
+  }
+
+  /**
+   * @brief Move-constructor.
+   *
+   * Each initialised object of src is move-constructed into *this.
+   *
+   * @post is_init(i) == src.is_init(i) for all i.
+   * @param src Initialiser.
+   * @throw - Whatever T::T(T&&) throws. In this case, objects already
+   * constructed are destroyed.
+   */
+  delayed_init_array(delayed_init_array&& src)
+    noexcept(std::is_nothrow_move_constructible<T>::value) :
+    delayed_init_array() {
+    src.for_each([this](std::size_t i, T& obj) {
+      this->init_obj(i, std::move(obj));
+    });
+  }
+
+  /**
+   * @brief Destructor.
+   *
+   * @throw - Nothing.
+   */
+  ~delayed_init_array() noexcept {
+    destroy_all();
+  }
+
+  /**
+   * @brief Copy-assignment.
+   *
+   * Objects of *this are destroyed and then those of src are copy-constructed.
+   *
+   * @post is_init(i) == src.is_init(i) for all i.
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(const T&) throws.
+   */
+  delayed_init_array& operator=(const delayed_init_array& src) {
+    if (this != &src) {
+      destroy_all();
+      src.for_each([this](std::size_t i, const T& obj) {
+        this->init_obj(i, obj);
+      });
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Move-assignment.
+   *
+   * Objects of *this are destroyed and then those of src are move-constructed.
+   *
+   * @post is_init(i) == src.is_init(i) for all i.
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever T::T(T&&) throws.
+   */
+  delayed_init_array& operator=(delayed_init_array&& src)
+    noexcept(std::is_nothrow_move_constructible<T>::value) {
+    if (this != &src) {
+      destroy_all();
+      src.for_each([this](std::size_t i, T& obj) {
+        this->init_obj(i, std::move(obj));
+      });
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Number of slots.
+   *
+   * @return N.
+   * @throw - Nothing.
+   */
+  static constexpr std::size_t capacity() noexcept {
+    return N;
+  }
+
+  /**
+   * @brief Number of initialised objects.
+   *
+   * @return The number of initialised objects.
+   * @throw - Nothing.
+   */
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * @brief Checks whether there is no initialised object.
+   *
+   * @return size() == 0.
+   * @throw - Nothing.
+   */
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Checks whether the i-th slot is initialised.
+   *
+   * @pre i < N.
+   * @param i Index of the slot.
+   * @return true if the i-th object is initialised. Otherwise, false.
+   * @throw - Nothing.
+   */
+  bool is_init(std::size_t i) const noexcept {
+    return (bits_[i / bits_per_word] & bit(i)) != 0;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @pre i < N.
+   * @param i Index of the slot.
+   * @return A pointer to the i-th object if is_init(i) == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  T* get(std::size_t i) noexcept {
+    return is_init(i) ? obj(i) : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @pre i < N.
+   * @param i Index of the slot.
+   * @return A pointer to the i-th object if is_init(i) == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  const T* get(std::size_t i) const noexcept {
+    return is_init(i) ? obj(i) : nullptr;
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre i < N && is_init(i) == true.
+   * @param i Index of the slot.
+   * @return *get(i).
+   * @throw std::logic_error If is_init(i) == false and Check is
+   * check::exception.
+   */
+  T& value(std::size_t i) noexcept(Check::is_nothrow) {
+    if (!is_init(i))
+      Check::fail("attempt to use uninitialised object");
+    return *obj(i);
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre i < N && is_init(i) == true.
+   * @param i Index of the slot.
+   * @return *get(i).
+   * @throw std::logic_error If is_init(i) == false and Check is
+   * check::exception.
+   */
+  const T& value(std::size_t i) const noexcept(Check::is_nothrow) {
+    if (!is_init(i))
+      Check::fail("attempt to use uninitialised object");
+    return *obj(i);
+  }
+
+  /**
+   * @brief Unchecked indirection.
+   *
+   * @pre i < N && is_init(i) == true.
+   * @param i Index of the slot.
+   * @return *get(i).
+   * @throw - Nothing.
+   */
+  T& value_unchecked(std::size_t i) noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(is_init(i));
+    return *obj(i);
+  }
+
+  /**
+   * @brief Unchecked indirection (const).
+   *
+   * @pre i < N && is_init(i) == true.
+   * @param i Index of the slot.
+   * @return *get(i).
+   * @throw - Nothing.
+   */
+  const T& value_unchecked(std::size_t i) const noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(is_init(i));
+    return *obj(i);
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds the i-th object by forwarding arguments to T's constructor.
+   *
+   * @pre i < N && is_init(i) == false.
+   * @post is_init(i) == true && get(i) != nullptr.
+   * @param i Index of the slot.
+   * @param args Initialisation arguments.
+   * @return *get(i).
+   * @throw - std::logic_error (if is_init(i) == true and Check is
+   * check::exception) and whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  T& init(std::size_t i, Args&&... args) {
+    if (is_init(i))
+      Check::fail("second attempt to initialise object");
+    return init_obj(i, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Destroy the i-th object (if initialised).
+   *
+   * @pre i < N.
+   * @post is_init(i) == false && get(i) == nullptr.
+   * @param i Index of the slot.
+   * @throw - Nothing.
+   */
+  void destroy(std::size_t i) noexcept {
+    if (is_init(i)) {
+      obj(i)->~T();
+      bits_[i / bits_per_word] &= ~bit(i);
+      --size_;
+    }
+  }
+
+  /**
+   * @brief Destroy all objects.
+   *
+   * If T is trivially destructible, then only the bitmap is cleared.
+   *
+   * @post size() == 0.
+   * @throw - Nothing.
+   */
+  void destroy_all() noexcept {
+    if (size_ == 0)
+      return;
+    if (!std::is_trivially_destructible<T>::value)
+      for_each([](std::size_t, T& obj) {
+        obj.~T();
+      });
+    std::memset(bits_, 0, sizeof(bits_));
+    size_ = 0;
+  }
+
+  /**
+   * @brief Calls f(i, obj) for each initialised object obj of index i.
+   *
+   * Objects are visited in increasing order of index. f must not initialise
+   * or destroy objects.
+   *
+   * @param f The function object.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each(F&& f) {
+    for (std::size_t w = 0; w < n_words; ++w)
+      for (word_type bits = bits_[w]; bits != 0; bits &= bits - 1) {
+        const std::size_t i = w * bits_per_word + detail::ctz(bits);
+        f(i, *obj(i));
+      }
+  }
+
+  /**
+   * @brief Calls f(i, obj) for each initialised object obj of index i (const).
+   *
+   * Objects are visited in increasing order of index.
+   *
+   * @param f The function object.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each(F&& f) const {
+    for (std::size_t w = 0; w < n_words; ++w)
+      for (word_type bits = bits_[w]; bits != 0; bits &= bits - 1) {
+        const std::size_t i = w * bits_per_word + detail::ctz(bits);
+        f(i, *obj(i));
+      }
+  }
+
+  /**
+   * @brief Iterator to the first initialised object.
+   */
+  iterator begin() noexcept {
+    return iterator(this, 0);
+  }
+
+  /**
+   * @brief Iterator past the last initialised object.
+   */
+  iterator end() noexcept {
+    return iterator(this);
+  }
+
+  /**
+   * @brief Iterator to the first initialised object (const).
+   */
+  const_iterator begin() const noexcept {
+    return const_iterator(this, 0);
+  }
+
+  /**
+   * @brief Iterator past the last initialised object (const).
+   */
+  const_iterator end() const noexcept {
+    return const_iterator(this);
+  }
+
+  /**
+   * @brief Iterator to the first initialised object (const).
+   */
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+
+  /**
+   * @brief Iterator past the last initialised object (const).
+   */
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+  /**
+   * @brief Bitmap of initialised slots.
+   *
+   * Bit i % 64 of words()[i / 64] is set if, and only if, is_init(i) == true.
+   *
+   * @return A pointer to the first of (N + 63) / 64 words.
+   * @throw - Nothing.
+   */
+  const word_type* words() const noexcept {
+    return bits_;
+  }
+
+  /**
+   * @brief Slots.
+   *
+   * data()[i] is an object if, and only if, is_init(i) == true.
+   *
+   * @return A pointer to the first of N slots.
+   * @throw - Nothing.
+   */
+  T* data() noexcept {
+    return obj(0);
+  }
+
+  /**
+   * @brief Slots (const).
+   *
+   * data()[i] is an object if, and only if, is_init(i) == true.
+   *
+   * @return A pointer to the first of N slots.
+   * @throw - Nothing.
+   */
+  const T* data() const noexcept {
+    return obj(0);
+  }
+
+private:
+
+  detail::slot_storage<T> slots_[N];
+  word_type bits_[n_words];
+  std::size_t size_;
+
+  static word_type bit(std::size_t i) noexcept {
+    return word_type(1) << (i % bits_per_word);
+  }
+
+  T* obj(std::size_t i) noexcept {
+    return &slots_[i].obj_;
+  }
+
+  const T* obj(std::size_t i) const noexcept {
+    return &slots_[i].obj_;
+  }
+
+  template <typename... Args>
+  T& init_obj(std::size_t i, Args&&... args) {
+    new ((void *) obj(i)) T(std::forward<Args>(args)...);
+    bits_[i / bits_per_word] |= bit(i);
+    ++size_;
+    return *obj(i);
+  }
+
+  /**
+   * @brief Forward iterator over initialised objects.
+   *
+   * @tparam A Type of the array (possibly const).
+   * @tparam U Type of the objects (possibly const).
+   */
+  template <typename A, typename U>
+  class basic_iterator {
+
+    A*          array_;
+    std::size_t word_;
+    word_type   bits_;
+
+    friend class delayed_init_array;
+
+    // end().
+    explicit basic_iterator(A* array) noexcept : array_(array),
+      word_(n_words), bits_(0) {
+    }
+
+    // First initialised object at, or after, word w.
+    basic_iterator(A* array, std::size_t w) noexcept : array_(array),
+      word_(w), bits_(w < n_words ? array->bits_[w] : 0) {
+      skip();
+    }
+
+    void skip() noexcept {
+      while (bits_ == 0 && ++word_ < n_words)
+        bits_ = array_->bits_[word_];
+      if (bits_ == 0)
+        word_ = n_words;
+    }
+
+  public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::remove_const<U>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef U* pointer;
+    typedef U& reference;
+
+    basic_iterator() noexcept : array_(nullptr), word_(n_words), bits_(0) {
+    }
+
+    /**
+     * @brief Index of the current object.
+     */
+    std::size_t index() const noexcept {
+      return word_ * bits_per_word + detail::ctz(bits_);
+    }
+
+    U& operator*() const noexcept {
+      return *array_->obj(index());
+    }
+
+    U* operator->() const noexcept {
+      return array_->obj(index());
+    }
+
+    basic_iterator& operator++() noexcept {
+      bits_ &= bits_ - 1;
+      skip();
+      return *this;
+    }
+
+    basic_iterator operator++(int) noexcept {
+      basic_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b)
+      noexcept {
+      return a.word_ == b.word_ && a.bits_ == b.bits_;
+    }
+
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b)
+      noexcept {
+      return !(a == b);
+    }
+  };
+
+}; // class delayed_init_array
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_ARRAY_H_
@@ -0,0 +1,537 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Benchmark of overload::delayed_init against std::optional, boost::optional
+  * and a hand-written union.
+  *
+  * Every operation is timed over an array of objects (half of them initialised
+  * for the mixed benchmarks) and reported in nanoseconds per object. Results
+  * are written to the standard output in JSON to allow tracking regressions
+  * per compiler (e.g. make bench writes delayed_init_bench.json).
+  *
+  * Sorting is timed once over n_sorted objects (half of them initialised at
+  * random) with the holder's operator< and with a hand-written comparison.
+  * Since std::sort branches on every comparison, the cost of comparisons
+  * alone is also measured by counting adjacent pairs in order.
+  *
+  * Requires C++17 (std::optional). boost::optional is benchmarked if its header
+  * is found.
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if __has_include(<boost/optional.hpp>)
+#include <boost/optional.hpp>
+#define OVERLOAD_BENCH_HAS_BOOST 1
+#else
+#define OVERLOAD_BENCH_HAS_BOOST 0
+#endif
+
+#include "delayed_init.h"
+
+using overload::delayed_init;
+
+// Number of objects in the arrays.
+constexpr std::size_t n_objects = 1024;
+
+// Minimum time spent on each benchmark.
+constexpr std::chrono::milliseconds min_time(20);
+
+// Number of objects sorted (half of them initialised) by bench_sort().
+constexpr std::size_t n_sorted = 10000000;
+
+//------------------------------------------------------------------------------
+// escape()
+//------------------------------------------------------------------------------
+
+// Prevents the compiler from optimising away a value.
+template <typename T>
+inline void escape(const T& obj) {
+#if defined(__GNUC__)
+  __asm__ __volatile__("" : : "r"(&obj) : "memory");
+#else
+  static const volatile void* volatile sink;
+  sink = &obj;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Types.
+//------------------------------------------------------------------------------
+
+// Large object.
+struct block {
+  char data[4096];
+};
+
+template <typename T>
+struct type_info;
+
+template <>
+struct type_info<int> {
+  static const char* name() { return "int"; }
+  static int value() { return 42; }
+};
+
+template <>
+struct type_info<std::uint64_t> {
+  static const char* name() { return "uint64_t"; }
+  static std::uint64_t value() { return 42; }
+};
+
+template <>
+struct type_info<double> {
+  static const char* name() { return "double"; }
+  static double value() { return 1.5; }
+};
+
+template <>
+struct type_info<std::string> {
+  static const char* name() { return "std::string"; }
+  static std::string value() { return "delayed"; }
+};
+
+template <>
+struct type_info<block> {
+  static const char* name() { return "block4k"; }
+  static block value() { return block(); }
+};
+
+//------------------------------------------------------------------------------
+// raw_union
+//------------------------------------------------------------------------------
+
+// Hand-written optional as one would write without a library.
+template <typename T>
+class raw_union {
+
+  union storage {
+    storage() noexcept {
+    }
+    ~storage() noexcept {
+    }
+    T obj;
+  };
+
+  bool    is_init_;
+  storage storage_;
+
+public:
+
+  raw_union() noexcept : is_init_(false) {
+  }
+
+  raw_union(const raw_union& other) : is_init_(false) {
+    if (other.is_init_)
+      emplace(other.storage_.obj);
+  }
+
+  raw_union(raw_union&& other) noexcept : is_init_(false) {
+    if (other.is_init_)
+      emplace(std::move(other.storage_.obj));
+  }
+
+  ~raw_union() noexcept {
+    reset();
+  }
+
+  raw_union& operator=(const raw_union& other) {
+    if (is_init_ && other.is_init_)
+      storage_.obj = other.storage_.obj;
+    else if (other.is_init_)
+      emplace(other.storage_.obj);
+    else
+      reset();
+    return *this;
+  }
+
+  raw_union& operator=(raw_union&& other) noexcept {
+    if (is_init_ && other.is_init_)
+      storage_.obj = std::move(other.storage_.obj);
+    else if (other.is_init_)
+      emplace(std::move(other.storage_.obj));
+    else
+      reset();
+    return *this;
+  }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    new ((void*) &storage_.obj) T(std::forward<Args>(args)...);
+    is_init_ = true;
+  }
+
+  void reset() noexcept {
+    if (is_init_) {
+      storage_.obj.~T();
+      is_init_ = false;
+    }
+  }
+
+  bool has_value() const noexcept {
+    return is_init_;
+  }
+
+  const T& value() const {
+    if (!is_init_)
+      throw std::logic_error("attempt to use uninitialised object");
+    return storage_.obj;
+  }
+
+  const T& operator*() const noexcept {
+    return storage_.obj;
+  }
+
+  void swap(raw_union& other) {
+    using std::swap;
+    if (is_init_ && other.is_init_)
+      swap(storage_.obj, other.storage_.obj);
+    else if (is_init_) {
+      other.emplace(std::move(storage_.obj));
+      reset();
+    }
+    else if (other.is_init_) {
+      emplace(std::move(other.storage_.obj));
+      other.reset();
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+// Holders (uniform interface to the types under comparison).
+//------------------------------------------------------------------------------
+
+template <typename H>
+struct holder;
+
+template <typename T>
+struct holder<delayed_init<T>> {
+  static const char* name() { return "delayed_init"; }
+  static void init(delayed_init<T>& h, const T& v) { h.init(v); }
+  static void reset(delayed_init<T>& h) { h = delayed_init<T>(); }
+  static bool has(const delayed_init<T>& h) { return static_cast<bool>(h); }
+  static const T& checked(const delayed_init<T>& h) { return *h; }
+  static const T& unchecked(const delayed_init<T>& h) {
+    return h.value_unchecked();
+  }
+  static void swap(delayed_init<T>& h1, delayed_init<T>& h2) { h1.swap(h2); }
+};
+
+template <typename T>
+struct holder<std::optional<T>> {
+  static const char* name() { return "std::optional"; }
+  static void init(std::optional<T>& h, const T& v) { h.emplace(v); }
+  static void reset(std::optional<T>& h) { h.reset(); }
+  static bool has(const std::optional<T>& h) { return h.has_value(); }
+  static const T& checked(const std::optional<T>& h) { return h.value(); }
+  static const T& unchecked(const std::optional<T>& h) { return *h; }
+  static void swap(std::optional<T>& h1, std::optional<T>& h2) { h1.swap(h2); }
+};
+
+#if OVERLOAD_BENCH_HAS_BOOST
+
+template <typename T>
+struct holder<boost::optional<T>> {
+  static const char* name() { return "boost::optional"; }
+  static void init(boost::optional<T>& h, const T& v) { h.emplace(v); }
+  static void reset(boost::optional<T>& h) { h = boost::none; }
+  static bool has(const boost::optional<T>& h) { return h.is_initialized(); }
+  static const T& checked(const boost::optional<T>& h) { return h.value(); }
+  static const T& unchecked(const boost::optional<T>& h) {
+    return *h.get_ptr();
+  }
+  static void swap(boost::optional<T>& h1, boost::optional<T>& h2) {
+    boost::swap(h1, h2);
+  }
+};
+
+#endif // OVERLOAD_BENCH_HAS_BOOST
+
+template <typename T>
+struct holder<raw_union<T>> {
+  static const char* name() { return "raw_union"; }
+  static void init(raw_union<T>& h, const T& v) { h.emplace(v); }
+  static void reset(raw_union<T>& h) { h.reset(); }
+  static bool has(const raw_union<T>& h) { return h.has_value(); }
+  static const T& checked(const raw_union<T>& h) { return h.value(); }
+  static const T& unchecked(const raw_union<T>& h) { return *h; }
+  static void swap(raw_union<T>& h1, raw_union<T>& h2) { h1.swap(h2); }
+};
+
+//------------------------------------------------------------------------------
+// JSON output.
+//------------------------------------------------------------------------------
+
+bool first_result = true;
+
+void report(const char* holder_name, const char* type_name,
+  const char* benchmark, double ns_per_object) {
+  std::printf("%s\n    {\"holder\": \"%s\", \"type\": \"%s\", "
+    "\"benchmark\": \"%s\", \"ns_per_object\": %.4f}",
+    first_result ? "" : ",", holder_name, type_name, benchmark,
+    ns_per_object);
+  first_result = false;
+}
+
+void report_size(const char* holder_name, const char* type_name,
+  std::size_t size) {
+  std::printf("%s\n    {\"holder\": \"%s\", \"type\": \"%s\", "
+    "\"benchmark\": \"sizeof\", \"bytes\": %zu}",
+    first_result ? "" : ",", holder_name, type_name, size);
+  first_result = false;
+}
+
+//------------------------------------------------------------------------------
+// time_per_object()
+//------------------------------------------------------------------------------
+
+// Times f(), which processes n_objects objects, and returns ns per object.
+template <typename F>
+double time_per_object(F f) {
+  typedef std::chrono::steady_clock clock;
+  f();
+  std::size_t runs = 0;
+  const clock::time_point start = clock::now();
+  clock::time_point stop;
+  do {
+    f();
+    ++runs;
+    stop = clock::now();
+  } while (stop - start < min_time);
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+    (double(runs) * n_objects);
+}
+
+//------------------------------------------------------------------------------
+// bench()
+//------------------------------------------------------------------------------
+
+template <typename H, typename T>
+void bench() {
+
+  typedef holder<H> h;
+  const char* hn = h::name();
+  const char* tn = type_info<T>::name();
+  const T value = type_info<T>::value();
+
+  report_size(hn, tn, sizeof(H));
+
+  std::vector<H> a(n_objects);
+  std::vector<H> b(n_objects);
+
+  report(hn, tn, "init_destroy", time_per_object([&] {
+    for (auto& x : a) {
+      h::init(x, value);
+      escape(x);
+      h::reset(x);
+    }
+  }));
+
+  for (auto& x : a)
+    h::init(x, value);
+
+  report(hn, tn, "deref_checked", time_per_object([&] {
+    for (const auto& x : a)
+      escape(h::checked(x));
+  }));
+
+  report(hn, tn, "deref_unchecked", time_per_object([&] {
+    for (const auto& x : a)
+      escape(h::unchecked(x));
+  }));
+
+  // From here on, every other object is initialised.
+  for (std::size_t i = 0; i < n_objects; i += 2)
+    h::reset(a[i]);
+
+  report(hn, tn, "copy", time_per_object([&] {
+    for (std::size_t i = 0; i < n_objects; ++i)
+      b[i] = a[i];
+    escape(b);
+  }));
+
+  // Objects are moved back and forth so that sources are never moved-from
+  // (e.g. empty strings).
+  report(hn, tn, "move", time_per_object([&] {
+    for (std::size_t i = 0; i < n_objects; ++i)
+      b[i] = std::move(a[i]);
+    escape(b);
+    for (std::size_t i = 0; i < n_objects; ++i)
+      a[i] = std::move(b[i]);
+    escape(a);
+  }) / 2.0);
+
+  report(hn, tn, "swap", time_per_object([&] {
+    for (std::size_t i = 0; i + 1 < n_objects; i += 2)
+      h::swap(a[i], a[i + 1]);
+    escape(a);
+  }) * 2.0);
+
+  report(hn, tn, "scan", time_per_object([&] {
+    std::size_t n = 0;
+    for (const auto& x : a)
+      if (h::has(x)) {
+        escape(h::unchecked(x));
+        ++n;
+      }
+    escape(n);
+  }));
+}
+
+template <typename T>
+void bench_type() {
+  bench<delayed_init<T>, T>();
+  bench<std::optional<T>, T>();
+#if OVERLOAD_BENCH_HAS_BOOST
+  bench<boost::optional<T>, T>();
+#endif
+  bench<raw_union<T>, T>();
+}
+
+//------------------------------------------------------------------------------
+// bench_sort()
+//------------------------------------------------------------------------------
+
+// Comparison as written by hand without library support.
+template <typename H>
+struct nested_if_less {
+  bool operator()(const H& x, const H& y) const {
+    typedef holder<H> h;
+    if (h::has(x) && h::has(y))
+      return h::unchecked(x) < h::unchecked(y);
+    if (h::has(y))
+      return true;
+    return false;
+  }
+};
+
+// Comparison by the holder's operator<.
+template <typename H>
+struct operator_less {
+  bool operator()(const H& x, const H& y) const {
+    return x < y;
+  }
+};
+
+// Sorts a copy of objects and returns ns per object.
+template <typename H, typename C>
+double time_sort(const std::vector<H>& objects, C comp) {
+  typedef std::chrono::steady_clock clock;
+  std::vector<H> a(objects);
+  const clock::time_point start = clock::now();
+  std::sort(a.begin(), a.end(), comp);
+  const clock::time_point stop = clock::now();
+  escape(a);
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+    double(objects.size());
+}
+
+// Counts adjacent pairs in order and returns ns per object. Unlike sorting,
+// nothing branches on the result of comp.
+template <typename H, typename C>
+double time_count_less(const std::vector<H>& objects, C comp) {
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point start = clock::now();
+  std::size_t n = 0;
+  for (std::size_t i = 0; i + 1 < objects.size(); ++i)
+    n += comp(objects[i], objects[i + 1]);
+  const clock::time_point stop = clock::now();
+  escape(n);
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+    double(objects.size());
+}
+
+template <typename H, typename T>
+void bench_sort(const std::vector<T>& values, const std::vector<bool>& has) {
+
+  typedef holder<H> h;
+  const char* hn = h::name();
+  const char* tn = type_info<T>::name();
+
+  std::vector<H> objects(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    if (has[i])
+      h::init(objects[i], values[i]);
+
+  report(hn, tn, "sort_mixed", time_sort(objects, operator_less<H>()));
+  report(hn, tn, "count_less_mixed", time_count_less(objects,
+    operator_less<H>()));
+  report(hn, tn, "sort_mixed_nested_if", time_sort(objects,
+    nested_if_less<H>()));
+  report(hn, tn, "count_less_mixed_nested_if", time_count_less(objects,
+    nested_if_less<H>()));
+}
+
+template <typename T>
+void bench_sort_type() {
+  std::mt19937_64 engine(0);
+  std::vector<T> values(n_sorted);
+  std::vector<bool> has(n_sorted);
+  for (std::size_t i = 0; i < n_sorted; ++i) {
+    values[i] = static_cast<T>(engine());
+    has[i] = engine() & 1;
+  }
+  bench_sort<delayed_init<T>>(values, has);
+  bench_sort<std::optional<T>>(values, has);
+#if OVERLOAD_BENCH_HAS_BOOST
+  bench_sort<boost::optional<T>>(values, has);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  std::printf("{\n  \"compiler\": \"%s\",\n  \"cplusplus\": %ld,\n"
+    "  \"results\": [", __VERSION__, long(__cplusplus));
+
+  bench_type<int>();
+  bench_type<double>();
+  bench_type<std::string>();
+  bench_type<block>();
+
+  bench_sort_type<int>();
+  bench_sort_type<std::uint64_t>();
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Compile-time benchmark of overload::delayed_init.
+  *
+  * Instantiates delayed_init<type<I>> for OVERLOAD_COMPILE_BENCH_N distinct
+  * types type<I> and uses their most common members. The make target
+  * compile_bench reports the front-end time and the object size for the
+  * default and the lean configurations (see OVERLOAD_DELAYED_INIT_LEAN).
+  */
+
+#include "delayed_init.h"
+
+#if defined(OVERLOAD_DELAYED_INIT_LEAN) && defined(_GLIBCXX_STDEXCEPT)
+#error "delayed_init.h includes <stdexcept> in the lean configuration"
+#endif
+
+#if defined(OVERLOAD_DELAYED_INIT_LEAN) && defined(_GLIBCXX_FUNCTIONAL)
+#error "delayed_init.h includes <functional> in the lean configuration"
+#endif
+
+#if defined(OVERLOAD_DELAYED_INIT_LEAN) && defined(_GLIBCXX_ATOMIC)
+#error "delayed_init.h includes <atomic> in the lean configuration"
+#endif
+
+#ifndef OVERLOAD_COMPILE_BENCH_N
+#define OVERLOAD_COMPILE_BENCH_N 256
+#endif
+
+using overload::delayed_init;
+
+// Distinct non-trivial types.
+template <int I>
+struct type {
+
+  explicit type(int i) : i(i) {
+  }
+
+  type(const type& other) : i(other.i) {
+  }
+
+  ~type() {
+  }
+
+  type& operator=(const type& other) {
+    i = other.i;
+    return *this;
+  }
+
+  int i;
+};
+
+// Uses delayed_init<type<I>>.
+template <int I>
+int use(int x) {
+  delayed_init<type<I>> d1;
+  d1.init(x);
+  delayed_init<type<I>> d2(d1);
+  d2 = d1;
+  d1 = std::move(d2);
+  d2.emplace(x + I);
+  d1.swap(d2);
+  return (*d1).i + d2->i + static_cast<int>(static_cast<bool>(d2));
+}
+
+// Calls use<I>() for I in [B, E) (by bisection to keep the recursion shallow).
+template <int B, int E, bool = (E - B == 1)>
+struct use_all {
+  static int apply(int x) {
+    return use_all<B, (B + E) / 2>::apply(x) +
+      use_all<(B + E) / 2, E>::apply(x);
+  }
+};
+
+template <int B, int E>
+struct use_all<B, E, true> {
+  static int apply(int x) {
+    return use<B>(x);
+  }
+};
+
+int main(int argc, char*[]) {
+  return use_all<0, OVERLOAD_COMPILE_BENCH_N>::apply(argc) == 0;
+}
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::instrument::counters.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "delayed_init_counters.h"
+
+namespace instrument = overload::instrument;
+using overload::delayed_init;
+using overload::storage::flag;
+using overload::storage::out_of_line;
+using overload::check::exception;
+
+// Tag of the counters used by these tests.
+struct tests;
+
+typedef instrument::counters<tests> counters;
+
+template <typename T>
+using counted = delayed_init<T, flag, exception, counters>;
+
+static_assert(std::is_trivially_copyable<
+  delayed_init<int, flag, exception, instrument::none>>::value,
+  "delayed_init<int> with instrument::none is not trivially copyable");
+static_assert(!std::is_trivially_copyable<counted<int>>::value,
+  "instrumented delayed_init<int> is trivially copyable");
+static_assert(sizeof(counted<int>) == sizeof(delayed_init<int>),
+  "instrumented delayed_init<int> is larger than delayed_init<int>");
+static_assert(delayed_init<std::string, out_of_line<>, exception, counters>::
+  is_trivially_relocatable::value, "instrumented delayed_init<std::string, "
+  "out_of_line<>> is not trivially relocatable");
+static_assert(counted<int>::is_trivially_relocatable::value,
+  "instrumented delayed_init<int> is not trivially relocatable");
+static_assert(noexcept(counters::take_snapshot()),
+  "counters::take_snapshot() is not noexcept");
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// check_events()
+//------------------------------------------------------------------------------
+
+// Checks that, since snapshot before, only event e has happened n times.
+void check_events(const instrument::snapshot& before, instrument::event e,
+  std::uint64_t n) {
+  const instrument::snapshot diff = counters::take_snapshot() - before;
+  for (int i = 0; i < instrument::n_events; ++i) {
+    const instrument::event f = static_cast<instrument::event>(i);
+    assert(diff[f] == (f == e ? n : 0));
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_events()
+//------------------------------------------------------------------------------
+
+void test_events(int line) {
+  where(line, __func__);
+
+  instrument::snapshot s = counters::take_snapshot();
+  counted<std::string> d0;
+  d0.init(3, 'a');
+  check_events(s, instrument::construct, 1);
+
+  const std::string str("b");
+  s = counters::take_snapshot();
+  counted<std::string> d1;
+  d1.init(str);
+  check_events(s, instrument::copy_construct, 1);
+
+  s = counters::take_snapshot();
+  counted<std::string> d2(d1);
+  check_events(s, instrument::copy_construct, 1);
+
+  s = counters::take_snapshot();
+  counted<std::string> d3(std::move(d2));
+  check_events(s, instrument::move_construct, 1);
+
+  s = counters::take_snapshot();
+  d2 = d1;
+  check_events(s, instrument::copy_assign, 1);
+
+  s = counters::take_snapshot();
+  d2 = std::move(d1);
+  check_events(s, instrument::move_assign, 1);
+
+  s = counters::take_snapshot();
+  d2 = "c";
+  check_events(s, instrument::assign, 1);
+
+  s = counters::take_snapshot();
+  d2 = counted<std::string>();
+  check_events(s, instrument::destroy, 1);
+
+  s = counters::take_snapshot();
+  {
+    auto c = d2.construct_in();
+    new (c.data()) std::string("e");
+    c.commit();
+  }
+  check_events(s, instrument::construct, 1);
+
+  s = counters::take_snapshot();
+  d2 = counted<std::string>();
+  d2.construct_in();
+  check_events(s, instrument::destroy, 1);
+
+  s = counters::take_snapshot();
+  try {
+    *d2;
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  check_events(s, instrument::failed_check, 1);
+
+  s = counters::take_snapshot();
+  d3.emplace(std::string("d"));
+  const instrument::snapshot diff = counters::take_snapshot() - s;
+  assert(diff[instrument::destroy] == 1);
+  assert(diff[instrument::move_construct] == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_moves()
+//------------------------------------------------------------------------------
+
+// Instrumented moves leave objects in the same states as plain ones.
+template <typename Storage>
+void test_moves(int line) {
+
+  where(line, __func__);
+  typedef delayed_init<std::string, Storage, exception> plain;
+  typedef delayed_init<std::string, Storage, exception, counters> instrumented;
+  static_assert(plain::is_trivially_relocatable::value ==
+    instrumented::is_trivially_relocatable::value, "instrumentation changes "
+    "trivial relocatability");
+
+  plain p0("a");
+  instrumented i0("a");
+  instrument::snapshot s = counters::take_snapshot();
+  plain p1(std::move(p0));
+  instrumented i1(std::move(i0));
+  check_events(s, instrument::move_construct, 1);
+  assert(static_cast<bool>(p0) == static_cast<bool>(i0));
+  assert(*p1 == "a" && *i1 == "a");
+
+  plain p2("b");
+  instrumented i2("b");
+  s = counters::take_snapshot();
+  p2 = std::move(p1);
+  i2 = std::move(i1);
+  check_events(s, instrument::move_assign, 1);
+  assert(static_cast<bool>(p1) == static_cast<bool>(i1));
+  assert(*p2 == "a" && *i2 == "a");
+
+  // Into an empty object.
+  plain p3;
+  instrumented i3;
+  s = counters::take_snapshot();
+  p3 = std::move(p2);
+  i3 = std::move(i2);
+  check_events(s, instrument::move_construct, 1);
+  assert(static_cast<bool>(p2) == static_cast<bool>(i2));
+  assert(*p3 == "a" && *i3 == "a");
+}
+
+//------------------------------------------------------------------------------
+// test_threads()
+//------------------------------------------------------------------------------
+
+void test_threads(int line) {
+  where(line, __func__);
+  const unsigned n_threads = 4;
+  const unsigned n_iterations = 1000;
+  const instrument::snapshot s = counters::take_snapshot();
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < n_threads; ++t)
+    threads.emplace_back([] {
+      for (unsigned i = 0; i < n_iterations; ++i) {
+        counted<std::pair<unsigned, unsigned>> d;
+        d.init(i, i);
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+  const instrument::snapshot diff = counters::take_snapshot() - s;
+  assert(diff[instrument::construct] == n_threads * n_iterations);
+  assert(diff[instrument::destroy] == n_threads * n_iterations);
+}
+
+//------------------------------------------------------------------------------
+// test_thread_exit()
+//------------------------------------------------------------------------------
+
+void test_thread_exit(int line) {
+  where(line, __func__);
+  const instrument::snapshot s = counters::take_snapshot();
+  std::thread([] {
+    // d is constructed before the thread's counters (on the first event) and,
+    // hence, destroyed after them.
+    thread_local counted<std::string> d;
+    d.init("thread");
+  }).join();
+  const instrument::snapshot diff = counters::take_snapshot() - s;
+  assert(diff[instrument::construct] == 1);
+  assert(diff[instrument::destroy] == 1);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_events(__LINE__);
+  test_moves<flag>(__LINE__);
+  test_moves<out_of_line<>>(__LINE__);
+  test_threads(__LINE__);
+  test_thread_exit(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
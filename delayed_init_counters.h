@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init_counters.h
+  * @brief Definition of instrumentation policy instrument::counters.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_COUNTERS_H_
+#define OVERLOAD_DELAYED_INIT_COUNTERS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "delayed_init.h"
+
+namespace overload {
+namespace instrument {
+
+/**
+ * @brief Numbers of events recorded by counters<Tag> up to some point.
+ */
+struct snapshot {
+
+  /**
+   * @brief Number of events of a given kind.
+   *
+   * @param e Event.
+   * @return The number of events e.
+   * @throw - Nothing.
+   */
+  std::uint64_t operator[](event e) const noexcept {
+    return count[e];
+  }
+
+  /**
+   * @brief Number of events between two snapshots.
+   *
+   * @param earlier Snapshot taken before *this.
+   * @return The difference, event by event, of *this and earlier.
+   * @throw - Nothing.
+   */
+  snapshot operator-(const snapshot& earlier) const noexcept {
+    snapshot diff;
+    for (int e = 0; e < n_events; ++e)
+      diff.count[e] = count[e] - earlier.count[e];
+    return diff;
+  }
+
+  std::uint64_t count[n_events];
+};
+
+/**
+ * @brief Instrumentation policy counting events per thread.
+ *
+ * Each thread increments its own counters with relaxed atomic operations and,
+ * since no other thread writes to them, these are plain loads and stores (no
+ * read-modify-write). take_snapshot() adds up the counters of all threads
+ * (including those that have exited). Counts of the events that happen while
+ * the snapshot is being taken might or might not be included.
+ *
+ * The first event recorded by a thread registers its counters. This takes a
+ * spin lock (rather than a std::mutex which might throw) since record() is
+ * called from noexcept functions. Tag allows for independent sets of counters
+ * (e.g. one per subsystem).
+ *
+ * A thread's counters are thread_local and, hence, destroyed on thread exit
+ * (and, for the main thread, before objects of static storage duration).
+ * Events recorded afterwards by the same thread (e.g. by the destructor of a
+ * thread_local or static delayed_init) are added, under the lock, to the
+ * counts of exited threads.
+ *
+ * @tparam Tag Identifier of the set of counters.
+ */
+template <typename Tag = void>
+class counters {
+
+  struct block {
+    std::atomic<std::uint64_t> count[n_events];
+    block*                     next;
+  };
+
+  struct registry {
+    std::atomic<bool> busy;
+    block*            head;
+    std::uint64_t     retired[n_events];
+  };
+
+  static registry& get_registry() noexcept {
+    static registry r{};
+    return r;
+  }
+
+  // Spin lock on the registry. Registrations (one per thread) and snapshots
+  // are rare and short.
+  class lock {
+
+    registry& r_;
+
+  public:
+
+    explicit lock(registry& r) noexcept : r_(r) {
+      while (r_.busy.exchange(true, std::memory_order_acquire))
+        std::this_thread::yield();
+    }
+
+    lock(const lock&) = delete;
+
+    lock& operator=(const lock&) = delete;
+
+    ~lock() noexcept {
+      r_.busy.store(false, std::memory_order_release);
+    }
+  };
+
+  // Counters of the calling thread: registered on construction and folded
+  // into the registry on thread exit.
+  struct local_block : block {
+
+    local_block() noexcept {
+      for (auto& c : this->count)
+        c.store(0, std::memory_order_relaxed);
+      registry& r = get_registry();
+      lock l(r);
+      this->next = r.head;
+      r.head = this;
+    }
+
+    ~local_block() {
+      registry& r = get_registry();
+      lock l(r);
+      is_retired() = true;
+      for (int e = 0; e < n_events; ++e)
+        r.retired[e] += this->count[e].load(std::memory_order_relaxed);
+      block** b = &r.head;
+      while (*b != this)
+        b = &(*b)->next;
+      *b = this->next;
+    }
+  };
+
+  static block& local() noexcept {
+    static thread_local local_block b;
+    return b;
+  }
+
+  // Whether the calling thread's block has been destroyed. (Trivially
+  // destructible and, hence, usable until the thread ends.)
+  static bool& is_retired() noexcept {
+    static thread_local bool retired = false;
+    return retired;
+  }
+
+public:
+
+  /**
+   * @brief Records an event.
+   *
+   * @param e Event.
+   * @throw - Nothing.
+   */
+  static void record(event e) noexcept {
+    if (is_retired()) {
+      registry& r = get_registry();
+      lock l(r);
+      ++r.retired[e];
+      return;
+    }
+    std::atomic<std::uint64_t>& c = local().count[e];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Takes a snapshot of the counters of all threads.
+   *
+   * @return The numbers of events recorded so far.
+   * @throw - Nothing.
+   */
+  static snapshot take_snapshot() noexcept {
+    registry& r = get_registry();
+    lock l(r);
+    snapshot s;
+    for (int e = 0; e < n_events; ++e)
+      s.count[e] = r.retired[e];
+    for (const block* b = r.head; b; b = b->next)
+      for (int e = 0; e < n_events; ++e)
+        s.count[e] += b->count[e].load(std::memory_order_relaxed);
+    return s;
+  }
+
+}; // class counters
+
+} // namespace instrument
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_COUNTERS_H_
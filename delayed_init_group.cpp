@@ -0,0 +1,239 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::delayed_init_group.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "delayed_init_group.h"
+
+// Helper class counting the number of live objects.
+class counted {
+
+  int i_;
+
+public:
+
+  static int live;
+
+  explicit counted(int i) noexcept : i_(i) {
+    ++live;
+  }
+
+  counted(const counted& other) noexcept : i_(other.i_) {
+    ++live;
+  }
+
+  ~counted() noexcept {
+    --live;
+  }
+
+  counted& operator=(const counted& other) noexcept {
+    i_ = other.i_;
+    return *this;
+  }
+
+  int get() const noexcept {
+    return i_;
+  }
+
+}; // class counted
+
+int counted::live = 0;
+using overload::delayed_init_group;
+typedef delayed_init_group<int, counted, std::string, char> group;
+
+//------------------------------------------------------------------------------
+// Layout.
+//------------------------------------------------------------------------------
+
+static_assert(sizeof(delayed_init_group<int, int, int, int, int, int, int, int>)
+  == 9 * sizeof(int), "delayed_init_group<int x 8> is not packed");
+static_assert(sizeof(delayed_init_group<char, char, char>) == 4,
+  "delayed_init_group<char x 3> is not packed");
+
+// The objects are laid out as the members of this struct.
+struct char_char_int_double {
+  char   c1;
+  char   c2;
+  int    i;
+  double d;
+};
+
+typedef overload::detail::group_storage<char, char, int, double>
+  char_char_int_double_storage;
+
+static_assert(sizeof(char_char_int_double_storage) ==
+  sizeof(char_char_int_double), "group_storage<char, char, int, double> is "
+  "not laid out as a struct");
+static_assert(alignof(char_char_int_double_storage) ==
+  alignof(char_char_int_double), "group_storage<char, char, int, double> is "
+  "not aligned as a struct");
+static_assert(overload::detail::group_access<2, char, char, int, double>::
+  offset == offsetof(char_char_int_double, i), "group_storage<char, char, "
+  "int, double> doesn't place int as a struct does");
+static_assert(overload::detail::group_access<3, char, char, int, double>::
+  offset == offsetof(char_char_int_double, d), "group_storage<char, char, "
+  "int, double> doesn't place double as a struct does");
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_default_constructor()
+//------------------------------------------------------------------------------
+
+void test_default_constructor(int line) {
+  where(line, __func__);
+  const group g;
+  assert(g.none_init());
+  assert(!g.all_init());
+  assert(!g.is_init<0>() && !g.is_init<1>() && !g.is_init<2>() &&
+    !g.is_init<3>());
+  assert(g.get<1>() == nullptr);
+}
+
+//------------------------------------------------------------------------------
+// test_init()
+//------------------------------------------------------------------------------
+
+void test_init(int line) {
+  where(line, __func__);
+  {
+    group g;
+    g.init<1>(1);
+    assert(counted::live == 1);
+    assert(g.is_init<1>() && !g.none_init() && !g.all_init());
+    assert(g.value<1>().get() == 1);
+    g.init<0>(2);
+    g.init<2>("three");
+    g.init<3>('4');
+    assert(g.all_init());
+    assert(*g.get<0>() == 2 && *g.get<2>() == "three" && *g.get<3>() == '4');
+    try {
+      g.init<1>(5);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+    }
+    assert(g.value<1>().get() == 1);
+  }
+  assert(counted::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_value_uninitialised()
+//------------------------------------------------------------------------------
+
+void test_value_uninitialised(int line) {
+  where(line, __func__);
+  const group g;
+  try {
+    g.value<2>();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_destroy()
+//------------------------------------------------------------------------------
+
+void test_destroy(int line) {
+  where(line, __func__);
+  group g;
+  g.init<1>(1);
+  g.init<2>("two");
+  g.destroy<1>();
+  assert(counted::live == 0);
+  assert(!g.is_init<1>() && g.is_init<2>());
+  g.destroy<1>();
+  g.init<1>(3);
+  assert(g.value<1>().get() == 3);
+}
+
+//------------------------------------------------------------------------------
+// test_copy()
+//------------------------------------------------------------------------------
+
+void test_copy(int line) {
+  where(line, __func__);
+  {
+    group g1;
+    g1.init<1>(1);
+    g1.init<2>("two");
+    group g2(g1);
+    assert(counted::live == 2);
+    assert(!g2.is_init<0>() && g2.value<1>().get() == 1 &&
+      g2.value<2>() == "two" && !g2.is_init<3>());
+    group g3;
+    g3.init<0>(0);
+    g3.init<1>(3);
+    g3 = g1;
+    assert(counted::live == 3);
+    assert(!g3.is_init<0>() && g3.value<1>().get() == 1);
+    group g4(std::move(g3));
+    assert(g4.value<2>() == "two");
+    g1 = group();
+    assert(g1.none_init());
+  }
+  assert(counted::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_default_constructor(__LINE__);
+  test_init(__LINE__);
+  test_value_uninitialised(__LINE__);
+  test_destroy(__LINE__);
+  test_copy(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
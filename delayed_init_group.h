@@ -0,0 +1,487 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init_group.h
+  * @brief Definition of class delayed_init_group.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_GROUP_H_
+#define OVERLOAD_DELAYED_INIT_GROUP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+namespace detail {
+
+/**
+ * @brief Conjunction of boolean constants.
+ */
+template <bool... Bs>
+struct all_of : std::is_same<all_of<Bs...>, all_of<(Bs || true)...>> {
+};
+
+/**
+ * @brief Smallest unsigned integer type with at least N bits.
+ *
+ * @tparam N Number of bits.
+ */
+template <std::size_t N>
+struct mask_for {
+  static_assert(N <= 64, "delayed_init_group with more than 64 objects");
+  typedef typename std::conditional<N <= 8, std::uint8_t,
+    typename std::conditional<N <= 16, std::uint16_t,
+    typename std::conditional<N <= 32, std::uint32_t,
+    std::uint64_t>::type>::type>::type type;
+};
+
+/**
+ * @brief Type and offset of the I-th object of group_storage<Ts...>.
+ *
+ * The offsets are those of the members of a struct whose members have types
+ * Ts... (in this order).
+ *
+ * @tparam I Index of the object.
+ * @tparam Ts Types of the objects.
+ */
+template <std::size_t I, typename... Ts>
+struct group_access;
+
+template <typename T, typename... Ts>
+struct group_access<0, T, Ts...> {
+  typedef T type;
+  static constexpr std::size_t offset = 0;
+  static constexpr std::size_t end = sizeof(T);
+};
+
+template <std::size_t I, typename T, typename... Ts>
+struct group_access<I, T, Ts...> {
+  typedef typename group_access<I - 1, Ts...>::type type;
+  static constexpr std::size_t offset = (group_access<I - 1, T, Ts...>::end +
+    alignof(type) - 1) / alignof(type) * alignof(type);
+  static constexpr std::size_t end = offset + sizeof(type);
+};
+
+/**
+ * @brief Raw storage for objects of types Ts..., laid out as the members of a
+ * struct.
+ *
+ * The storage neither constructs nor destroys the objects.
+ *
+ * @tparam Ts Types of the objects.
+ */
+template <typename... Ts>
+class group_storage {
+
+  template <std::size_t I>
+  using access = group_access<I, Ts...>;
+
+public:
+
+  constexpr group_storage() noexcept : bytes_() {
+  }
+
+  template <std::size_t I>
+  typename access<I>::type* obj() noexcept {
+    return launder(reinterpret_cast<typename access<I>::type*>(bytes_ +
+      access<I>::offset));
+  }
+
+  template <std::size_t I>
+  const typename access<I>::type* obj() const noexcept {
+    return launder(reinterpret_cast<const typename access<I>::type*>(bytes_ +
+      access<I>::offset));
+  }
+
+private:
+
+  template <typename U>
+  static U* launder(U* ptr) noexcept {
+#if defined(__cpp_lib_launder)
+    return std::launder(ptr);
+#else
+    return ptr;
+#endif
+  }
+
+  alignas(Ts...) unsigned char bytes_[access<sizeof...(Ts) - 1>::end];
+
+}; // class group_storage
+
+} // namespace detail
+
+/**
+ * @brief Several delayed_init objects sharing a single initialisation mask.
+ *
+ * Class delayed_init_group<Ts...> holds objects of types Ts... whose
+ * initialisations are delayed until init<I>() is called. It behaves as a tuple
+ * of delayed_init<Ts>... but the objects are laid out as the members of a
+ * struct (without interleaved flags) and their initialisation states are bits
+ * of a single unsigned integer. Hence, a class with several members whose
+ * initialisations are delayed can declare one delayed_init_group rather than
+ * many delayed_init members.
+ *
+ * At most 64 objects are supported and no type in Ts... can be a reference.
+ *
+ * Reference:
+ * Cassio Neri, "Complex logic in the member initialiser list", Overload 112,
+ * ACCU, (2012).
+ * http://accu.org/var/uploads/journals/Overload112.pdf
+ */
+template <typename... Ts>
+class delayed_init_group {
+
+  static_assert(sizeof...(Ts) > 0, "instantiation of delayed_init_group "
+    "without types");
+
+  typedef typename detail::mask_for<sizeof...(Ts)>::type mask_type;
+
+  template <std::size_t I>
+  using index = std::integral_constant<std::size_t, I>;
+
+public:
+
+  /**
+   * @brief Number of objects.
+   */
+  static constexpr std::size_t size = sizeof...(Ts);
+
+  /**
+   * @brief Type of the I-th object.
+   */
+  template <std::size_t I>
+  using element = typename detail::group_access<I, Ts...>::type;
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post none_init() == true.
+   * @throw - Nothing.
+   */
+  constexpr delayed_init_group() noexcept : storage_(), mask_(0) {
+  }
+
+  /**
+   * @brief Copy-constructor.
+   *
+   * Each initialised object of src is copy-constructed into *this.
+   *
+   * @post is_init<I>() == src.is_init<I>() for all I.
+   * @param src Initialiser.
+   * @throw - Whatever a copy-constructor of Ts... throws. In this case, objects
+   * already constructed are destroyed.
+   */
+  delayed_init_group(const delayed_init_group& src) : delayed_init_group() {
+    construct_from(index<0>(), src);
+  }
+
+  /**
+   * @brief Move-constructor.
+   *
+   * Each initialised object of src is move-constructed into *this.
+   *
+   * @post is_init<I>() == src.is_init<I>() for all I.
+   * @param src Initialiser.
+   * @throw - Whatever a move-constructor of Ts... throws. In this case, objects
+   * already constructed are destroyed.
+   */
+  delayed_init_group(delayed_init_group&& src)
+    noexcept(detail::all_of<
+      std::is_nothrow_move_constructible<Ts>::value...>::value) :
+    delayed_init_group() {
+    construct_from(index<0>(), std::move(src));
+  }
+
+  /**
+   * @brief Destructor.
+   *
+   * Destroys the initialised objects. Objects of trivially destructible types
+   * are not even inspected.
+   *
+   * @throw - Nothing.
+   */
+  ~delayed_init_group() noexcept {
+    destroy_all();
+  }
+
+  /**
+   * @brief Copy-assignment.
+   *
+   * Each object is assigned as delayed_init<T>::operator=(const delayed_init&)
+   * does.
+   *
+   * @post is_init<I>() == src.is_init<I>() for all I.
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever copy-constructors and copy-assignments of Ts... throw.
+   */
+  delayed_init_group& operator=(const delayed_init_group& src) {
+    assign_from(index<0>(), src);
+    return *this;
+  }
+
+  /**
+   * @brief Move-assignment.
+   *
+   * Each object is assigned as delayed_init<T>::operator=(delayed_init&&) does.
+   *
+   * @post is_init<I>() == src.is_init<I>() for all I.
+   * @param src Assignment source.
+   * @return *this.
+   * @throw - Whatever move-constructors and move-assignments of Ts... throw.
+   */
+  delayed_init_group& operator=(delayed_init_group&& src) {
+    assign_from(index<0>(), std::move(src));
+    return *this;
+  }
+
+  /**
+   * @brief Checks whether the I-th object is initialised.
+   *
+   * @return true if the I-th object is initialised. Otherwise, false.
+   * @throw - Nothing.
+   */
+  template <std::size_t I>
+  bool is_init() const noexcept {
+    return (mask_ & bit<I>()) != 0;
+  }
+
+  /**
+   * @brief Checks whether all objects are initialised.
+   *
+   * @return true if all objects are initialised. Otherwise, false.
+   * @throw - Nothing.
+   */
+  bool all_init() const noexcept {
+    return mask_ == full();
+  }
+
+  /**
+   * @brief Checks whether no object is initialised.
+   *
+   * @return true if no object is initialised. Otherwise, false.
+   * @throw - Nothing.
+   */
+  bool none_init() const noexcept {
+    return mask_ == 0;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the I-th object if is_init<I>() == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  template <std::size_t I>
+  element<I>* get() noexcept {
+    return is_init<I>() ? obj<I>() : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @return A pointer to the I-th object if is_init<I>() == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  template <std::size_t I>
+  const element<I>* get() const noexcept {
+    return is_init<I>() ? obj<I>() : nullptr;
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre is_init<I>() == true.
+   * @return *get<I>().
+   * @throw std::logic_error If pre-condition doesn't hold and
+   * OVERLOAD_DELAYED_INIT_CHECK is check::exception.
+   */
+  template <std::size_t I>
+  element<I>& value() {
+    if (!is_init<I>())
+      OVERLOAD_DELAYED_INIT_CHECK::fail("attempt to use uninitialised object");
+    return *obj<I>();
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre is_init<I>() == true.
+   * @return *get<I>().
+   * @throw std::logic_error If pre-condition doesn't hold and
+   * OVERLOAD_DELAYED_INIT_CHECK is check::exception.
+   */
+  template <std::size_t I>
+  const element<I>& value() const {
+    if (!is_init<I>())
+      OVERLOAD_DELAYED_INIT_CHECK::fail("attempt to use uninitialised object");
+    return *obj<I>();
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds the I-th object by forwarding arguments to its constructor.
+   *
+   * @pre is_init<I>() == false.
+   * @post is_init<I>() == true && get<I>() != nullptr.
+   * @param args Initialisation arguments.
+   * @return *get<I>().
+   * @throw - std::logic_error (if pre condition doesn't hold and
+   * OVERLOAD_DELAYED_INIT_CHECK is check::exception) and whatever
+   * element<I>::element<I>(Args&&...) throws.
+   */
+  template <std::size_t I, typename... Args>
+  element<I>& init(Args&&... args) {
+    if (is_init<I>())
+      OVERLOAD_DELAYED_INIT_CHECK::fail("second attempt to initialise object");
+    init_obj<I>(std::forward<Args>(args)...);
+    return *obj<I>();
+  }
+
+  /**
+   * @brief Destroy the I-th object (if initialised).
+   *
+   * @post is_init<I>() == false && get<I>() == nullptr.
+   * @throw - Nothing.
+   */
+  template <std::size_t I>
+  void destroy() noexcept {
+    if (is_init<I>())
+      destroy_obj<I>();
+  }
+
+private:
+
+  detail::group_storage<Ts...> storage_;
+  mask_type mask_;
+
+  static constexpr mask_type full() noexcept {
+    return static_cast<mask_type>(static_cast<mask_type>(~mask_type(0)) >>
+      (8 * sizeof(mask_type) - size));
+  }
+
+  template <std::size_t I>
+  static constexpr mask_type bit() noexcept {
+    return static_cast<mask_type>(mask_type(1) << I);
+  }
+
+  template <std::size_t I>
+  element<I>* obj() noexcept {
+    return storage_.template obj<I>();
+  }
+
+  template <std::size_t I>
+  const element<I>* obj() const noexcept {
+    return storage_.template obj<I>();
+  }
+
+  template <std::size_t I, typename... Args>
+  void init_obj(Args&&... args) {
+    new ((void *) obj<I>()) element<I>(std::forward<Args>(args)...);
+    mask_ |= bit<I>();
+  }
+
+  template <std::size_t I>
+  void destroy_obj() noexcept {
+    obj<I>()->~element<I>();
+    mask_ &= static_cast<mask_type>(~bit<I>());
+  }
+
+  void destroy_all() noexcept {
+    if (mask_ != 0)
+      destroy_from(index<0>());
+    mask_ = 0;
+  }
+
+  void destroy_from(index<size>) noexcept {
+  }
+
+  template <std::size_t I>
+  void destroy_from(index<I>) noexcept {
+    if (!std::is_trivially_destructible<element<I>>::value && is_init<I>())
+      obj<I>()->~element<I>();
+    destroy_from(index<I + 1>());
+  }
+
+  template <typename G>
+  void construct_from(index<size>, G&&) {
+  }
+
+  template <std::size_t I, typename G>
+  void construct_from(index<I>, G&& src) {
+    if (src.template is_init<I>())
+      init_obj<I>(forward_obj<I>(src));
+    construct_from(index<I + 1>(), std::forward<G>(src));
+  }
+
+  template <typename G>
+  void assign_from(index<size>, G&&) {
+  }
+
+  template <std::size_t I, typename G>
+  void assign_from(index<I>, G&& src) {
+    if (!is_init<I>()) {
+      if (src.template is_init<I>())
+        init_obj<I>(forward_obj<I>(src));
+    }
+    else if (src.template is_init<I>())
+      *obj<I>() = forward_obj<I>(src);
+    else
+      destroy_obj<I>();
+    assign_from(index<I + 1>(), std::forward<G>(src));
+  }
+
+  template <std::size_t I>
+  static const element<I>& forward_obj(const delayed_init_group& src)
+    noexcept {
+    return *src.obj<I>();
+  }
+
+  template <std::size_t I>
+  static element<I>&& forward_obj(delayed_init_group& src) noexcept {
+    return std::move(*src.obj<I>());
+  }
+
+}; // class delayed_init_group
+
+template <typename... Ts>
+constexpr std::size_t delayed_init_group<Ts...>::size;
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_GROUP_H_
@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of the masked kernels over overload::delayed_init_array.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "delayed_init_kernels.h"
+
+using overload::delayed_init_array;
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// fill()
+//------------------------------------------------------------------------------
+
+// Initialises slots with probability density. Values are small integers so
+// that sums of doubles are exact regardless of the order of summation.
+template <typename T, std::size_t N>
+void fill(delayed_init_array<T, N>& a, double density, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::bernoulli_distribution live(density);
+  std::uniform_int_distribution<int> value(-1000, 1000);
+  for (std::size_t i = 0; i < N; ++i)
+    if (live(gen))
+      a.init(i, static_cast<T>(value(gen)));
+}
+
+//------------------------------------------------------------------------------
+// test_kernels()
+//------------------------------------------------------------------------------
+
+template <typename T, std::size_t N>
+void test_kernels(int line, double density) {
+  where(line, __func__);
+  for (unsigned seed = 0; seed < 8; ++seed) {
+
+    // Dead slots keep stale values more extreme than any live value. Kernels
+    // read them but must ignore them.
+    auto a = new delayed_init_array<T, N>();
+    for (std::size_t i = 0; i < N; ++i)
+      a->init(i, static_cast<T>(i % 2 == 0 ? -5000 : 5000));
+    a->destroy_all();
+    fill(*a, density, seed);
+
+    T sum = T();
+    std::vector<T> live;
+    a->for_each([&](std::size_t, const T& x) {
+      sum += x;
+      live.push_back(x);
+    });
+
+    assert(masked_sum(*a) == sum);
+
+    const auto min = masked_min(*a);
+    const auto max = masked_max(*a);
+    assert(static_cast<bool>(min) == !live.empty());
+    assert(static_cast<bool>(max) == !live.empty());
+    if (!live.empty()) {
+      assert(*min == *std::min_element(live.begin(), live.end()));
+      assert(*max == *std::max_element(live.begin(), live.end()));
+    }
+
+    std::vector<T> out(a->size());
+    assert(compact(*a, out.data()) == live.size());
+    assert(out == live);
+
+    masked_transform(*a, [](T x) { return static_cast<T>(2 * x + 1); });
+    std::size_t j = 0;
+    a->for_each([&](std::size_t, const T& x) {
+      assert(x == static_cast<T>(2 * live[j++] + 1));
+    });
+    assert(j == live.size());
+
+    delete a;
+  }
+}
+
+//------------------------------------------------------------------------------
+// test_nan()
+//------------------------------------------------------------------------------
+
+template <typename T, std::size_t N>
+void test_nan(int line, double density) {
+  where(line, __func__);
+  const T nan = std::numeric_limits<T>::quiet_NaN();
+  const T inf = std::numeric_limits<T>::infinity();
+  for (unsigned seed = 0; seed < 8; ++seed) {
+
+    // Dead slots keep stale NaNs and a quarter of live objects are NaNs.
+    auto a = new delayed_init_array<T, N>();
+    for (std::size_t i = 0; i < N; ++i)
+      a->init(i, nan);
+    a->destroy_all();
+    fill(*a, density, seed);
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution is_nan(0.25);
+    std::vector<T> numbers;
+    std::size_t n_nans = 0;
+    a->for_each([&](std::size_t, T& x) {
+      if (is_nan(gen)) {
+        x = nan;
+        ++n_nans;
+      }
+      else
+        numbers.push_back(x);
+    });
+
+    // Sums propagate NaNs whereas min and max ignore them.
+    assert(std::isnan(masked_sum(*a)) == (n_nans != 0));
+    const auto min = masked_min(*a);
+    const auto max = masked_max(*a);
+    assert(static_cast<bool>(min) == !a->empty());
+    assert(static_cast<bool>(max) == !a->empty());
+    if (!a->empty()) {
+      assert(*min == (numbers.empty() ? inf :
+        *std::min_element(numbers.begin(), numbers.end())));
+      assert(*max == (numbers.empty() ? -inf :
+        *std::max_element(numbers.begin(), numbers.end())));
+    }
+
+    delete a;
+  }
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  for (double density : {0.0, 0.05, 0.5, 0.95, 1.0}) {
+    test_kernels<double, 1000>(__LINE__, density);
+    test_kernels<double, 4096>(__LINE__, density);
+    test_kernels<double, 3>(__LINE__, density);
+    test_kernels<float, 1000>(__LINE__, density);
+    test_kernels<int, 1000>(__LINE__, density);
+    test_kernels<std::int64_t, 130>(__LINE__, density);
+    test_nan<double, 4096>(__LINE__, density);
+    test_nan<double, 1000>(__LINE__, density);
+    test_nan<float, 1000>(__LINE__, density);
+  }
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
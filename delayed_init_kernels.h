@@ -0,0 +1,572 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+
+ /**
+  * @file delayed_init_kernels.h
+  * @brief Masked kernels over initialised objects of delayed_init_array.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_KERNELS_H_
+#define OVERLOAD_DELAYED_INIT_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "delayed_init.h"
+#include "delayed_init_array.h"
+
+/*
+ * The kernels below visit the initialised objects of a delayed_init_array of
+ * arithmetic type reading its bitmap one word at a time. Empty words are
+ * skipped, full words are processed by plain loops over contiguous objects
+ * (which the compiler vectorises) and other words by jumping from one set bit
+ * to the next. For double, reductions and compaction have hand-written paths
+ * for AVX2, SSE2 and NEON which load whole vectors and mask out (without
+ * branching) the lanes of uninitialised slots.
+ */
+
+namespace overload {
+namespace detail {
+
+constexpr std::uint64_t full_word = ~std::uint64_t(0);
+
+constexpr std::size_t n_words(std::size_t n) noexcept {
+  return (n + 63) / 64;
+}
+
+/**
+ * @brief Calls full(p) for each full word and one(x) for each initialised
+ * object in other words.
+ *
+ * @param p Pointer to the first slot.
+ * @param words Pointer to the first word of the bitmap.
+ * @param n Number of slots.
+ */
+template <typename T, typename Full, typename One>
+void for_each_word(T* p, const std::uint64_t* words, std::size_t n,
+  Full full, One one) {
+  for (std::size_t w = 0; w < n_words(n); ++w) {
+    std::uint64_t bits = words[w];
+    if (bits == full_word && 64 * w + 64 <= n)
+      full(p + 64 * w);
+    else
+      for (; bits != 0; bits &= bits - 1)
+        one(p[64 * w + ctz(bits)]);
+  }
+}
+
+template <typename T>
+T masked_sum(const T* p, const std::uint64_t* words, std::size_t n)
+  noexcept {
+  T sum = T();
+  for_each_word(p, words, n,
+    [&sum](const T* q) {
+      T s = T();
+      for (unsigned j = 0; j < 64; ++j)
+        s += q[j];
+      sum += s;
+    },
+    [&sum](const T& x) {
+      sum += x;
+    });
+  return sum;
+}
+
+template <typename T>
+T masked_min(const T* p, const std::uint64_t* words, std::size_t n)
+  noexcept {
+  T min = std::numeric_limits<T>::has_infinity ?
+    std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+  for_each_word(p, words, n,
+    [&min](const T* q) {
+      for (unsigned j = 0; j < 64; ++j)
+        min = q[j] < min ? q[j] : min;
+    },
+    [&min](const T& x) {
+      min = x < min ? x : min;
+    });
+  return min;
+}
+
+template <typename T>
+T masked_max(const T* p, const std::uint64_t* words, std::size_t n)
+  noexcept {
+  T max = std::numeric_limits<T>::has_infinity ?
+    -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+  for_each_word(p, words, n,
+    [&max](const T* q) {
+      for (unsigned j = 0; j < 64; ++j)
+        max = q[j] > max ? q[j] : max;
+    },
+    [&max](const T& x) {
+      max = x > max ? x : max;
+    });
+  return max;
+}
+
+template <typename T>
+std::size_t compact(const T* p, const std::uint64_t* words,
+  std::size_t n, T* out) noexcept {
+  T* const first = out;
+  for (std::size_t w = 0; w < n_words(n); ++w) {
+    std::uint64_t bits = words[w];
+    if (bits == full_word && 64 * w + 64 <= n) {
+      std::memcpy(out, p + 64 * w, 64 * sizeof(T));
+      out += 64;
+    }
+    else
+      for (; bits != 0; bits &= bits - 1)
+        *out++ = p[64 * w + ctz(bits)];
+  }
+  return static_cast<std::size_t>(out - first);
+}
+
+/*
+ * The overloads for double below only get full words (i.e., n % 64 == 0) and
+ * might read uninitialised slots whose values are then masked out. As the
+ * generic templates, they ignore NaNs in min and max: x86's min and max return
+ * their second operand when either is NaN and, hence, min(x, acc) equals
+ * x < acc ? x : acc, while NEON's minnm and maxnm return the number.
+ */
+
+#if defined(__AVX2__)
+
+// Lanes of 4 doubles whose bits are set in the lowest 4 bits of b.
+inline __m256i lanes4(std::uint64_t b) noexcept {
+  const __m256i sel = _mm256_set_epi64x(8, 4, 2, 1);
+  const __m256i v = _mm256_and_si256(
+    _mm256_set1_epi64x(static_cast<long long>(b)), sel);
+  return _mm256_cmpeq_epi64(v, sel);
+}
+
+inline double hadd(__m256d v) noexcept {
+  const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v),
+    _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+inline double hmin(__m256d v) noexcept {
+  const __m128d s = _mm_min_pd(_mm256_castpd256_pd128(v),
+    _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_min_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+inline double hmax(__m256d v) noexcept {
+  const __m128d s = _mm_max_pd(_mm256_castpd256_pd128(v),
+    _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_max_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+inline double masked_sum(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 8) {
+      acc0 = _mm256_add_pd(acc0, _mm256_maskload_pd(p + j, lanes4(bits >> j)));
+      acc1 = _mm256_add_pd(acc1, _mm256_maskload_pd(p + j + 4,
+        lanes4(bits >> (j + 4))));
+    }
+  }
+  return hadd(_mm256_add_pd(acc0, acc1));
+}
+
+inline double masked_min(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+  __m256d acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 4) {
+      const __m256d m = _mm256_castsi256_pd(lanes4(bits >> j));
+      acc = _mm256_min_pd(_mm256_blendv_pd(inf, _mm256_loadu_pd(p + j), m),
+        acc);
+    }
+  }
+  return hmin(acc);
+}
+
+inline double masked_max(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const __m256d inf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+  __m256d acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 4) {
+      const __m256d m = _mm256_castsi256_pd(lanes4(bits >> j));
+      acc = _mm256_max_pd(_mm256_blendv_pd(inf, _mm256_loadu_pd(p + j), m),
+        acc);
+    }
+  }
+  return hmax(acc);
+}
+
+// Permutation (of 32-bit halves) moving the lanes set in b to the front.
+struct compact_table {
+
+  std::int32_t perm[16][8];
+
+  compact_table() noexcept {
+    for (unsigned b = 0; b < 16; ++b) {
+      unsigned n = 0;
+      for (unsigned i = 0; i < 4; ++i)
+        if (b & (1u << i)) {
+          perm[b][2 * n]     = static_cast<std::int32_t>(2 * i);
+          perm[b][2 * n + 1] = static_cast<std::int32_t>(2 * i + 1);
+          ++n;
+        }
+      for (; n < 4; ++n) {
+        perm[b][2 * n]     = 0;
+        perm[b][2 * n + 1] = 1;
+      }
+    }
+  }
+
+  static const compact_table& get() noexcept {
+    static const compact_table table;
+    return table;
+  }
+};
+
+// Sparse words are better served by jumping from one set bit to the next.
+inline std::size_t compact(const double* p, const std::uint64_t* words,
+  std::size_t n, double* out) noexcept {
+  const compact_table& table = compact_table::get();
+  double* const first = out;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    std::uint64_t bits = words[w];
+    if (_mm_popcnt_u64(bits) <= 16) {
+      for (; bits != 0; bits &= bits - 1)
+        *out++ = p[ctz(bits)];
+      continue;
+    }
+    for (unsigned j = 0; j < 64; j += 4) {
+      const unsigned b = static_cast<unsigned>(bits >> j) & 0xf;
+      const unsigned live = (b & 1) + ((b >> 1) & 1) + ((b >> 2) & 1) +
+        (b >> 3);
+      const __m256i perm = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(table.perm[b]));
+      const __m256d v = _mm256_castsi256_pd(_mm256_permutevar8x32_epi32(
+        _mm256_castpd_si256(_mm256_loadu_pd(p + j)), perm));
+      _mm256_maskstore_pd(out, lanes4((1u << live) - 1), v);
+      out += live;
+    }
+  }
+  return static_cast<std::size_t>(out - first);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+// Lanes of 2 doubles whose bits are set in the lowest 2 bits of b.
+inline __m128d lanes2(std::uint64_t b) noexcept {
+  return _mm_castsi128_pd(_mm_set_epi64x(-static_cast<long long>((b >> 1) & 1),
+    -static_cast<long long>(b & 1)));
+}
+
+inline __m128d select(__m128d m, __m128d a, __m128d b) noexcept {
+  return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+}
+
+inline double masked_sum(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 4) {
+      acc0 = _mm_add_pd(acc0, _mm_and_pd(lanes2(bits >> j),
+        _mm_loadu_pd(p + j)));
+      acc1 = _mm_add_pd(acc1, _mm_and_pd(lanes2(bits >> (j + 2)),
+        _mm_loadu_pd(p + j + 2)));
+    }
+  }
+  const __m128d s = _mm_add_pd(acc0, acc1);
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+inline double masked_min(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+  __m128d acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 2)
+      acc = _mm_min_pd(select(lanes2(bits >> j), _mm_loadu_pd(p + j), inf),
+        acc);
+  }
+  return _mm_cvtsd_f64(_mm_min_sd(acc, _mm_unpackhi_pd(acc, acc)));
+}
+
+inline double masked_max(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const __m128d inf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+  __m128d acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 2)
+      acc = _mm_max_pd(select(lanes2(bits >> j), _mm_loadu_pd(p + j), inf),
+        acc);
+  }
+  return _mm_cvtsd_f64(_mm_max_sd(acc, _mm_unpackhi_pd(acc, acc)));
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+// Lanes of 2 doubles whose bits are set in the lowest 2 bits of b.
+inline uint64x2_t lanes2(std::uint64_t b) noexcept {
+  const uint64x2_t sel = vcombine_u64(vcreate_u64(1), vcreate_u64(2));
+  return vceqq_u64(vandq_u64(vdupq_n_u64(b), sel), sel);
+}
+
+inline double masked_sum(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const float64x2_t zero = vdupq_n_f64(0.0);
+  float64x2_t acc0 = zero;
+  float64x2_t acc1 = zero;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 4) {
+      acc0 = vaddq_f64(acc0, vbslq_f64(lanes2(bits >> j), vld1q_f64(p + j),
+        zero));
+      acc1 = vaddq_f64(acc1, vbslq_f64(lanes2(bits >> (j + 2)),
+        vld1q_f64(p + j + 2), zero));
+    }
+  }
+  return vaddvq_f64(vaddq_f64(acc0, acc1));
+}
+
+inline double masked_min(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const float64x2_t inf = vdupq_n_f64(std::numeric_limits<double>::infinity());
+  float64x2_t acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 2)
+      acc = vminnmq_f64(acc, vbslq_f64(lanes2(bits >> j), vld1q_f64(p + j),
+        inf));
+  }
+  return vminnmvq_f64(acc);
+}
+
+inline double masked_max(const double* p, const std::uint64_t* words,
+  std::size_t n) noexcept {
+  const float64x2_t inf =
+    vdupq_n_f64(-std::numeric_limits<double>::infinity());
+  float64x2_t acc = inf;
+  for (std::size_t w = 0; w < n / 64; ++w, p += 64) {
+    const std::uint64_t bits = words[w];
+    if (bits == 0)
+      continue;
+    for (unsigned j = 0; j < 64; j += 2)
+      acc = vmaxnmq_f64(acc, vbslq_f64(lanes2(bits >> j), vld1q_f64(p + j),
+        inf));
+  }
+  return vmaxnmvq_f64(acc);
+}
+
+#endif
+
+/*
+ * Kernels over n slots. The hand-written overloads for double (if any) get the
+ * full words and the generic templates get the last partial one (if any).
+ */
+
+template <typename T>
+T sum_of(const T* p, const std::uint64_t* words, std::size_t n) noexcept {
+  const std::size_t m = n / 64 * 64;
+  T sum = masked_sum(p, words, m);
+  if (m != n)
+    sum += masked_sum<T>(p + m, words + m / 64, n - m);
+  return sum;
+}
+
+template <typename T>
+T min_of(const T* p, const std::uint64_t* words, std::size_t n) noexcept {
+  const std::size_t m = n / 64 * 64;
+  T min = masked_min(p, words, m);
+  if (m != n) {
+    const T tail = masked_min<T>(p + m, words + m / 64, n - m);
+    min = tail < min ? tail : min;
+  }
+  return min;
+}
+
+template <typename T>
+T max_of(const T* p, const std::uint64_t* words, std::size_t n) noexcept {
+  const std::size_t m = n / 64 * 64;
+  T max = masked_max(p, words, m);
+  if (m != n) {
+    const T tail = masked_max<T>(p + m, words + m / 64, n - m);
+    max = tail > max ? tail : max;
+  }
+  return max;
+}
+
+template <typename T>
+std::size_t compact_to(const T* p, const std::uint64_t* words, std::size_t n,
+  T* out) noexcept {
+  const std::size_t m = n / 64 * 64;
+  std::size_t size = compact(p, words, m, out);
+  if (m != n)
+    size += compact<T>(p + m, words + m / 64, n - m, out + size);
+  return size;
+}
+
+} // namespace detail
+
+/**
+ * @brief Sum of initialised objects.
+ *
+ * For floating point types, the order of summation is unspecified.
+ *
+ * @param a The array.
+ * @return The sum of initialised objects (T() if there is none).
+ * @throw - Nothing.
+ */
+template <typename T, std::size_t N, typename C>
+T masked_sum(const delayed_init_array<T, N, C>& a) noexcept {
+  static_assert(std::is_arithmetic<T>::value, "masked_sum of non-arithmetic "
+    "type");
+  return detail::sum_of(a.data(), a.words(), N);
+}
+
+/**
+ * @brief Minimum of initialised objects.
+ *
+ * For floating point types, NaNs are ignored (as by std::fmin) and, if all
+ * initialised objects are NaNs, the result is infinity.
+ *
+ * @param a The array.
+ * @return The minimum of initialised objects (uninitialised if there is none).
+ * @throw - Nothing.
+ */
+template <typename T, std::size_t N, typename C>
+delayed_init<T> masked_min(const delayed_init_array<T, N, C>& a) noexcept {
+  static_assert(std::is_arithmetic<T>::value, "masked_min of non-arithmetic "
+    "type");
+  delayed_init<T> min;
+  if (!a.empty())
+    min.init_unchecked(detail::min_of(a.data(), a.words(), N));
+  return min;
+}
+
+/**
+ * @brief Maximum of initialised objects.
+ *
+ * For floating point types, NaNs are ignored (as by std::fmax) and, if all
+ * initialised objects are NaNs, the result is minus infinity.
+ *
+ * @param a The array.
+ * @return The maximum of initialised objects (uninitialised if there is none).
+ * @throw - Nothing.
+ */
+template <typename T, std::size_t N, typename C>
+delayed_init<T> masked_max(const delayed_init_array<T, N, C>& a) noexcept {
+  static_assert(std::is_arithmetic<T>::value, "masked_max of non-arithmetic "
+    "type");
+  delayed_init<T> max;
+  if (!a.empty())
+    max.init_unchecked(detail::max_of(a.data(), a.words(), N));
+  return max;
+}
+
+/**
+ * @brief Replaces each initialised object x by f(x).
+ *
+ * Objects in full words of the bitmap are transformed by a plain loop which
+ * the compiler can vectorise if f is inlined.
+ *
+ * @param a The array.
+ * @param f The transformation.
+ * @throw - Whatever f throws.
+ */
+template <typename T, std::size_t N, typename C, typename F>
+void masked_transform(delayed_init_array<T, N, C>& a, F f) {
+  static_assert(std::is_arithmetic<T>::value, "masked_transform of "
+    "non-arithmetic type");
+  detail::for_each_word(a.data(), a.words(), N,
+    [&f](T* q) {
+      for (unsigned j = 0; j < 64; ++j)
+        q[j] = f(q[j]);
+    },
+    [&f](T& x) {
+      x = f(x);
+    });
+}
+
+/**
+ * @brief Copies initialised objects into a contiguous buffer.
+ *
+ * Objects are copied in increasing order of index.
+ *
+ * @pre out has room for a.size() objects.
+ * @param a The array.
+ * @param out The output buffer.
+ * @return The number of objects copied, i.e., a.size().
+ * @throw - Nothing.
+ */
+template <typename T, std::size_t N, typename C>
+std::size_t compact(const delayed_init_array<T, N, C>& a, T* out) noexcept {
+  static_assert(std::is_arithmetic<T>::value, "compact of non-arithmetic "
+    "type");
+  return detail::compact_to(a.data(), a.words(), N, out);
+}
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_KERNELS_H_
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+
+ /**
+  * Benchmark of the masked kernels over overload::delayed_init_array<double>.
+  *
+  * Each kernel is compared against the equivalent loop over an array of
+  * overload::delayed_init<double>. Results are reported in nanoseconds per
+  * slot (initialised or not) for several densities of initialised slots and
+  * written to the standard output in JSON to allow tracking regressions per
+  * compiler (e.g. make bench writes delayed_init_kernels_bench.json).
+  */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "delayed_init_kernels.h"
+
+using overload::delayed_init;
+using overload::delayed_init_array;
+
+constexpr std::size_t n_slots = 50000;
+constexpr unsigned n_runs = 200;
+
+// Prevents the compiler from optimising away a result.
+volatile double sink;
+
+//------------------------------------------------------------------------------
+// time_per_slot()
+//------------------------------------------------------------------------------
+
+template <typename F>
+double time_per_slot(F f) {
+  f();
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned run = 0; run < n_runs; ++run)
+    f();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+    (double(n_runs) * n_slots);
+}
+
+//------------------------------------------------------------------------------
+// JSON output.
+//------------------------------------------------------------------------------
+
+bool first_result = true;
+
+void report(const char* holder_name, const char* kernel, double density,
+  double ns_per_slot) {
+  std::printf("%s\n    {\"holder\": \"%s\", \"kernel\": \"%s\", "
+    "\"density\": %.2f, \"ns_per_slot\": %.4f}",
+    first_result ? "" : ",", holder_name, kernel, density, ns_per_slot);
+  first_result = false;
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  std::printf("{\n  \"compiler\": \"%s\",\n  \"cplusplus\": %ld,\n"
+    "  \"results\": [", __VERSION__, long(__cplusplus));
+
+  for (double density : {0.05, 0.5, 0.95}) {
+
+    std::vector<delayed_init<double>> naive(n_slots);
+    auto a = new delayed_init_array<double, n_slots>();
+    std::vector<double> out(n_slots);
+
+    std::mt19937 gen(0);
+    std::bernoulli_distribution live(density);
+    for (std::size_t i = 0; i < n_slots; ++i)
+      if (live(gen)) {
+        naive[i].init(double(i));
+        a->init(i, double(i));
+      }
+
+    const double sum_naive = time_per_slot([&] {
+      double sum = 0.0;
+      for (const auto& d : naive)
+        if (d)
+          sum += *d;
+      sink = sum;
+    });
+    const double sum_masked = time_per_slot([&] {
+      sink = masked_sum(*a);
+    });
+    report("delayed_init", "sum", density, sum_naive);
+    report("masked", "sum", density, sum_masked);
+
+    const double max_naive = time_per_slot([&] {
+      double max = -1.0;
+      for (const auto& d : naive)
+        if (d && *d > max)
+          max = *d;
+      sink = max;
+    });
+    const double max_masked = time_per_slot([&] {
+      sink = *masked_max(*a);
+    });
+    report("delayed_init", "max", density, max_naive);
+    report("masked", "max", density, max_masked);
+
+    const double transform_naive = time_per_slot([&] {
+      for (auto& d : naive)
+        if (d)
+          *d = *d * 0.5 + 1.0;
+    });
+    const double transform_masked = time_per_slot([&] {
+      masked_transform(*a, [](double x) { return x * 0.5 + 1.0; });
+    });
+    report("delayed_init", "transform", density, transform_naive);
+    report("masked", "transform", density, transform_masked);
+
+    const double compact_naive = time_per_slot([&] {
+      std::size_t n = 0;
+      for (const auto& d : naive)
+        if (d)
+          out[n++] = *d;
+      sink = double(n);
+    });
+    const double compact_masked = time_per_slot([&] {
+      sink = double(compact(*a, out.data()));
+    });
+    report("delayed_init", "compact", density, compact_naive);
+    report("masked", "compact", density, compact_masked);
+
+    delete a;
+  }
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,274 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::parallel_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "delayed_init_parallel.h"
+
+using overload::delayed_init;
+using overload::init_step;
+using overload::inline_executor;
+using overload::parallel_init;
+using overload::parallel_init_on;
+
+// Counts live objects.
+struct tracked {
+
+  static std::atomic<int> live;
+
+  explicit tracked(int v) noexcept : value(v) {
+    ++live;
+  }
+
+  tracked(const tracked& other) noexcept : value(other.value) {
+    ++live;
+  }
+
+  ~tracked() noexcept {
+    --live;
+  }
+
+  int value;
+};
+
+std::atomic<int> tracked::live(0);
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_constructor()
+//------------------------------------------------------------------------------
+
+// Members with complex initialisation built in the constructor body.
+class service {
+
+public:
+
+  explicit service(int n) {
+    parallel_init(
+      init_step(table_, [n] { return std::vector<int>(n, 1); }),
+      init_step(name_, [] { return std::string("service"); }),
+      init_step(total_, [this] {
+        long total = 0;
+        for (int x : *table_)
+          total += x;
+        return total;
+      }, {0}));
+  }
+
+  const std::vector<int>& table() const {
+    return *table_;
+  }
+
+  const std::string& name() const {
+    return *name_;
+  }
+
+  long total() const {
+    return *total_;
+  }
+
+private:
+
+  delayed_init<std::vector<int>> table_;
+  delayed_init<std::string>      name_;
+  delayed_init<long>             total_;
+
+}; // class service
+
+void test_constructor(int line) {
+  where(line, __func__);
+  const service s(1000);
+  assert(s.table().size() == 1000);
+  assert(s.name() == "service");
+  assert(s.total() == 1000);
+}
+
+//------------------------------------------------------------------------------
+// test_concurrency()
+//------------------------------------------------------------------------------
+
+// Waits (up to a few seconds) until n threads have arrived.
+bool rendezvous(std::atomic<int>& arrived, int n) {
+  ++arrived;
+  const auto deadline = std::chrono::steady_clock::now() +
+    std::chrono::seconds(10);
+  while (arrived < n)
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    else
+      std::this_thread::yield();
+  return true;
+}
+
+void test_concurrency(int line) {
+  where(line, __func__);
+  std::atomic<int> arrived(0);
+  delayed_init<bool> a, b, c;
+  const auto f = [&] { return rendezvous(arrived, 3); };
+  parallel_init(init_step(a, f), init_step(b, f), init_step(c, f));
+  // Steps ran at the same time.
+  assert(*a && *b && *c);
+}
+
+//------------------------------------------------------------------------------
+// test_dependencies()
+//------------------------------------------------------------------------------
+
+void test_dependencies(int line) {
+  where(line, __func__);
+  std::string order;
+  delayed_init<int> a, b, c, d;
+  parallel_init_on(inline_executor(),
+    init_step(a, [&] { order += 'a'; return 1; }),
+    init_step(b, [&] { order += 'b'; return *a + 1; }, {0}),
+    init_step(c, [&] { order += 'c'; return 10; }),
+    init_step(d, [&] { order += 'd'; return *b + *c; }, {1, 2}));
+  assert(order == "acbd");
+  assert(*d == 12);
+
+  delayed_init<int> e, f, g;
+  parallel_init(
+    init_step(e, [] { return 2; }),
+    init_step(f, [&] { return *e * 3; }, {0}),
+    init_step(g, [&] { return *f * 5; }, {1}));
+  assert(*g == 30);
+}
+
+//------------------------------------------------------------------------------
+// test_failure()
+//------------------------------------------------------------------------------
+
+void test_failure(int line) {
+  where(line, __func__);
+  delayed_init<tracked> a, b, c, d;
+  bool d_ran = false;
+  try {
+    parallel_init(
+      init_step(a, [] { return tracked(1); }),
+      init_step(b, []() -> tracked { throw std::runtime_error("b"); }),
+      init_step(c, [] { return tracked(3); }),
+      init_step(d, [&] { d_ran = true; return tracked(*b); }, {1}));
+    assert(false);
+  }
+  catch (std::runtime_error& e) {
+    assert(std::string(e.what()) == "b");
+  }
+  assert(!a && !b && !c && !d);
+  assert(!d_ran);
+  assert(tracked::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_invalid_dependency()
+//------------------------------------------------------------------------------
+
+void test_invalid_dependency(int line) {
+  where(line, __func__);
+  delayed_init<int> a, b;
+  try {
+    parallel_init(init_step(a, [&] { return *b; }, {1}),
+      init_step(b, [] { return 1; }));
+    assert(false);
+  }
+  catch (std::invalid_argument&) {
+  }
+  assert(!a && !b);
+}
+
+//------------------------------------------------------------------------------
+// test_executor_failure()
+//------------------------------------------------------------------------------
+
+// Runs the first n jobs inline and then fails.
+struct failing_executor {
+  template <typename J>
+  void operator()(J job) {
+    if (n-- == 0)
+      throw std::runtime_error("executor");
+    job();
+  }
+  int n;
+};
+
+void test_executor_failure(int line) {
+  where(line, __func__);
+  delayed_init<tracked> a, b, c;
+  try {
+    parallel_init_on(failing_executor{2},
+      init_step(a, [] { return tracked(1); }),
+      init_step(b, [] { return tracked(2); }),
+      init_step(c, [] { return tracked(3); }));
+    assert(false);
+  }
+  catch (std::runtime_error& e) {
+    assert(std::string(e.what()) == "executor");
+  }
+  assert(!a && !b && !c);
+  assert(tracked::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_constructor(__LINE__);
+  test_concurrency(__LINE__);
+  test_dependencies(__LINE__);
+  test_failure(__LINE__);
+  test_invalid_dependency(__LINE__);
+  test_executor_failure(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
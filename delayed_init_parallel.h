@@ -0,0 +1,353 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init_parallel.h
+  * @brief Parallel initialisation of independent delayed_init objects.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_PARALLEL_H_
+#define OVERLOAD_DELAYED_INIT_PARALLEL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <initializer_list>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "delayed_init.h"
+
+#ifndef OVERLOAD_DELAYED_INIT_LEAN
+#include <stdexcept>
+#endif
+
+namespace overload {
+
+/**
+ * @brief Executor running each job on a new thread (through std::async).
+ *
+ * An executor ex is called as ex(job) where job is a copyable nullary
+ * callable which doesn't throw. The executor must run job exactly once, on
+ * any thread, and might throw if it can't. parallel_init_on() only calls it
+ * from the calling thread.
+ *
+ * Destruction waits for all jobs to finish.
+ */
+class async_executor {
+
+public:
+
+  template <typename J>
+  void operator()(J job) {
+    futures_.push_back(std::async(std::launch::async, job));
+  }
+
+private:
+
+  std::vector<std::future<void>> futures_;
+
+}; // class async_executor
+
+/**
+ * @brief Executor running each job immediately on the calling thread.
+ *
+ * This gives a serial initialisation in a valid order of dependencies, which
+ * helps debugging.
+ */
+struct inline_executor {
+
+  template <typename J>
+  void operator()(J job) const {
+    job();
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief A delayed_init together with its initialiser and dependencies.
+ *
+ * @tparam D Type of the delayed_init.
+ * @tparam F Type of the initialiser.
+ */
+template <typename D, typename F>
+struct init_step {
+
+  D&                       d;
+  F                        f;
+  std::vector<std::size_t> after;
+
+  static void run(void* step) {
+    init_step& self = *static_cast<init_step*>(step);
+    self.d.init_with(self.f);
+  }
+
+  static void undo(void* step) noexcept {
+    inner_access::destroy(static_cast<init_step*>(step)->d);
+  }
+};
+
+/**
+ * @brief Type-erased init_step and its scheduling state.
+ *
+ * Only error and is_init are written by the worker running the step.
+ */
+struct parallel_node {
+
+  template <typename D, typename F>
+  explicit parallel_node(init_step<D, F>& s) : step(&s),
+    run(&init_step<D, F>::run), undo(&init_step<D, F>::undo),
+    after(s.after), n_pending(s.after.size()), is_init(false) {
+  }
+
+  void*                           step;
+  void                            (*run)(void*);
+  void                            (*undo)(void*) noexcept;
+  const std::vector<std::size_t>& after;
+  std::vector<std::size_t>        dependents;
+  std::size_t                     n_pending;
+  std::exception_ptr              error;
+  bool                            is_init;
+};
+
+/**
+ * @brief Queue of indices of finished nodes shared with workers.
+ */
+class parallel_queue {
+
+public:
+
+  void push(std::size_t i) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_.push_back(i);
+    // Notifying under the lock prevents the waiter from returning (and
+    // destroying *this) before this call is over.
+    ready_.notify_one();
+  }
+
+  void pop_all(std::vector<std::size_t>& out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return !finished_.empty(); });
+    out.swap(finished_);
+  }
+
+  void reserve(std::size_t n) {
+    finished_.reserve(n);
+  }
+
+private:
+
+  std::mutex               mutex_;
+  std::condition_variable  ready_;
+  std::vector<std::size_t> finished_;
+
+}; // class parallel_queue
+
+/**
+ * @brief Calls f() and returns the exception it throws (or nullptr).
+ *
+ * Without exceptions (see OVERLOAD_DELAYED_INIT_LEAN), f() can't throw and
+ * this merely calls it.
+ */
+template <typename F>
+std::exception_ptr capture(F f) noexcept {
+#ifdef OVERLOAD_DELAYED_INIT_LEAN
+  f();
+  return nullptr;
+#else
+  try {
+    f();
+    return nullptr;
+  }
+  catch (...) {
+    return std::current_exception();
+  }
+#endif
+}
+
+/**
+ * @brief Job given to executors: runs a node and reports to the queue.
+ */
+struct parallel_job {
+
+  parallel_node*  node;
+  parallel_queue* queue;
+  std::size_t     i;
+
+  void operator()() const noexcept {
+    parallel_node* const n = node;
+    n->error = capture([n] {
+      n->run(n->step);
+      n->is_init = true;
+    });
+    queue->push(i);
+  }
+};
+
+/**
+ * @brief Runs the steps of nodes on ex as their dependencies finish.
+ *
+ * Once a step fails, steps not yet submitted are skipped. When all submitted
+ * steps have finished, steps which succeeded are undone in reverse order and
+ * the first error is rethrown.
+ */
+template <typename Executor>
+void parallel_run(Executor& ex, std::vector<parallel_node>& nodes) {
+
+  const std::size_t n = nodes.size();
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j : nodes[i].after) {
+      if (j >= i) {
+#ifdef OVERLOAD_DELAYED_INIT_LEAN
+        std::terminate();
+#else
+        throw std::invalid_argument("init_step depends on a later step");
+#endif
+      }
+      nodes[j].dependents.push_back(i);
+    }
+
+  parallel_queue queue;
+  // Finished nodes whose dependents are still to be released.
+  std::vector<std::size_t> finished, batch;
+  queue.reserve(n);
+  finished.reserve(n);
+  batch.reserve(n);
+  std::exception_ptr error;
+
+  const auto submit = [&](std::size_t i) {
+    if (!error) {
+      // On success, the job owns nodes[i].error (and might have finished).
+      const std::exception_ptr e = capture([&] {
+        ex(parallel_job{&nodes[i], &queue, i});
+      });
+      if (!e)
+        return;
+      nodes[i].error = e;
+    }
+    finished.push_back(i);
+  };
+
+  for (std::size_t i = 0; i < n; ++i)
+    if (nodes[i].n_pending == 0)
+      submit(i);
+
+  for (std::size_t n_finished = 0; ; ) {
+    while (!finished.empty()) {
+      const std::size_t i = finished.back();
+      finished.pop_back();
+      ++n_finished;
+      if (!error && nodes[i].error)
+        error = nodes[i].error;
+      for (std::size_t k : nodes[i].dependents)
+        if (--nodes[k].n_pending == 0)
+          submit(k);
+    }
+    if (n_finished == n)
+      break;
+    queue.pop_all(batch);
+    finished.insert(finished.end(), batch.begin(), batch.end());
+    batch.clear();
+  }
+
+  if (error) {
+    for (std::size_t i = n; i-- != 0; )
+      if (nodes[i].is_init)
+        nodes[i].undo(nodes[i].step);
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Makes a step of parallel_init().
+ *
+ * @param d The delayed_init to be initialised from f().
+ * @param f Initialiser (a nullary callable whose result builds d's object).
+ * @param after Indices (in the argument list of parallel_init) of the earlier
+ * steps that must finish before this one starts (e.g., because f reads their
+ * objects).
+ * @return The step.
+ */
+template <typename D, typename F>
+detail::init_step<D, typename std::decay<F>::type>
+init_step(D& d, F&& f, std::initializer_list<std::size_t> after = {}) {
+  return {d, std::forward<F>(f), after};
+}
+
+/**
+ * @brief Initialises several delayed_init objects concurrently on ex.
+ *
+ * This speeds up the pattern of delayed_init members initialised in the
+ * constructor body when their initialisations are expensive and mostly
+ * independent. A step starts as soon as all steps it depends on have
+ * finished. The call returns when all steps have finished.
+ *
+ * If a step throws, then steps that haven't started yet are skipped, the
+ * objects built by the others are destroyed and the first exception is
+ * rethrown. (Hence, an enclosing constructor can let it propagate without
+ * leaving built members behind.)
+ *
+ * @pre Each step refers to a different uninitialised delayed_init.
+ * @post All objects are initialised or, if this call throws, none is.
+ * @param ex Executor (see async_executor).
+ * @param steps The steps (see init_step()).
+ * @throw std::invalid_argument If a step depends on itself or on a later one
+ * (std::terminate() is called in the lean configuration, see
+ * OVERLOAD_DELAYED_INIT_LEAN).
+ * @throw - Whatever the executor or an initialiser throws.
+ */
+template <typename Executor, typename... D, typename... F>
+void parallel_init_on(Executor&& ex, detail::init_step<D, F>... steps) {
+  std::vector<detail::parallel_node> nodes;
+  nodes.reserve(sizeof...(steps));
+  using expand = int[];
+  (void) expand{0, (nodes.emplace_back(steps), 0)...};
+  detail::parallel_run(ex, nodes);
+}
+
+/**
+ * @brief Initialises several delayed_init objects concurrently (one thread
+ * per step).
+ *
+ * Equivalent to parallel_init_on(async_executor(), steps...).
+ */
+template <typename... D, typename... F>
+void parallel_init(detail::init_step<D, F>... steps) {
+  parallel_init_on(async_executor(), std::move(steps)...);
+}
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_PARALLEL_H_
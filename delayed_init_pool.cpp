@@ -0,0 +1,261 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::delayed_init_pool.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "delayed_init_pool.h"
+
+using overload::delayed_init_pool;
+using overload::pool_handle;
+
+// Counts live objects and throws on demand.
+struct entity {
+
+  static int live;
+
+  explicit entity(int i, bool fail = false) : id(i), name(50, 'e') {
+    if (fail)
+      throw std::runtime_error("entity");
+    ++live;
+  }
+
+  entity(entity&& other) noexcept : id(other.id), name(std::move(other.name)) {
+    ++live;
+  }
+
+  ~entity() noexcept {
+    --live;
+  }
+
+  int         id;
+  std::string name;
+};
+
+int entity::live = 0;
+
+static_assert(sizeof(overload::detail::pool_slot<int>) == 2 * sizeof(int),
+  "pool_slot<int> is not as large as an index and an int");
+static_assert(sizeof(pool_handle) == 8, "pool_handle is not 8 bytes");
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_emplace_release()
+//------------------------------------------------------------------------------
+
+void test_emplace_release(int line) {
+  where(line, __func__);
+  delayed_init_pool<int> p;
+  assert(p.empty() && p.capacity() == 0);
+  assert(!p.contains(pool_handle()));
+
+  const pool_handle a = p.emplace(1);
+  const pool_handle b = p.emplace(2);
+  assert(p.size() == 2 && p.capacity() == 8);
+  assert(a != b && *p.get(a) == 1 && p[b] == 2);
+  p[a] = 10;
+  assert(*p.get(a) == 10);
+
+  assert(p.release(a));
+  assert(!p.release(a));
+  assert(p.size() == 1 && !p.contains(a) && p.get(a) == nullptr);
+  try {
+    p[a];
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+
+  // The freed slot is reused but old handles remain stale.
+  const pool_handle c = p.emplace(3);
+  assert(c.index == a.index && c.generation != a.generation);
+  assert(p.get(a) == nullptr && p[c] == 3);
+
+  p.clear();
+  assert(p.empty() && !p.contains(b) && !p.contains(c));
+  assert(p.capacity() == 8);
+}
+
+//------------------------------------------------------------------------------
+// test_growth()
+//------------------------------------------------------------------------------
+
+int value_of(int x) {
+  return x;
+}
+
+int value_of(double x) {
+  return static_cast<int>(x);
+}
+
+int value_of(const entity& e) {
+  return e.id;
+}
+
+template <typename T>
+void test_growth(int line) {
+  where(line, __func__);
+  delayed_init_pool<T> p(4);
+  std::vector<pool_handle> handles;
+  std::vector<bool> released(1000, false);
+  for (int i = 0; i < 1000; ++i) {
+    handles.push_back(p.emplace(i));
+    if (i % 3 == 0) {
+      assert(p.release(handles[i / 2]));
+      released[i / 2] = true;
+    }
+  }
+  for (int i = 0; i < 1000; ++i) {
+    const T* obj = p.get(handles[i]);
+    assert(released[i] ? obj == nullptr : obj && value_of(*obj) == i);
+  }
+  assert(p.size() == 1000 - 334);
+}
+
+//------------------------------------------------------------------------------
+// test_lifetime()
+//------------------------------------------------------------------------------
+
+void test_lifetime(int line) {
+  where(line, __func__);
+  {
+    delayed_init_pool<entity> p;
+    std::vector<pool_handle> handles;
+    for (int i = 0; i < 20; ++i)
+      handles.push_back(p.emplace(i));
+    assert(entity::live == 20);
+    assert(p[handles[13]].id == 13 && p[handles[13]].name.size() == 50);
+
+    // Failed constructions leave the pool unchanged.
+    const std::uint32_t size = p.size();
+    try {
+      p.emplace(-1, true);
+      assert(false);
+    }
+    catch (std::runtime_error&) {
+    }
+    assert(p.size() == size && entity::live == 20);
+    const pool_handle h = p.emplace(20);
+    assert(p[h].id == 20);
+
+    p.release(handles[0]);
+    p.release(handles[5]);
+    assert(entity::live == 19);
+    int sum = 0, n = 0;
+    p.for_each([&](pool_handle k, entity& e) {
+      assert(p.get(k) == &e);
+      sum += e.id;
+      ++n;
+    });
+    assert(n == 19 && sum == 210 - 5);
+
+    // Moves keep handles valid.
+    delayed_init_pool<entity> q(std::move(p));
+    assert(p.empty() && p.capacity() == 0 && !p.contains(h));
+    assert(q[h].id == 20);
+    p = std::move(q);
+    assert(p[h].id == 20 && entity::live == 19);
+  }
+  assert(entity::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_emplace_alias()
+//------------------------------------------------------------------------------
+
+void test_emplace_alias(int line) {
+  where(line, __func__);
+  delayed_init_pool<std::string> p;
+  std::vector<pool_handle> handles;
+  for (int i = 0; i < 8; ++i)
+    handles.push_back(p.emplace(40, char('a' + i)));
+  assert(p.size() == p.capacity());
+
+  // The pool grows while the argument refers to one of its objects.
+  const pool_handle h = p.emplace(p[handles[0]]);
+  assert(p.capacity() == 16 && p[h] == std::string(40, 'a'));
+  for (int i = 0; i < 8; ++i)
+    assert(p[handles[i]] == std::string(40, char('a' + i)));
+
+  // Failed constructions leave a full pool unchanged.
+  delayed_init_pool<entity> q;
+  for (int i = 0; i < 8; ++i)
+    handles[i] = q.emplace(i);
+  try {
+    q.emplace(-1, true);
+    assert(false);
+  }
+  catch (std::runtime_error&) {
+  }
+  assert(q.size() == 8 && q.capacity() == 8 && entity::live == 8);
+  for (int i = 0; i < 8; ++i)
+    assert(q[handles[i]].id == i && q[handles[i]].name.size() == 50);
+  const pool_handle k = q.emplace(8);
+  assert(q.capacity() == 16 && k.index == 8 && q[k].id == 8);
+  for (int i = 0; i < 8; ++i)
+    assert(q[handles[i]].id == i);
+  q.clear();
+  assert(entity::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_emplace_release(__LINE__);
+  test_growth<int>(__LINE__);
+  test_growth<double>(__LINE__);
+  test_growth<entity>(__LINE__);
+  test_lifetime(__LINE__);
+  test_emplace_alias(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
@@ -0,0 +1,631 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init_pool.h
+  * @brief Definition of class delayed_init_pool.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_POOL_H_
+#define OVERLOAD_DELAYED_INIT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+
+/**
+ * @brief Stable reference to an object of a delayed_init_pool.
+ *
+ * A handle is the index of a slot and the generation of the slot when the
+ * object was built. Once the object is released, the slot's generation
+ * changes and the handle becomes stale (even if the slot is reused). A
+ * default constructed handle is always stale.
+ */
+struct pool_handle {
+
+  std::uint32_t index;
+  std::uint32_t generation;
+
+  constexpr pool_handle() noexcept : index(0), generation(0) {
+  }
+
+  constexpr pool_handle(std::uint32_t i, std::uint32_t g) noexcept : index(i),
+    generation(g) {
+  }
+
+  constexpr bool operator==(const pool_handle& other) const noexcept {
+    return index == other.index && generation == other.generation;
+  }
+
+  constexpr bool operator!=(const pool_handle& other) const noexcept {
+    return !(*this == other);
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief Slot of delayed_init_pool.
+ *
+ * The generation is odd if, and only if, the slot holds an object. Otherwise,
+ * the bytes of the object hold the index of the next free slot.
+ */
+template <typename T>
+struct pool_slot {
+
+  pool_slot(std::uint32_t g, std::uint32_t n) noexcept : generation(g),
+    next(n) {
+  }
+
+  ~pool_slot() noexcept {
+  }
+
+  bool is_init() const noexcept {
+    return generation & 1;
+  }
+
+  std::uint32_t generation;
+  union {
+    std::uint32_t next;
+    T             obj;
+  };
+
+}; // struct pool_slot
+
+} // namespace detail
+
+/**
+ * @brief Pool of objects of type T in contiguous slots addressed by handles.
+ *
+ * Class delayed_init_pool<T> is a slot map: emplace() builds an object in a
+ * free slot and returns a handle to it which remains valid until release().
+ * Both are O(1). As in delayed_init, a slot is storage for T in a union with
+ * a state which, here, is a generation counter (its parity tells whether the
+ * slot is initialised). The bytes of free slots, otherwise dead, hold the
+ * links of the list of free slots. Hence, there's no side table and no per
+ * object allocation.
+ *
+ * Stale handles (whose objects have been released) are detected even when the
+ * slot has been reused (no ABA problem) since generations differ. (They wrap
+ * around after 2^31 reuses of a slot.)
+ *
+ * The slots grow geometrically as needed, moving (or, for trivially
+ * relocatable types, copying the bytes of) objects into the new slots. This
+ * invalidates pointers and references to objects but not handles. Freed slots
+ * are reused in LIFO order which keeps accesses local. for_each() visits
+ * objects in memory order.
+ *
+ * Objects of this class are movable but not copyable. They are not
+ * thread-safe.
+ *
+ * The type T must not be a reference type and T::~T() must not throw.
+ */
+template <typename T, typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class delayed_init_pool {
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "delayed_init_pool for reference type");
+
+  typedef detail::pool_slot<T> slot;
+
+  // Index marking the end of the list of free slots.
+  static constexpr std::uint32_t npos =
+    std::numeric_limits<std::uint32_t>::max();
+
+public:
+
+  typedef T value_type;
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post size() == 0 && capacity() == 0.
+   * @throw - Nothing.
+   */
+  delayed_init_pool() noexcept : slots_(nullptr), capacity_(0), size_(0),
+    free_(npos) {
+  }
+
+  /**
+   * @brief Constructor with initial capacity.
+   *
+   * @post size() == 0 && capacity() == n.
+   * @param n Number of slots.
+   * @throw std::bad_alloc If allocation fails.
+   */
+  explicit delayed_init_pool(std::uint32_t n) : delayed_init_pool() {
+    reserve(n);
+  }
+
+  delayed_init_pool(const delayed_init_pool&) = delete;
+
+  delayed_init_pool& operator=(const delayed_init_pool&) = delete;
+
+  /**
+   * @brief Move-constructor.
+   *
+   * Handles to src's objects refer to the objects of *this.
+   *
+   * @post src.size() == 0 && src.capacity() == 0.
+   * @param src Source.
+   * @throw - Nothing.
+   */
+  delayed_init_pool(delayed_init_pool&& src) noexcept : delayed_init_pool() {
+    swap(src);
+  }
+
+  /**
+   * @brief Move-assignment.
+   *
+   * @post src.size() == 0 && src.capacity() == 0.
+   * @param src Source.
+   * @throw - Nothing.
+   */
+  delayed_init_pool& operator=(delayed_init_pool&& src) noexcept {
+    delayed_init_pool(std::move(src)).swap(*this);
+    return *this;
+  }
+
+  /**
+   * @brief Destructor.
+   *
+   * Destroys all objects.
+   *
+   * @throw - Nothing.
+   */
+  ~delayed_init_pool() noexcept {
+    destroy_all();
+    deallocate(slots_, capacity_);
+  }
+
+  /**
+   * @brief Number of objects.
+   */
+  std::uint32_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * @brief Whether there is no object.
+   */
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief Number of slots.
+   */
+  std::uint32_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  /**
+   * @brief Ensures there are at least n slots.
+   *
+   * @post capacity() >= n.
+   * @param n Number of slots.
+   * @throw std::bad_alloc If allocation fails.
+   * @throw - Whatever T::T(T&&) or T::T(const T&) throws (if T's move might
+   * throw). In this case, *this is unchanged.
+   */
+  void reserve(std::uint32_t n) {
+    if (n > capacity_)
+      grow(n);
+  }
+
+  /**
+   * @brief Builds an object.
+   *
+   * The object is built by forwarding arguments to T's constructor. If it
+   * throws, then *this is unchanged. The arguments might refer to objects of
+   * *this: when the slots grow, the object is built in the new slots before
+   * the others are moved there.
+   *
+   * @param args Initialisation arguments.
+   * @return A handle to the object.
+   * @throw std::bad_alloc If allocation fails.
+   * @throw - Whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  pool_handle emplace(Args&&... args) {
+    if (free_ == npos)
+      return grow_emplace(std::forward<Args>(args)...);
+    const std::uint32_t i = free_;
+    slot& s = slots_[i];
+    const std::uint32_t next = s.next;
+    link_guard guard(s);
+    new ((void *) &s.obj) T(std::forward<Args>(args)...);
+    guard.release();
+    free_ = next;
+    ++s.generation;
+    ++size_;
+    return pool_handle(i, s.generation);
+  }
+
+  /**
+   * @brief Destroys an object and frees its slot.
+   *
+   * @param h Handle to the object.
+   * @return false if h is stale (and nothing is done). Otherwise, true.
+   * @throw - Nothing.
+   */
+  bool release(pool_handle h) noexcept {
+    if (!contains(h))
+      return false;
+    free_slot(h.index);
+    return true;
+  }
+
+  /**
+   * @brief Whether a handle refers to an object.
+   *
+   * @param h Handle.
+   * @return true if the object of h has not been released. Otherwise, false.
+   * @throw - Nothing.
+   */
+  bool contains(pool_handle h) const noexcept {
+    return h.index < capacity_ && (h.generation & 1) &&
+      slots_[h.index].generation == h.generation;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @param h Handle.
+   * @return A pointer to the object of h if contains(h) == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  T* get(pool_handle h) noexcept {
+    return contains(h) ? &slots_[h.index].obj : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @param h Handle.
+   * @return A pointer to the object of h if contains(h) == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  const T* get(pool_handle h) const noexcept {
+    return contains(h) ? &slots_[h.index].obj : nullptr;
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre contains(h) == true.
+   * @param h Handle.
+   * @return *get(h).
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  T& operator[](pool_handle h) noexcept(Check::is_nothrow) {
+    if (!contains(h))
+      Check::fail("attempt to use stale handle");
+    return slots_[h.index].obj;
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre contains(h) == true.
+   * @param h Handle.
+   * @return *get(h).
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  const T& operator[](pool_handle h) const noexcept(Check::is_nothrow) {
+    if (!contains(h))
+      Check::fail("attempt to use stale handle");
+    return slots_[h.index].obj;
+  }
+
+  /**
+   * @brief Calls f(h, obj) for each object obj of handle h in memory order.
+   *
+   * f must not emplace or release objects.
+   *
+   * @param f Function.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each(F&& f) {
+    for (std::uint32_t i = 0; i < capacity_; ++i)
+      if (slots_[i].is_init())
+        f(pool_handle(i, slots_[i].generation), slots_[i].obj);
+  }
+
+  /**
+   * @brief Calls f(h, obj) for each object obj of handle h in memory order
+   * (const).
+   *
+   * @param f Function.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each(F&& f) const {
+    for (std::uint32_t i = 0; i < capacity_; ++i)
+      if (slots_[i].is_init())
+        f(pool_handle(i, slots_[i].generation),
+          static_cast<const T&>(slots_[i].obj));
+  }
+
+  /**
+   * @brief Destroys all objects (and makes all handles stale).
+   *
+   * @post size() == 0.
+   * @throw - Nothing.
+   */
+  void clear() noexcept {
+    for (std::uint32_t i = capacity_; i-- != 0; )
+      if (slots_[i].is_init())
+        free_slot(i);
+  }
+
+  /**
+   * @brief Swaps with another pool.
+   *
+   * @param src Object to swap with.
+   * @throw - Nothing.
+   */
+  void swap(delayed_init_pool& src) noexcept {
+    std::swap(slots_, src.slots_);
+    std::swap(capacity_, src.capacity_);
+    std::swap(size_, src.size_);
+    std::swap(free_, src.free_);
+  }
+
+private:
+
+  slot*         slots_;
+  std::uint32_t capacity_;
+  std::uint32_t size_;
+  std::uint32_t free_;
+
+  static slot* allocate(std::uint32_t n) {
+    return static_cast<slot*>(storage::new_delete_resource::allocate(
+      n * sizeof(slot), alignof(slot)));
+  }
+
+  static void deallocate(slot* slots, std::uint32_t n) noexcept {
+    if (slots)
+      storage::new_delete_resource::deallocate(slots, n * sizeof(slot),
+        alignof(slot));
+  }
+
+  void free_slot(std::uint32_t i) noexcept {
+    slot& s = slots_[i];
+    s.obj.~T();
+    ++s.generation;
+    s.next = free_;
+    free_ = i;
+    --size_;
+  }
+
+  void destroy_all() noexcept {
+    for (std::uint32_t i = 0; i < capacity_; ++i)
+      if (slots_[i].is_init())
+        slots_[i].obj.~T();
+  }
+
+  /**
+   * @brief Reports that the number of slots can't grow.
+   *
+   * Throws std::bad_alloc or, in the lean configuration (see
+   * OVERLOAD_DELAYED_INIT_LEAN), calls std::terminate().
+   */
+  [[noreturn]] static void fail_capacity() {
+#ifdef OVERLOAD_DELAYED_INIT_LEAN
+    std::terminate();
+#else
+    throw std::bad_alloc();
+#endif
+  }
+
+  /**
+   * @brief Restores the link of a free slot unless released.
+   *
+   * Building an object in a free slot overwrites the link to the next one
+   * (they share bytes). If the constructor throws, the destructor writes it
+   * back.
+   */
+  class link_guard {
+
+  public:
+
+    explicit link_guard(slot& s) noexcept : slot_(&s), next_(s.next) {
+    }
+
+    link_guard(const link_guard&) = delete;
+
+    link_guard& operator=(const link_guard&) = delete;
+
+    ~link_guard() noexcept {
+      if (slot_)
+        slot_->next = next_;
+    }
+
+    void release() noexcept {
+      slot_ = nullptr;
+    }
+
+  private:
+
+    slot*         slot_;
+    std::uint32_t next_;
+
+  }; // class link_guard
+
+  /**
+   * @brief New slots being filled.
+   *
+   * Unless released, the destructor destroys the objects built so far (those
+   * of initialised slots in [0, n_relocated) and of slot i_built, if any) and
+   * frees the slots.
+   */
+  class buffer {
+
+  public:
+
+    explicit buffer(std::uint32_t n) : slots(allocate(n)), n_slots(n),
+      n_relocated(0), i_built(npos) {
+    }
+
+    buffer(const buffer&) = delete;
+
+    buffer& operator=(const buffer&) = delete;
+
+    ~buffer() noexcept {
+      if (!slots)
+        return;
+      if (i_built != npos)
+        slots[i_built].obj.~T();
+      while (n_relocated-- != 0)
+        if (slots[n_relocated].is_init())
+          slots[n_relocated].obj.~T();
+      deallocate(slots, n_slots);
+    }
+
+    slot*         slots;
+    std::uint32_t n_slots;
+    std::uint32_t n_relocated;
+    std::uint32_t i_built;
+
+  }; // class buffer
+
+  /**
+   * @brief Number of slots after growing when there's no free one.
+   */
+  std::uint32_t next_capacity() const noexcept {
+    return capacity_ < 8 ? 8 : capacity_ > npos / 2 ? npos : 2 * capacity_;
+  }
+
+  /**
+   * @brief Moves slots to n >= capacity() new ones and frees the latter.
+   */
+  void grow(std::uint32_t n) {
+    if (n <= capacity_)
+      fail_capacity();
+    buffer b(n);
+    adopt(b);
+  }
+
+  /**
+   * @brief Builds an object in the first slot of new ones and, only then,
+   * moves the old slots there.
+   */
+  template <typename... Args>
+  pool_handle grow_emplace(Args&&... args) {
+    const std::uint32_t n = next_capacity();
+    if (n <= capacity_)
+      fail_capacity();
+    buffer b(n);
+    const std::uint32_t i = capacity_;
+    slot& s = *new ((void *) &b.slots[i]) slot(0, npos);
+    new ((void *) &s.obj) T(std::forward<Args>(args)...);
+    ++s.generation;
+    b.i_built = i;
+    adopt(b);
+    ++size_;
+    return pool_handle(i, s.generation);
+  }
+
+  /**
+   * @brief Moves slots to b's, links b's unused slots to the list of free ones
+   * and replaces the slots with b's.
+   */
+  void adopt(buffer& b) {
+    relocate(b, traits::is_trivially_relocatable<T>());
+    // New slots are pushed so that the lowest index is taken first.
+    const std::uint32_t first = b.i_built == npos ? capacity_ : capacity_ + 1;
+    for (std::uint32_t j = b.n_slots; j-- != first; ) {
+      new ((void *) &b.slots[j]) slot(0, free_);
+      free_ = j;
+    }
+    destroy_all();
+    deallocate(slots_, capacity_);
+    slots_ = b.slots;
+    capacity_ = b.n_slots;
+    b.slots = nullptr;
+  }
+
+  void relocate(buffer& b, std::true_type) noexcept {
+    if (capacity_ != 0)
+      std::memcpy(static_cast<void*>(b.slots),
+        static_cast<const void*>(slots_), capacity_ * sizeof(slot));
+    b.n_relocated = capacity_;
+    // Objects now live in b, hence, destroy_all() must skip the old ones.
+    for (std::uint32_t j = 0; j < capacity_; ++j)
+      slots_[j].generation = 0;
+  }
+
+  void relocate(buffer& b, std::false_type) {
+    for (std::uint32_t& i = b.n_relocated; i < capacity_; ++i) {
+      slot& s = slots_[i];
+      if (s.is_init()) {
+        slot& d = *new ((void *) &b.slots[i]) slot(s.generation - 1, 0);
+        new ((void *) &d.obj) T(std::move_if_noexcept(s.obj));
+        ++d.generation;
+      }
+      else
+        new ((void *) &b.slots[i]) slot(s.generation, s.next);
+    }
+  }
+
+}; // class delayed_init_pool
+
+template <typename T, typename C>
+constexpr std::uint32_t delayed_init_pool<T, C>::npos;
+
+/**
+ * @brief Swaps two pools.
+ *
+ * @param p1 1st pool.
+ * @param p2 2nd pool.
+ * @throw - Nothing.
+ */
+template <typename T, typename C>
+void swap(delayed_init_pool<T, C>& p1, delayed_init_pool<T, C>& p2) noexcept {
+  p1.swap(p2);
+}
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_POOL_H_
@@ -0,0 +1,303 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::serialize() and overload::serialized_view.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "delayed_init_serial.h"
+
+using overload::delayed_init;
+using overload::delayed_init_array;
+using overload::serialize;
+using overload::serialized_size;
+using overload::serialized_view;
+
+// Trivially copyable type (without padding, so that bytes can be compared).
+struct point {
+  long long x;
+  double    y;
+};
+
+// Large trivially copyable type (exceeds the writer's chunk).
+struct big {
+  char data[5000];
+};
+
+typedef std::vector<unsigned char> bytes;
+
+// Sink appending to a vector.
+struct vector_sink {
+  bytes& out;
+  void operator()(const void* data, std::size_t n) const {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), p, p + n);
+  }
+};
+
+// Whether the i-th slot is initialised in tests.
+static bool pattern(std::size_t i) {
+  return i % 3 == 0 || i == 64 || i == 130;
+}
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// make_points()
+//------------------------------------------------------------------------------
+
+std::vector<delayed_init<point>> make_points(std::size_t n) {
+  std::vector<delayed_init<point>> points(n);
+  for (std::size_t i = 0; i < n; ++i)
+    if (pattern(i))
+      points[i].init(point{static_cast<long long>(i), 0.5 * i});
+  return points;
+}
+
+//------------------------------------------------------------------------------
+// check_view()
+//------------------------------------------------------------------------------
+
+void check_view(const serialized_view<point>& view, std::size_t n) {
+  assert(view.valid());
+  assert(view.slots() == n);
+  std::size_t n_live = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    assert(view.is_init(i) == pattern(i));
+    if (pattern(i)) {
+      assert(view.get(i) == view.values() + n_live);
+      assert(view.get(i)->x == static_cast<long long>(i));
+      assert(view.get(i)->y == 0.5 * i);
+      ++n_live;
+    }
+    else
+      assert(view.get(i) == nullptr);
+  }
+  assert(view.size() == n_live);
+  std::size_t visited = 0;
+  view.for_each([&](std::size_t i, const point& p) {
+    assert(pattern(i) && p.x == static_cast<long long>(i));
+    ++visited;
+  });
+  assert(visited == n_live);
+}
+
+//------------------------------------------------------------------------------
+// test_round_trip()
+//------------------------------------------------------------------------------
+
+void test_round_trip(int line, std::size_t n) {
+  where(line, __func__);
+  const std::vector<delayed_init<point>> points = make_points(n);
+  bytes out;
+  serialize(points.data(), points.size(), vector_sink{out});
+  std::size_t n_live = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    n_live += pattern(i);
+  assert(out.size() == serialized_size<point>(n, n_live));
+  check_view(serialized_view<point>(out.data(), out.size()), n);
+}
+
+//------------------------------------------------------------------------------
+// test_array()
+//------------------------------------------------------------------------------
+
+void test_array(int line) {
+  where(line, __func__);
+  delayed_init_array<point, 200> a;
+  for (std::size_t i = 0; i < a.capacity(); ++i)
+    if (pattern(i))
+      a.init(i, point{static_cast<long long>(i), 0.5 * i});
+  bytes from_array;
+  serialize(a, vector_sink{from_array});
+  const std::vector<delayed_init<point>> points = make_points(200);
+  bytes from_range;
+  serialize(points.data(), points.size(), vector_sink{from_range});
+  assert(from_array == from_range);
+  check_view(serialized_view<point>(from_array.data(), from_array.size()),
+    200);
+}
+
+//------------------------------------------------------------------------------
+// test_empty()
+//------------------------------------------------------------------------------
+
+void test_empty(int line) {
+  where(line, __func__);
+  const std::vector<delayed_init<point>> points(1000);
+  bytes out;
+  serialize(points.data(), points.size(), vector_sink{out});
+  // One bit per slot (plus the directory and the header).
+  assert(out.size() == serialized_size<point>(1000, 0));
+  assert(out.size() < sizeof(overload::serial_header) + 1000 / 8 + 8 * 4);
+  const serialized_view<point> view(out.data(), out.size());
+  assert(view.valid() && view.slots() == 1000 && view.size() == 0);
+  view.for_each([](std::size_t, const point&) {
+    assert(false);
+  });
+  const serialized_view<point> none;
+  assert(!none.valid() && none.slots() == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_big()
+//------------------------------------------------------------------------------
+
+void test_big(int line) {
+  where(line, __func__);
+  std::vector<delayed_init<big>> objects(5);
+  big b;
+  for (std::size_t i = 0; i < sizeof(b.data); ++i)
+    b.data[i] = static_cast<char>(i);
+  objects[1].init(b);
+  objects[4].init(b);
+  bytes out;
+  serialize(objects.data(), objects.size(), vector_sink{out});
+  const serialized_view<big> view(out.data(), out.size());
+  assert(view.valid() && view.size() == 2);
+  assert(std::memcmp(view.get(4)->data, b.data, sizeof(b.data)) == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_invalid()
+//------------------------------------------------------------------------------
+
+void test_invalid(int line) {
+  where(line, __func__);
+  const std::vector<delayed_init<point>> points = make_points(300);
+  bytes out;
+  serialize(points.data(), points.size(), vector_sink{out});
+  assert((serialized_view<point>(out.data(), out.size()).valid()));
+
+  // Wrong type.
+  assert(!(serialized_view<int>(out.data(), out.size()).valid()));
+
+  // Truncated.
+  assert(!(serialized_view<point>(out.data(), out.size() - 1).valid()));
+  assert(!(serialized_view<point>(out.data(), 10).valid()));
+  assert(!(serialized_view<point>(nullptr, 0).valid()));
+
+  // Bad magic.
+  bytes bad(out);
+  bad[0] = 'X';
+  assert(!(serialized_view<point>(bad.data(), bad.size()).valid()));
+
+  // Bitmap disagreeing with the directory.
+  bad = out;
+  bad[sizeof(overload::serial_header)] ^= 2;
+  assert(!(serialized_view<point>(bad.data(), bad.size()).valid()));
+
+  // Bits set past the last slot.
+  bad = out;
+  bad[sizeof(overload::serial_header) + 4 * 8 + 7] |= 0x80;
+  assert(!(serialized_view<point>(bad.data(), bad.size()).valid()));
+}
+
+#if OVERLOAD_DELAYED_INIT_HAS_MMAP
+
+//------------------------------------------------------------------------------
+// test_mapped_file()
+//------------------------------------------------------------------------------
+
+void test_mapped_file(int line) {
+  where(line, __func__);
+  char path[] = "/tmp/delayed_init_serial_XXXXXX";
+  const int fd = ::mkstemp(path);
+  assert(fd >= 0);
+  std::FILE* file = ::fdopen(fd, "wb");
+  assert(file != nullptr);
+  const std::vector<delayed_init<point>> points = make_points(1000);
+  serialize(points.data(), points.size(), [file](const void* data,
+    std::size_t n) {
+    const std::size_t written = std::fwrite(data, 1, n, file);
+    assert(written == n);
+    (void) written;
+  });
+  std::fclose(file);
+  {
+    overload::mapped_file map(path);
+    assert(map.valid());
+    check_view(map.view<point>(), 1000);
+    overload::mapped_file moved(std::move(map));
+    assert(!map.valid() && moved.valid());
+    check_view(moved.view<point>(), 1000);
+
+    // Move-assignment unmaps the target's file and empties the source.
+    map = overload::mapped_file(path);
+    assert(map.valid());
+    moved = std::move(map);
+    assert(!map.valid() && moved.valid());
+    check_view(moved.view<point>(), 1000);
+  }
+  ::unlink(path);
+  assert(!overload::mapped_file(path).valid());
+}
+
+#endif // OVERLOAD_DELAYED_INIT_HAS_MMAP
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_round_trip(__LINE__, 0);
+  test_round_trip(__LINE__, 1);
+  test_round_trip(__LINE__, 64);
+  test_round_trip(__LINE__, 300);
+  test_round_trip(__LINE__, 10000);
+  test_array(__LINE__);
+  test_empty(__LINE__);
+  test_big(__LINE__);
+  test_invalid(__LINE__);
+#if OVERLOAD_DELAYED_INIT_HAS_MMAP
+  test_mapped_file(__LINE__);
+#endif
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
@@ -0,0 +1,643 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file delayed_init_serial.h
+  * @brief Compact binary format for arrays of delayed_init.
+  */
+
+#ifndef OVERLOAD_DELAYED_INIT_SERIAL_H_
+#define OVERLOAD_DELAYED_INIT_SERIAL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define OVERLOAD_DELAYED_INIT_HAS_MMAP 1
+#else
+#define OVERLOAD_DELAYED_INIT_HAS_MMAP 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "delayed_init.h"
+#include "delayed_init_array.h"
+
+/**
+ * The format of an array of n slots of which n_live hold an object of type T
+ * is, at offsets which are multiples of 8 (or of max(8, alignof(T)) for the
+ * values):
+ *
+ * 1. A serial_header.
+ * 2. The occupancy bitmap: (n + 63) / 64 words of 64 bits where bit i % 64 of
+ *    word i / 64 is set if, and only if, the i-th slot holds an object.
+ * 3. The rank directory: (n + 511) / 512 words of 64 bits where the j-th is
+ *    the number of objects in slots before the j-th block of 512 slots.
+ * 4. The n_live objects, densely packed in increasing order of index.
+ *
+ * Only trivially copyable types are supported and integers are written in the
+ * byte order of the writer. The reader rejects data that was produced with a
+ * different byte order, size or alignment of T. Uninitialised slots take one
+ * bit (plus 1/8 bit for the directory) and loading needs no parsing: the view
+ * reads the objects where they are (e.g. in a memory mapped file).
+ */
+
+namespace overload {
+
+/**
+ * @brief Header of the serialised form of an array of delayed_init.
+ */
+struct serial_header {
+
+  /**
+   * @brief Current version of the format.
+   */
+  static constexpr std::uint32_t current_version = 1;
+
+  /**
+   * @brief Byte order mark (as written by the producer).
+   */
+  static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+  char          magic[8];      // "OVLDINIT"
+  std::uint32_t version;       // current_version.
+  std::uint32_t byte_order;    // byte_order_mark.
+  std::uint32_t value_size;    // sizeof(T).
+  std::uint32_t value_align;   // alignof(T).
+  std::uint64_t n_slots;       // Number of slots.
+  std::uint64_t n_live;        // Number of objects.
+  std::uint64_t values_offset; // Offset of the first object.
+
+}; // struct serial_header
+
+namespace detail {
+
+/**
+ * @brief Magic number of the format.
+ */
+constexpr char serial_magic[8] = {'O', 'V', 'L', 'D', 'I', 'N', 'I', 'T'};
+
+/**
+ * @brief Number of words in a block of the rank directory.
+ */
+constexpr std::size_t serial_block_words = 8;
+
+/**
+ * @brief Number of set bits.
+ *
+ * @param w The word.
+ * @return The number of bits of w which are set.
+ */
+inline unsigned popcount(std::uint64_t w) noexcept {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_popcountll(w));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<unsigned>(__popcnt64(w));
+#else
+  unsigned n = 0;
+  for (; w != 0; w &= w - 1)
+    ++n;
+  return n;
+#endif
+}
+
+/**
+ * @brief Rounds n up to a multiple of a (a power of 2).
+ */
+constexpr std::uint64_t align_up(std::uint64_t n, std::uint64_t a) noexcept {
+  return (n + a - 1) & ~(a - 1);
+}
+
+/**
+ * @brief Layout of the serialised form of an array of n slots.
+ *
+ * @tparam T Type of the objects.
+ */
+template <typename T>
+struct serial_layout {
+
+  static constexpr std::uint64_t value_align = alignof(T) < 8 ? 8 :
+    alignof(T);
+
+  static constexpr std::uint64_t n_words(std::uint64_t n) noexcept {
+    return (n + 63) / 64;
+  }
+
+  static constexpr std::uint64_t n_blocks(std::uint64_t n) noexcept {
+    return (n_words(n) + serial_block_words - 1) / serial_block_words;
+  }
+
+  static constexpr std::uint64_t bitmap_offset() noexcept {
+    return align_up(sizeof(serial_header), 8);
+  }
+
+  static constexpr std::uint64_t directory_offset(std::uint64_t n) noexcept {
+    return bitmap_offset() + 8 * n_words(n);
+  }
+
+  static constexpr std::uint64_t values_offset(std::uint64_t n) noexcept {
+    return align_up(directory_offset(n) + 8 * n_blocks(n), value_align);
+  }
+
+  static constexpr std::uint64_t size(std::uint64_t n, std::uint64_t n_live)
+    noexcept {
+    return values_offset(n) + n_live * sizeof(T);
+  }
+};
+
+/**
+ * @brief Writes the serialised form of n slots.
+ *
+ * @param n Number of slots.
+ * @param n_live Number of objects.
+ * @param word Function object such that word(w) returns the w-th word of the
+ * occupancy bitmap.
+ * @param obj Function object such that obj(i) returns the i-th object (if it
+ * is initialised).
+ * @param sink Function object such that sink(bytes, k) writes k bytes.
+ */
+template <typename T, typename W, typename O, typename Sink>
+void serialize(std::uint64_t n, std::uint64_t n_live, W&& word, O&& obj,
+  Sink&& sink) {
+
+  static_assert(std::is_trivially_copyable<T>::value, "serialisation "
+    "requires a trivially copyable type");
+
+  typedef serial_layout<T> layout;
+
+  static const unsigned char zeros[layout::value_align] = {};
+
+  serial_header header;
+  std::memcpy(header.magic, serial_magic, sizeof(header.magic));
+  header.version       = serial_header::current_version;
+  header.byte_order    = serial_header::byte_order_mark;
+  header.value_size    = static_cast<std::uint32_t>(sizeof(T));
+  header.value_align   = static_cast<std::uint32_t>(alignof(T));
+  header.n_slots       = n;
+  header.n_live        = n_live;
+  header.values_offset = layout::values_offset(n);
+  sink(&header, sizeof(header));
+  sink(zeros, layout::bitmap_offset() - sizeof(header));
+
+  const std::uint64_t n_words = layout::n_words(n);
+  for (std::uint64_t w = 0; w < n_words; ++w) {
+    const std::uint64_t bits = word(w);
+    sink(&bits, sizeof(bits));
+  }
+
+  std::uint64_t rank = 0;
+  for (std::uint64_t w = 0; w < n_words; ++w) {
+    if (w % serial_block_words == 0)
+      sink(&rank, sizeof(rank));
+    rank += popcount(word(w));
+  }
+  sink(zeros, layout::values_offset(n) - layout::directory_offset(n) -
+    8 * layout::n_blocks(n));
+
+  // Objects are written in chunks to limit the number of calls to sink.
+  unsigned char chunk[4096];
+  std::size_t   used = 0;
+  for (std::uint64_t w = 0; w < n_words; ++w)
+    for (std::uint64_t bits = word(w); bits != 0; bits &= bits - 1) {
+      if (used + sizeof(T) > sizeof(chunk)) {
+        sink(chunk, used);
+        used = 0;
+      }
+      if (sizeof(T) > sizeof(chunk))
+        sink(&obj(w * 64 + ctz(bits)), sizeof(T));
+      else {
+        std::memcpy(chunk + used, &obj(w * 64 + ctz(bits)), sizeof(T));
+        used += sizeof(T);
+      }
+    }
+  sink(chunk, used);
+}
+
+} // namespace detail
+
+/**
+ * @brief Size of the serialised form of an array.
+ *
+ * @tparam T Type of the objects.
+ * @param n_slots Number of slots.
+ * @param n_live Number of objects.
+ * @return The number of bytes written by serialize().
+ */
+template <typename T>
+constexpr std::uint64_t serialized_size(std::uint64_t n_slots,
+  std::uint64_t n_live) noexcept {
+  return detail::serial_layout<T>::size(n_slots, n_live);
+}
+
+/**
+ * @brief Serialise a range of delayed_init objects.
+ *
+ * Writes the serialised form of [first, first + n) by calls sink(bytes, k)
+ * each of which must write the k bytes starting at bytes (e.g., by fwrite()
+ * or std::ostream::write()). Objects are read twice: once to count them and
+ * once to write them.
+ *
+ * @param first Pointer to the first object.
+ * @param n Number of objects.
+ * @param sink Function object.
+ * @throw - Whatever sink throws.
+ */
+template <typename T, typename S, typename C, typename I, typename Sink>
+void serialize(const delayed_init<T, S, C, I>* first, std::size_t n,
+  Sink&& sink) {
+  typedef typename std::remove_const<T>::type value_type;
+  auto word = [first, n](std::uint64_t w) {
+    std::uint64_t bits = 0;
+    const std::size_t end = n - w * 64 < 64 ? n - w * 64 : 64;
+    for (std::size_t b = 0; b < end; ++b)
+      bits |= std::uint64_t(static_cast<bool>(first[w * 64 + b])) << b;
+    return bits;
+  };
+  std::uint64_t n_live = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    n_live += static_cast<bool>(first[i]);
+  detail::serialize<value_type>(n, n_live, word,
+    [first](std::uint64_t i) -> const T& { return first[i].value_unchecked(); },
+    std::forward<Sink>(sink));
+}
+
+/**
+ * @brief Serialise a delayed_init_array.
+ *
+ * As above but the bitmap of the array is copied as is.
+ *
+ * @param a The array.
+ * @param sink Function object.
+ * @throw - Whatever sink throws.
+ */
+template <typename T, std::size_t N, typename C, typename Sink>
+void serialize(const delayed_init_array<T, N, C>& a, Sink&& sink) {
+  typedef typename std::remove_const<T>::type value_type;
+  detail::serialize<value_type>(N, a.size(),
+    [&a](std::uint64_t w) { return a.words()[w]; },
+    [&a](std::uint64_t i) -> const T& { return a.value_unchecked(i); },
+    std::forward<Sink>(sink));
+}
+
+/**
+ * @brief Read-only, zero-copy view of a serialised array.
+ *
+ * No object is constructed or copied: the bitmap and the objects are read
+ * where they are (typically, a memory mapped file, see mapped_file). The data
+ * is validated on construction and invalid data yields an invalid view (see
+ * valid()) of no slot.
+ *
+ * The data must outlive the view and be aligned to max(8, alignof(T)), the
+ * alignment of the 64-bit words and of the objects. (This is the case for
+ * mapped_file and, unless T is over-aligned, for memory obtained by operator
+ * new.) Otherwise, the view is invalid.
+ *
+ * @tparam T Type of the objects (trivially copyable).
+ */
+template <typename T>
+class serialized_view {
+
+  static_assert(std::is_trivially_copyable<T>::value, "serialisation "
+    "requires a trivially copyable type");
+
+  typedef detail::serial_layout<T> layout;
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post valid() == false && slots() == 0.
+   * @throw - Nothing.
+   */
+  serialized_view() noexcept : n_slots_(0), n_live_(0), words_(nullptr),
+    directory_(nullptr), values_(nullptr) {
+  }
+
+  /**
+   * @brief Constructor.
+   *
+   * @param data Pointer to the serialised form.
+   * @param size Number of bytes available at data.
+   * @throw - Nothing.
+   */
+  serialized_view(const void* data, std::size_t size) noexcept :
+    serialized_view() {
+
+    // Sizes are checked in an order that prevents overflows.
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    serial_header header;
+    if (data == nullptr || size < sizeof(header) ||
+      reinterpret_cast<std::uintptr_t>(data) % layout::value_align != 0)
+      return;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    const std::uint64_t n = header.n_slots;
+    if (std::memcmp(header.magic, detail::serial_magic, sizeof(header.magic))
+      != 0 || header.version != serial_header::current_version ||
+      header.byte_order != serial_header::byte_order_mark ||
+      header.value_size != sizeof(T) || header.value_align != alignof(T) ||
+      n / 8 > size || header.n_live > n ||
+      header.n_live > size / sizeof(T) ||
+      header.values_offset != layout::values_offset(n) ||
+      layout::size(n, header.n_live) > size)
+      return;
+
+    const std::uint64_t* words = reinterpret_cast<const std::uint64_t*>(
+      bytes + layout::bitmap_offset());
+    const std::uint64_t* directory = reinterpret_cast<const std::uint64_t*>(
+      bytes + layout::directory_offset(n));
+
+    // The directory and the bitmap must agree. (Otherwise, get() could read
+    // out of bounds.)
+    std::uint64_t rank = 0;
+    for (std::uint64_t w = 0; w < layout::n_words(n); ++w) {
+      if (w % detail::serial_block_words == 0 &&
+        directory[w / detail::serial_block_words] != rank)
+        return;
+      rank += detail::popcount(words[w]);
+    }
+    if (rank != header.n_live || (n % 64 != 0 &&
+      (words[n / 64] >> (n % 64)) != 0))
+      return;
+
+    n_slots_   = n;
+    n_live_    = header.n_live;
+    words_     = words;
+    directory_ = directory;
+    values_    = reinterpret_cast<const T*>(bytes + header.values_offset);
+  }
+
+  /**
+   * @brief Checks whether the data is valid.
+   *
+   * @return true if the data given on construction is the valid serialised
+   * form of an array of T. Otherwise, false.
+   * @throw - Nothing.
+   */
+  bool valid() const noexcept {
+    return words_ != nullptr;
+  }
+
+  /**
+   * @brief Number of slots.
+   */
+  std::size_t slots() const noexcept {
+    return static_cast<std::size_t>(n_slots_);
+  }
+
+  /**
+   * @brief Number of objects.
+   */
+  std::size_t size() const noexcept {
+    return static_cast<std::size_t>(n_live_);
+  }
+
+  /**
+   * @brief Checks whether the i-th slot holds an object.
+   *
+   * @pre i < slots().
+   * @param i Index of the slot.
+   * @throw - Nothing.
+   */
+  bool is_init(std::size_t i) const noexcept {
+    return (words_[i / 64] >> (i % 64) & 1) != 0;
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * The position of the object is found in constant time from the rank
+   * directory and the bitmap.
+   *
+   * @pre i < slots().
+   * @param i Index of the slot.
+   * @return A pointer to the i-th object if is_init(i) == true. Otherwise,
+   * nullptr.
+   * @throw - Nothing.
+   */
+  const T* get(std::size_t i) const noexcept {
+    if (!is_init(i))
+      return nullptr;
+    const std::size_t w     = i / 64;
+    const std::size_t block = w / detail::serial_block_words;
+    std::uint64_t     rank  = directory_[block];
+    for (std::size_t v = block * detail::serial_block_words; v < w; ++v)
+      rank += detail::popcount(words_[v]);
+    rank += detail::popcount(words_[w] & ((std::uint64_t(1) << (i % 64)) - 1));
+    return values_ + rank;
+  }
+
+  /**
+   * @brief Calls f(i, obj) for each object obj of index i.
+   *
+   * Objects are visited in increasing order of index (which is their order in
+   * the data) and uninitialised slots are skipped by scanning the bitmap.
+   *
+   * @param f The function object.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each(F&& f) const {
+    const T* obj = values_;
+    for (std::uint64_t w = 0; w < layout::n_words(n_slots_); ++w)
+      for (std::uint64_t bits = words_[w]; bits != 0; bits &= bits - 1)
+        f(static_cast<std::size_t>(w * 64 + detail::ctz(bits)), *obj++);
+  }
+
+  /**
+   * @brief Bitmap of initialised slots.
+   *
+   * @return A pointer to the first of (slots() + 63) / 64 words.
+   * @throw - Nothing.
+   */
+  const std::uint64_t* words() const noexcept {
+    return words_;
+  }
+
+  /**
+   * @brief The objects (densely packed).
+   *
+   * @return A pointer to the first of size() objects.
+   * @throw - Nothing.
+   */
+  const T* values() const noexcept {
+    return values_;
+  }
+
+private:
+
+  std::uint64_t        n_slots_;
+  std::uint64_t        n_live_;
+  const std::uint64_t* words_;
+  const std::uint64_t* directory_;
+  const T*             values_;
+
+}; // class serialized_view
+
+#if OVERLOAD_DELAYED_INIT_HAS_MMAP
+
+/**
+ * @brief Read-only memory mapping of a file.
+ *
+ * The mapping is page aligned and, hence, suitable for serialized_view.
+ */
+class mapped_file {
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post valid() == false.
+   * @throw - Nothing.
+   */
+  mapped_file() noexcept : data_(nullptr), size_(0) {
+  }
+
+  /**
+   * @brief Constructor.
+   *
+   * Maps the file read-only. On failure, the object is invalid.
+   *
+   * @param path Path of the file.
+   * @throw - Nothing.
+   */
+  explicit mapped_file(const char* path) noexcept : mapped_file() {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+        PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = data;
+        size_ = static_cast<std::size_t>(st.st_size);
+      }
+    }
+    ::close(fd);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  /**
+   * @brief Move-constructor.
+   *
+   * @post other.valid() == false.
+   * @throw - Nothing.
+   */
+  mapped_file(mapped_file&& other) noexcept : data_(other.data_),
+    size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  /**
+   * @brief Move-assignment.
+   *
+   * Unmaps the file previously mapped by *this (if any).
+   *
+   * @post other.valid() == false (unless &other == this).
+   * @throw - Nothing.
+   */
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      if (data_)
+        ::munmap(data_, size_);
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Destructor.
+   *
+   * Unmaps the file.
+   */
+  ~mapped_file() noexcept {
+    if (data_)
+      ::munmap(data_, size_);
+  }
+
+  /**
+   * @brief Checks whether the file is mapped.
+   */
+  bool valid() const noexcept {
+    return data_ != nullptr;
+  }
+
+  /**
+   * @brief Pointer to the first mapped byte.
+   */
+  const void* data() const noexcept {
+    return data_;
+  }
+
+  /**
+   * @brief Number of mapped bytes.
+   */
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * @brief View of the mapped data as a serialised array of T.
+   */
+  template <typename T>
+  serialized_view<T> view() const noexcept {
+    return serialized_view<T>(data_, size_);
+  }
+
+private:
+
+  void*       data_;
+  std::size_t size_;
+
+}; // class mapped_file
+
+#endif // OVERLOAD_DELAYED_INIT_HAS_MMAP
+
+} // namespace overload
+
+#endif // OVERLOAD_DELAYED_INIT_SERIAL_H_
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::lazy.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "lazy.h"
+
+// Number of calls to factories.
+int calls = 0;
+
+// Factory of std::string.
+struct make_string {
+  std::string operator()() const {
+    ++calls;
+    return "lazy";
+  }
+};
+
+// Factory of std::string that throws on its first call.
+struct make_string_throw {
+  std::string operator()() const {
+    if (calls++ == 0)
+      throw std::runtime_error("first call");
+    return "lazy";
+  }
+};
+
+// Function factory.
+std::string string_function() {
+  ++calls;
+  return "function";
+}
+
+using overload::lazy;
+using overload::delayed_init;
+
+static_assert(sizeof(lazy<std::string, make_string>) ==
+  sizeof(delayed_init<std::string>), "lazy<T, F> is larger than "
+  "delayed_init<T> for empty F");
+
+// A lazy object needs a factory to be built from.
+static_assert(std::is_default_constructible<lazy<std::string, make_string>>::
+  value, "lazy<std::string, make_string> is not default constructible");
+static_assert(!std::is_default_constructible<lazy<std::string>>::value,
+  "lazy<std::string> (null function pointer factory) is default constructible");
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_first_access()
+//------------------------------------------------------------------------------
+
+template <typename L>
+void test_first_access(int line, L&& l, const std::string& expected) {
+  where(line, __func__);
+  calls = 0;
+  assert(!l);
+  assert(l.get() == nullptr);
+  assert(calls == 0);
+  assert(*l == expected);
+  assert(l);
+  assert(l->size() == expected.size());
+  assert(*l.get() == expected);
+  assert(calls == 1);
+}
+
+//------------------------------------------------------------------------------
+// test_factory_throw()
+//------------------------------------------------------------------------------
+
+void test_factory_throw(int line) {
+  where(line, __func__);
+  calls = 0;
+  lazy<std::string, make_string_throw> l;
+  try {
+    *l;
+    assert(false);
+  }
+  catch (std::runtime_error&) {
+  }
+  assert(!l);
+  assert(*l == "lazy");
+  assert(calls == 2);
+}
+
+//------------------------------------------------------------------------------
+// test_lambda()
+//------------------------------------------------------------------------------
+
+void test_lambda(int line) {
+  where(line, __func__);
+  const int n = 3;
+  auto f = [n]{ return std::string(n, 'x'); };
+  const lazy<std::string, decltype(f)> l(f);
+  assert(!l);
+  assert(*l == "xxx");
+  assert(l);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_first_access(__LINE__, lazy<std::string, make_string>(), "lazy");
+  test_first_access(__LINE__, lazy<const std::string, make_string>(), "lazy");
+  test_first_access(__LINE__, lazy<std::string>(&string_function), "function");
+  test_factory_throw(__LINE__);
+  test_lambda(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
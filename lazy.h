@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+
+ /**
+  * @file lazy.h
+  * @brief Definition of class lazy.
+  */
+
+#ifndef OVERLOAD_LAZY_H_
+#define OVERLOAD_LAZY_H_
+
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+namespace detail {
+
+/**
+ * @brief Holds a factory of type F taking advantage of the empty base
+ * optimisation.
+ *
+ * @tparam F Type of the factory.
+ */
+template <typename F, bool =
+  std::is_empty<F>::value &&
+#if __cplusplus >= 201402L
+  !std::is_final<F>::value
+#else
+  !__is_final(F)
+#endif
+  >
+class factory_holder : private F {
+public:
+  factory_holder() = default;
+  explicit factory_holder(F&& f) : F(std::move(f)) {
+  }
+  explicit factory_holder(const F& f) : F(f) {
+  }
+  const F& factory() const noexcept {
+    return *this;
+  }
+};
+
+template <typename F>
+class factory_holder<F, false> {
+  F f_;
+public:
+  factory_holder() : f_() {
+  }
+  explicit factory_holder(F&& f) : f_(std::move(f)) {
+  }
+  explicit factory_holder(const F& f) : f_(f) {
+  }
+  const F& factory() const noexcept {
+    return f_;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Object built on first access.
+ *
+ * Class lazy<T, F> holds an object of type T and a factory of type F. The
+ * object is initialised with the result of the factory on the first call to
+ * operator*() or operator->(). If the factory throws, then the object remains
+ * uninitialised and the next access calls the factory again.
+ *
+ * The inner object is kept in a delayed_init<T> and is built directly from the
+ * result of the factory (see delayed_init<T>::init_with()). The factory is an
+ * empty base whenever possible. Hence, for a captureless lambda (or any other
+ * empty class) F, sizeof(lazy<T, F>) == sizeof(delayed_init<T>).
+ *
+ * Initialisation happens even through const member functions but is not
+ * thread-safe (see concurrent_delayed_init<T>::init_once()).
+ *
+ * The type T must not be a reference type and F must be callable as
+ * const F& with no arguments, returning something convertible to T.
+ */
+template <typename T, typename F = T (*)()>
+class lazy : private detail::factory_holder<F> {
+
+  typedef detail::factory_holder<F> base;
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * Only provided when F is a default constructible class (e.g. a captureless
+   * lambda in C++20). In particular, not for the default F = T (*)() whose
+   * value-initialised factory would be a null pointer.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Whatever F::F() throws.
+   */
+  template <typename G = F, typename = typename std::enable_if<
+    std::is_class<G>::value && std::is_default_constructible<G>::value>::type>
+  lazy() noexcept(std::is_nothrow_default_constructible<G>::value) {
+  }
+
+  /**
+   * @brief Constructor from factory.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @param f The factory.
+   * @throw - Whatever F::F(F&&) throws.
+   */
+  explicit lazy(F f) : base(std::move(f)) {
+  }
+
+  /**
+   * @brief Indirection.
+   *
+   * Initialises the inner object if not initialised yet.
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @return The inner object.
+   * @throw - Whatever the factory and T's constructor throw.
+   */
+  T& operator*() {
+    return force();
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * Initialises the inner object if not initialised yet.
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @return The inner object.
+   * @throw - Whatever the factory and T's constructor throw.
+   */
+  const T& operator*() const {
+    return force();
+  }
+
+  /**
+   * @brief Deference.
+   *
+   * Initialises the inner object if not initialised yet.
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @return A pointer to the inner object.
+   * @throw - Whatever the factory and T's constructor throw.
+   */
+  T* operator->() {
+    return &force();
+  }
+
+  /**
+   * @brief Deference (const).
+   *
+   * Initialises the inner object if not initialised yet.
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @return A pointer to the inner object.
+   * @throw - Whatever the factory and T's constructor throw.
+   */
+  const T* operator->() const {
+    return &force();
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * Doesn't initialise the inner object.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  T* get() noexcept {
+    return obj_.get();
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * Doesn't initialise the inner object.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  const T* get() const noexcept {
+    return obj_.get();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the inner object was not initialised. Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return static_cast<bool>(obj_);
+  }
+
+private:
+
+  mutable delayed_init<T> obj_;
+
+  T& force() const {
+    if (!obj_)
+      return obj_.init_with(this->factory());
+    return obj_.value_unchecked();
+  }
+
+}; // class lazy
+
+} // namespace overload
+
+#endif // OVERLOAD_LAZY_H_
@@ -0,0 +1,212 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::per_thread_delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "per_thread_delayed_init.h"
+
+using overload::per_thread_delayed_init;
+
+// Number of workers.
+constexpr std::size_t n_workers = 4;
+
+// Statistics accumulator which can be read while being updated.
+struct stats {
+
+  static std::atomic<int> n_built;
+
+  explicit stats(long first = 0) noexcept : count(first) {
+    ++n_built;
+  }
+
+  ~stats() noexcept {
+    --n_built;
+  }
+
+  std::atomic<long> count;
+};
+
+std::atomic<int> stats::n_built(0);
+
+typedef per_thread_delayed_init<stats, n_workers> table;
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_layout()
+//------------------------------------------------------------------------------
+
+void test_layout(int line) {
+  where(line, __func__);
+  static_assert(alignof(table) == OVERLOAD_DELAYED_INIT_CACHE_LINE,
+    "slots are not aligned to cache lines");
+  static_assert(sizeof(per_thread_delayed_init<char, 3>) ==
+    3 * OVERLOAD_DELAYED_INIT_CACHE_LINE, "slots are not padded");
+  per_thread_delayed_init<char, 3> t;
+  const auto a0 = reinterpret_cast<std::uintptr_t>(&t.get_or_init(0, 'a'));
+  const auto a1 = reinterpret_cast<std::uintptr_t>(&t.get_or_init(1, 'b'));
+  assert(a1 - a0 == OVERLOAD_DELAYED_INIT_CACHE_LINE);
+}
+
+//------------------------------------------------------------------------------
+// test_lazy()
+//------------------------------------------------------------------------------
+
+void test_lazy(int line) {
+  where(line, __func__);
+  {
+    table t;
+    assert(table::capacity() == n_workers);
+    assert(t.size() == 0 && stats::n_built == 0);
+    t.for_each_initialised([](std::size_t, const stats&) {
+      assert(false);
+    });
+    assert(!t.is_init(2) && t.get(2) == nullptr);
+    try {
+      t.value(2);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+    }
+
+    stats& s = t.get_or_init(2, 5L);
+    assert(t.is_init(2) && t.get(2) == &s && &t.value(2) == &s);
+    assert(&t.get_or_init(2, 7L) == &s && s.count == 5);
+    assert(&t.get_or_init_with(2, [] { assert(false); return 0L; }) == &s);
+    assert(stats::n_built == 1 && t.size() == 1);
+
+    t.get_or_init_with(0, [] { return 1L; });
+    std::vector<std::size_t> visited;
+    t.for_each_initialised([&](std::size_t i, const stats&) {
+      visited.push_back(i);
+    });
+    assert((visited == std::vector<std::size_t>{0, 2}));
+
+    t.destroy(2);
+    t.destroy(3);
+    assert(!t.is_init(2) && t.size() == 1 && stats::n_built == 1);
+  }
+  assert(stats::n_built == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_throwing_init()
+//------------------------------------------------------------------------------
+
+void test_throwing_init(int line) {
+  where(line, __func__);
+  table t;
+  try {
+    t.get_or_init_with(1, []() -> long { throw 0; });
+    assert(false);
+  }
+  catch (int) {
+  }
+  assert(!t.is_init(1) && t.size() == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_threads()
+//------------------------------------------------------------------------------
+
+void test_threads(int line) {
+  where(line, __func__);
+  constexpr long n_increments = 100000;
+  table t;
+  std::atomic<bool> done(false);
+
+  // Collector aggregating while workers run.
+  std::thread collector([&] {
+    long last = 0;
+    while (!done.load()) {
+      long total = 0;
+      t.for_each_initialised([&](std::size_t, const stats& s) {
+        total += s.count.load(std::memory_order_relaxed);
+      });
+      assert(total >= last && total <= long(n_workers) * n_increments);
+      last = total;
+    }
+  });
+
+  std::vector<std::thread> workers;
+  for (std::size_t w = 0; w < n_workers; ++w)
+    workers.emplace_back([&t, w] {
+      for (long i = 0; i < n_increments; ++i) {
+        std::atomic<long>& count = t.get_or_init(w).count;
+        count.store(count.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+      }
+    });
+  for (auto& worker : workers)
+    worker.join();
+  done = true;
+  collector.join();
+
+  long total = 0;
+  t.for_each_initialised([&](std::size_t, const stats& s) {
+    total += s.count;
+  });
+  assert(t.size() == n_workers && total == long(n_workers) * n_increments);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_layout(__LINE__);
+  test_lazy(__LINE__);
+  test_throwing_init(__LINE__);
+  test_threads(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
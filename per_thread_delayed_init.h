@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file per_thread_delayed_init.h
+  * @brief Definition of class per_thread_delayed_init.
+  */
+
+#ifndef OVERLOAD_PER_THREAD_DELAYED_INIT_H_
+#define OVERLOAD_PER_THREAD_DELAYED_INIT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+namespace detail {
+
+/**
+ * @brief Slot of per_thread_delayed_init padded to a cache line.
+ *
+ * is_init and raw are only accessed by the owner. published is set (with
+ * release semantics) once the object is initialised to let other threads see
+ * it.
+ */
+template <typename T>
+struct alignas(OVERLOAD_DELAYED_INIT_CACHE_LINE) per_thread_slot {
+
+  per_thread_slot() noexcept : is_init(false), published(false), raw() {
+  }
+
+  per_thread_slot(const per_thread_slot&) = delete;
+
+  per_thread_slot& operator=(const per_thread_slot&) = delete;
+
+  ~per_thread_slot() noexcept {
+    if (is_init)
+      (&raw.obj_)->~T();
+  }
+
+  bool              is_init;
+  std::atomic<bool> published;
+  raw_storage<T>    raw;
+
+}; // struct per_thread_slot
+
+} // namespace detail
+
+/**
+ * @brief N lazily initialised objects of type T, one per worker.
+ *
+ * Class per_thread_delayed_init<T, N> holds N slots indexed by worker id and
+ * each of them might hold an object of type T which is initialised on first
+ * touch (see get_or_init()). Each slot is padded to a cache line (see
+ * OVERLOAD_DELAYED_INIT_CACHE_LINE) so that workers never share one (no false
+ * sharing). Contrarily to thread_local objects, there's no TLS guard and all
+ * objects can be enumerated (see for_each_initialised()).
+ *
+ * The i-th slot is owned by the worker of id i: at any time at most one
+ * thread calls the owner's members (get_or_init(), get(), value(), is_init()
+ * and destroy()) for a given i. These take no lock and, except for the first
+ * initialisation, no atomic operation. Other threads (e.g. a collector) might
+ * call for_each_initialised() and size() concurrently with owners.
+ *
+ * Slots are over-aligned. Therefore, before C++17, objects of this class must
+ * not be allocated by new. Indices are never checked.
+ *
+ * The type T must not be a reference type.
+ */
+template <typename T, std::size_t N,
+  typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class per_thread_delayed_init {
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "per_thread_delayed_init for reference type");
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post size() == 0.
+   * @throw - Nothing.
+   */
+  per_thread_delayed_init() = default;
+
+  per_thread_delayed_init(const per_thread_delayed_init&) = delete;
+
+  per_thread_delayed_init& operator=(const per_thread_delayed_init&) = delete;
+
+  /**
+   * @brief Number of slots.
+   */
+  static constexpr std::size_t capacity() noexcept {
+    return N;
+  }
+
+  /**
+   * @brief Number of initialised objects.
+   *
+   * Might be called concurrently with owners (in which case the result might
+   * be outdated as soon as it's returned).
+   *
+   * @throw - Nothing.
+   */
+  std::size_t size() const noexcept {
+    std::size_t n = 0;
+    for (const auto& slot : slots_)
+      n += slot.published.load(std::memory_order_acquire);
+    return n;
+  }
+
+  /**
+   * @brief Checks whether the worker's object is initialised (owner only).
+   *
+   * @pre worker < N.
+   * @param worker Id of the worker.
+   * @throw - Nothing.
+   */
+  bool is_init(std::size_t worker) const noexcept {
+    return slots_[worker].is_init;
+  }
+
+  /**
+   * @brief Getter (owner only).
+   *
+   * @pre worker < N.
+   * @param worker Id of the worker.
+   * @return A pointer to the worker's object if is_init(worker) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  T* get(std::size_t worker) noexcept {
+    auto& slot = slots_[worker];
+    return slot.is_init ? &slot.raw.obj_ : nullptr;
+  }
+
+  /**
+   * @brief Indirection (owner only).
+   *
+   * @pre worker < N && is_init(worker) == true.
+   * @param worker Id of the worker.
+   * @return *get(worker).
+   * @throw std::logic_error If is_init(worker) == false and Check is
+   * check::exception.
+   */
+  T& value(std::size_t worker) noexcept(Check::is_nothrow) {
+    auto& slot = slots_[worker];
+    if (!slot.is_init)
+      Check::fail("attempt to use uninitialised object");
+    return slot.raw.obj_;
+  }
+
+  /**
+   * @brief The worker's object, initialised on first call (owner only).
+   *
+   * If is_init(worker) == false, then the object is built by forwarding args
+   * to T's constructor. Otherwise, args are ignored.
+   *
+   * @pre worker < N.
+   * @post is_init(worker) == true.
+   * @param worker Id of the worker.
+   * @param args Initialisation arguments.
+   * @return *get(worker).
+   * @throw - Whatever T::T(Args&&...) throws. In this case, the slot remains
+   * uninitialised.
+   */
+  template <typename... Args>
+  T& get_or_init(std::size_t worker, Args&&... args) {
+    auto& slot = slots_[worker];
+    if (!slot.is_init) {
+      new ((void *) &slot.raw.obj_) T(std::forward<Args>(args)...);
+      publish(slot);
+    }
+    return slot.raw.obj_;
+  }
+
+  /**
+   * @brief The worker's object, initialised on first call from the result of
+   * a factory (owner only).
+   *
+   * As get_or_init() but the object is built from f() which is called only
+   * if is_init(worker) == false.
+   */
+  template <typename F>
+  T& get_or_init_with(std::size_t worker, F&& f) {
+    auto& slot = slots_[worker];
+    if (!slot.is_init) {
+      new ((void *) &slot.raw.obj_) T(std::forward<F>(f)());
+      publish(slot);
+    }
+    return slot.raw.obj_;
+  }
+
+  /**
+   * @brief Destroy the worker's object (if initialised).
+   *
+   * Must not be called concurrently with for_each_initialised().
+   *
+   * @pre worker < N.
+   * @post is_init(worker) == false.
+   * @param worker Id of the worker.
+   * @throw - Nothing.
+   */
+  void destroy(std::size_t worker) noexcept {
+    auto& slot = slots_[worker];
+    if (slot.is_init) {
+      slot.published.store(false, std::memory_order_relaxed);
+      slot.is_init = false;
+      (&slot.raw.obj_)->~T();
+    }
+  }
+
+  /**
+   * @brief Calls f(worker, obj) for each initialised object obj.
+   *
+   * Objects are visited in increasing order of worker id. This might be
+   * called concurrently with owners (e.g. for low-frequency aggregation by a
+   * collector) and objects whose initialisation is not yet visible are
+   * skipped. In this case, owners might modify obj while f reads it and T
+   * must support that (e.g. by having atomic members).
+   *
+   * @param f The function object.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  void for_each_initialised(F&& f) const {
+    for (std::size_t i = 0; i < N; ++i)
+      if (slots_[i].published.load(std::memory_order_acquire))
+        f(i, static_cast<const T&>(slots_[i].raw.obj_));
+  }
+
+private:
+
+  static void publish(detail::per_thread_slot<T>& slot) noexcept {
+    slot.is_init = true;
+    slot.published.store(true, std::memory_order_release);
+  }
+
+  detail::per_thread_slot<T> slots_[N];
+
+}; // class per_thread_delayed_init
+
+} // namespace overload
+
+#endif // OVERLOAD_PER_THREAD_DELAYED_INIT_H_
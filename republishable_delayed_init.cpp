@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::seqlock_delayed_init and
+  * overload::double_buffered_delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "republishable_delayed_init.h"
+
+using overload::delayed_init;
+using overload::double_buffered_delayed_init;
+using overload::seqlock_delayed_init;
+
+// Number of readers.
+constexpr int n_readers = 3;
+
+// Market data snapshot whose fields are derived from seq (to detect tears).
+struct quote {
+
+  quote(long s) noexcept : seq(s), bid(s * 0.5), ask(s * 0.5 + 1.0),
+    size(3 * s) {
+  }
+
+  bool is_consistent() const noexcept {
+    return bid == seq * 0.5 && ask == bid + 1.0 && size == 3 * seq;
+  }
+
+  long   seq;
+  double bid;
+  double ask;
+  long   size;
+};
+
+// Counts live objects.
+struct book {
+
+  static std::atomic<int> live;
+
+  explicit book(int version) : levels(16, version) {
+    ++live;
+  }
+
+  book(const book& other) : levels(other.levels) {
+    ++live;
+  }
+
+  ~book() noexcept {
+    --live;
+  }
+
+  bool is_consistent() const noexcept {
+    for (int level : levels)
+      if (level != levels[0])
+        return false;
+    return true;
+  }
+
+  std::vector<int> levels;
+};
+
+std::atomic<int> book::live(0);
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_seqlock()
+//------------------------------------------------------------------------------
+
+void test_seqlock(int line) {
+  where(line, __func__);
+  seqlock_delayed_init<quote> q;
+  assert(!q && q.version() == 0);
+  assert(!q.load());
+
+  q.init(1);
+  assert(q && q.version() == 1);
+  const delayed_init<quote> d = q.load();
+  assert(d && d->seq == 1 && d->is_consistent());
+  try {
+    q.init(2);
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+
+  q.emplace(3);
+  assert(q.load()->seq == 3 && q.version() == 2);
+  q.destroy();
+  assert(!q && !q.load() && q.version() == 3);
+  q.init(4);
+  assert(q.load()->seq == 4);
+}
+
+//------------------------------------------------------------------------------
+// test_seqlock_threads()
+//------------------------------------------------------------------------------
+
+void test_seqlock_threads(int line) {
+  where(line, __func__);
+  seqlock_delayed_init<quote> q;
+  std::atomic<bool> done(false);
+  std::atomic<long> n_torn(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < n_readers; ++i)
+    readers.emplace_back([&] {
+      long last = 0;
+      while (!done) {
+        const delayed_init<quote> d = q.load();
+        if (!d)
+          continue;
+        if (!d->is_consistent() || d->seq < last)
+          ++n_torn;
+        last = d->seq;
+      }
+    });
+  for (long s = 1; s <= 100000; ++s)
+    q.emplace(s);
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+  assert(n_torn == 0);
+  assert(q.load()->seq == 100000);
+}
+
+//------------------------------------------------------------------------------
+// test_double_buffered()
+//------------------------------------------------------------------------------
+
+void test_double_buffered(int line) {
+  where(line, __func__);
+  {
+    double_buffered_delayed_init<book> b;
+    assert(!b);
+    assert(!b.read([](const book&) { assert(false); }));
+
+    b.init(1);
+    int level = 0;
+    assert(b && b.read([&](const book& x) { level = x.levels[0]; }));
+    assert(level == 1);
+    try {
+      b.init(2);
+      assert(false);
+    }
+    catch (std::logic_error&) {
+    }
+
+    // The previous object is kept until its buffer is needed.
+    b.emplace(2);
+    assert(book::live == 2);
+    b.emplace(3);
+    assert(book::live == 2);
+    const delayed_init<book> copy = b.load();
+    assert(copy && copy->levels[0] == 3 && book::live == 3);
+
+    b.destroy();
+    assert(!b && !b.load() && book::live == 1);
+    b.init(4);
+  }
+  assert(book::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// test_double_buffered_threads()
+//------------------------------------------------------------------------------
+
+void test_double_buffered_threads(int line) {
+  where(line, __func__);
+  {
+    double_buffered_delayed_init<book> b;
+    std::atomic<bool> done(false);
+    std::atomic<long> n_torn(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < n_readers; ++i)
+      readers.emplace_back([&] {
+        int last = 0;
+        while (!done)
+          b.read([&](const book& x) {
+            if (!x.is_consistent() || x.levels[0] < last)
+              ++n_torn;
+            last = x.levels[0];
+          });
+      });
+    for (int version = 1; version <= 20000; ++version)
+      b.emplace(version);
+    done = true;
+    for (auto& reader : readers)
+      reader.join();
+    assert(n_torn == 0);
+    assert(b.load()->levels[0] == 20000);
+    assert(book::live == 2);
+  }
+  assert(book::live == 0);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_seqlock(__LINE__);
+  test_seqlock_threads(__LINE__);
+  test_double_buffered(__LINE__);
+  test_double_buffered_threads(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
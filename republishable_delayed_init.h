@@ -0,0 +1,448 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file republishable_delayed_init.h
+  * @brief Definitions of classes seqlock_delayed_init and
+  * double_buffered_delayed_init.
+  */
+
+#ifndef OVERLOAD_REPUBLISHABLE_DELAYED_INIT_H_
+#define OVERLOAD_REPUBLISHABLE_DELAYED_INIT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "concurrent_delayed_init.h"
+#include "delayed_init.h"
+
+namespace overload {
+
+/**
+ * @brief Single-writer, many-reader delayed_init<T> protected by a seqlock.
+ *
+ * One thread (the writer) initialises, re-initialises (emplace()) and
+ * destroys the object as often as needed while any number of threads
+ * (readers) take consistent copies of it (load()). Readers never block the
+ * writer and the writer never waits: a read overlapping a write is detected
+ * by a sequence counter and retried.
+ *
+ * The object is stored as an array of words accessed by relaxed atomic
+ * operations (which, unlike plain memcpy, is free of data races) and, hence,
+ * T must be trivially copyable. Copies are built out of the critical section
+ * which only contains stores (or loads) of words.
+ *
+ * At any time, at most one thread calls the writer's members (init(),
+ * emplace() and destroy()). Objects of this class are neither copyable nor
+ * movable.
+ */
+template <typename T, typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class seqlock_delayed_init {
+
+  static_assert(std::is_trivially_copyable<T>::value, "instantiation of "
+    "seqlock_delayed_init for non-trivially copyable type");
+
+  typedef std::uintptr_t word;
+
+  static constexpr std::size_t n_words =
+    (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && version() == 0.
+   * @throw - Nothing.
+   */
+  seqlock_delayed_init() noexcept : seq_(0), is_init_(false) {
+    for (auto& w : words_)
+      w.store(0, std::memory_order_relaxed);
+  }
+
+  seqlock_delayed_init(const seqlock_delayed_init&) = delete;
+
+  seqlock_delayed_init& operator=(const seqlock_delayed_init&) = delete;
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the object is not initialised (as of the latest
+   * completed write). Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return load_state(nullptr);
+  }
+
+  /**
+   * @brief Number of completed writes.
+   *
+   * Readers might compare versions to detect changes.
+   *
+   * @throw - Nothing.
+   */
+  std::uint64_t version() const noexcept {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+  /**
+   * @brief Consistent copy of the object.
+   *
+   * Retries while the writer is writing.
+   *
+   * @return A copy of the object as of the latest completed write
+   * (uninitialised if the object was).
+   * @throw - Nothing.
+   */
+  delayed_init<T> load() const noexcept {
+    word words[n_words];
+    delayed_init<T> d;
+    if (load_state(words))
+      d.init_from_bytes(words, sizeof(T));
+    return d;
+  }
+
+  /**
+   * @brief Initialiser (writer).
+   *
+   * Builds the object by forwarding arguments to T's constructor and then
+   * publishes it.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true.
+   * @param args Initialisation arguments.
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   * @throw - Whatever T::T(Args&&...) throws (before publication).
+   */
+  template <typename... Args>
+  void init(Args&&... args) {
+    if (is_init_.load(std::memory_order_relaxed))
+      Check::fail("second attempt to initialise object");
+    emplace(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Re-initialiser (writer).
+   *
+   * Builds a new object by forwarding arguments to T's constructor and then
+   * publishes it in place of the current one (if any).
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @param args Initialisation arguments.
+   * @throw - Whatever T::T(Args&&...) throws (before publication).
+   */
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    const T obj(std::forward<Args>(args)...);
+    word words[n_words] = {};
+    std::memcpy(words, static_cast<const void*>(&obj), sizeof(T));
+    write(words, true);
+  }
+
+  /**
+   * @brief Destroys the object (writer).
+   *
+   * @post static_cast<bool>(*this) == false.
+   * @throw - Nothing.
+   */
+  void destroy() noexcept {
+    if (is_init_.load(std::memory_order_relaxed))
+      write(nullptr, false);
+  }
+
+private:
+
+  std::atomic<std::uint64_t> seq_;
+  std::atomic<bool>          is_init_;
+  std::atomic<word>          words_[n_words];
+
+  void write(const word* words, bool is_init) noexcept {
+    const std::uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    is_init_.store(is_init, std::memory_order_relaxed);
+    if (words)
+      for (std::size_t i = 0; i < n_words; ++i)
+        words_[i].store(words[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Reads the state and (if words != nullptr) the object's words.
+   */
+  bool load_state(word* words) const noexcept {
+    for (;;) {
+      const std::uint64_t seq = seq_.load(std::memory_order_acquire);
+      if (seq & 1) {
+        OVERLOAD_DELAYED_INIT_PAUSE();
+        continue;
+      }
+      const bool is_init = is_init_.load(std::memory_order_relaxed);
+      if (words && is_init)
+        for (std::size_t i = 0; i < n_words; ++i)
+          words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq)
+        return is_init;
+    }
+  }
+
+}; // class seqlock_delayed_init
+
+/**
+ * @brief Single-writer, many-reader delayed_init<T> with two buffers.
+ *
+ * One thread (the writer) initialises, re-initialises (emplace()) and
+ * destroys the object as often as needed while any number of threads
+ * (readers) access it (read()) without locks. New objects are built in the
+ * buffer not being published and swapped in atomically. Readers hold a
+ * buffer for the duration of read() only and announce it on a per-buffer
+ * counter: the old object is kept until its readers leave and it is
+ * destroyed (reclaimed) only when the writer needs its buffer back. Hence,
+ * readers never wait for the writer while the writer waits only for readers
+ * of the object two versions behind (the grace period).
+ *
+ * Contrarily to seqlock_delayed_init, T might be any type and readers don't
+ * copy it. Reads must be short since they delay the writer.
+ *
+ * At any time, at most one thread calls the writer's members (init(),
+ * emplace() and destroy()). Objects of this class are neither copyable nor
+ * movable.
+ *
+ * The type T must not be a reference type.
+ */
+template <typename T, typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class double_buffered_delayed_init {
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "double_buffered_delayed_init for reference type");
+
+  // Index of the published buffer when there's none.
+  static constexpr unsigned none = 2;
+
+public:
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false.
+   * @throw - Nothing.
+   */
+  double_buffered_delayed_init() noexcept : current_(none) {
+  }
+
+  double_buffered_delayed_init(const double_buffered_delayed_init&) = delete;
+
+  double_buffered_delayed_init& operator=(
+    const double_buffered_delayed_init&) = delete;
+
+  /**
+   * @brief Destructor.
+   *
+   * T:~T() must not throw.
+   *
+   * @pre No read() is in progress.
+   * @throw - Nothing.
+   */
+  ~double_buffered_delayed_init() noexcept {
+    for (auto& b : buffers_)
+      if (b.is_init)
+        (&b.raw.obj_)->~T();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if no object is published. Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return current_.load(std::memory_order_acquire) != none;
+  }
+
+  /**
+   * @brief Calls f(obj) on the published object obj (if any).
+   *
+   * obj remains alive during the call even if the writer publishes a new
+   * object in the meantime.
+   *
+   * @param f Function.
+   * @return true if f has been called. Otherwise (no object is published),
+   * false.
+   * @throw - Whatever f throws.
+   */
+  template <typename F>
+  bool read(F&& f) const {
+    unsigned i = current_.load();
+    for (;;) {
+      if (i == none)
+        return false;
+      buffers_[i].n_readers.fetch_add(1);
+      const unsigned j = current_.load();
+      if (j == i)
+        break;
+      buffers_[i].n_readers.fetch_sub(1, std::memory_order_release);
+      i = j;
+    }
+    reader_guard guard(buffers_[i].n_readers);
+    std::forward<F>(f)(static_cast<const T&>(buffers_[i].raw.obj_));
+    return true;
+  }
+
+  /**
+   * @brief Copy of the published object.
+   *
+   * @return A copy of the published object (uninitialised if there's none).
+   * @throw - Whatever T::T(const T&) throws.
+   */
+  delayed_init<T> load() const {
+    delayed_init<T> d;
+    read([&d](const T& obj) { d.init(obj); });
+    return d;
+  }
+
+  /**
+   * @brief Initialiser (writer).
+   *
+   * Builds the object by forwarding arguments to T's constructor and then
+   * publishes it.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true.
+   * @param args Initialisation arguments.
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   * @throw - Whatever T::T(Args&&...) throws (before publication).
+   */
+  template <typename... Args>
+  void init(Args&&... args) {
+    if (current_.load(std::memory_order_relaxed) != none)
+      Check::fail("second attempt to initialise object");
+    emplace(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Re-initialiser (writer).
+   *
+   * Waits for readers of the unpublished buffer to leave, destroys its
+   * object, builds a new one by forwarding arguments to T's constructor and
+   * publishes it.
+   *
+   * @post static_cast<bool>(*this) == true.
+   * @param args Initialisation arguments.
+   * @throw - Whatever T::T(Args&&...) throws (before publication).
+   */
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    const unsigned current = current_.load(std::memory_order_relaxed);
+    const unsigned i = current == 0 ? 1 : 0;
+    buffer& b = buffers_[i];
+    reclaim(b);
+    new ((void *) &b.raw.obj_) T(std::forward<Args>(args)...);
+    b.is_init = true;
+    current_.store(i);
+  }
+
+  /**
+   * @brief Destroys the object (writer).
+   *
+   * Unpublishes the object and waits for all readers to leave.
+   *
+   * @post static_cast<bool>(*this) == false.
+   * @throw - Nothing.
+   */
+  void destroy() noexcept {
+    current_.store(none);
+    for (auto& b : buffers_)
+      reclaim(b);
+  }
+
+private:
+
+  /**
+   * @brief Buffer with its readers counter (on its own cache line).
+   *
+   * is_init is only accessed by the writer.
+   */
+  struct alignas(OVERLOAD_DELAYED_INIT_CACHE_LINE) buffer {
+    buffer() noexcept : n_readers(0), is_init(false) {
+    }
+    mutable std::atomic<unsigned> n_readers;
+    bool                          is_init;
+    detail::raw_storage<T>        raw;
+  };
+
+  /**
+   * @brief Leaves the buffer on exit of read().
+   */
+  class reader_guard {
+    std::atomic<unsigned>& n_readers_;
+  public:
+    explicit reader_guard(std::atomic<unsigned>& n) noexcept : n_readers_(n) {
+    }
+    ~reader_guard() noexcept {
+      n_readers_.fetch_sub(1, std::memory_order_release);
+    }
+  };
+
+  alignas(OVERLOAD_DELAYED_INIT_CACHE_LINE) std::atomic<unsigned> current_;
+  buffer buffers_[2];
+
+  /**
+   * @brief Waits for readers of b to leave and destroys its object.
+   *
+   * @pre b is not published.
+   */
+  static void reclaim(buffer& b) noexcept {
+    while (b.n_readers.load() != 0)
+      OVERLOAD_DELAYED_INIT_PAUSE();
+    if (b.is_init) {
+      (&b.raw.obj_)->~T();
+      b.is_init = false;
+    }
+  }
+
+}; // class double_buffered_delayed_init
+
+template <typename T, typename C>
+constexpr std::size_t seqlock_delayed_init<T, C>::n_words;
+
+template <typename T, typename C>
+constexpr unsigned double_buffered_delayed_init<T, C>::none;
+
+} // namespace overload
+
+#endif // OVERLOAD_REPUBLISHABLE_DELAYED_INIT_H_
@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Contention benchmark of overload::seqlock_delayed_init and
+  * overload::double_buffered_delayed_init.
+  *
+  * One writer republishes a small trivially copyable snapshot as fast as it
+  * can while N readers take copies of it. Each variant is compared against a
+  * delayed_init<T> protected by a std::mutex. Throughputs are reported in
+  * operations per second (reads summed over readers). Results are written to
+  * the standard output in JSON to allow tracking regressions per compiler
+  * (e.g. make bench writes republishable_delayed_init_bench.json).
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "republishable_delayed_init.h"
+
+using overload::delayed_init;
+using overload::double_buffered_delayed_init;
+using overload::seqlock_delayed_init;
+
+constexpr auto duration = std::chrono::milliseconds(300);
+
+// Market data snapshot.
+struct quote {
+  quote(long s) noexcept : seq(s), bid(s * 0.5), ask(s * 0.5 + 1.0),
+    size(3 * s) {
+  }
+  long   seq;
+  double bid;
+  double ask;
+  long   size;
+};
+
+// Prevents the compiler from optimising away a result.
+std::atomic<long> sink(0);
+
+//------------------------------------------------------------------------------
+// Variants.
+//------------------------------------------------------------------------------
+
+struct mutex_variant {
+
+  static const char* name() {
+    return "mutex";
+  }
+
+  void write(long s) {
+    std::lock_guard<std::mutex> lock(mutex);
+    d.emplace(s);
+  }
+
+  long read() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return d ? d->seq : 0;
+  }
+
+  std::mutex          mutex;
+  delayed_init<quote> d;
+};
+
+struct seqlock_variant {
+
+  static const char* name() {
+    return "seqlock";
+  }
+
+  void write(long s) {
+    d.emplace(s);
+  }
+
+  long read() {
+    const delayed_init<quote> copy = d.load();
+    return copy ? copy->seq : 0;
+  }
+
+  seqlock_delayed_init<quote> d;
+};
+
+struct double_buffered_variant {
+
+  static const char* name() {
+    return "double_buffered";
+  }
+
+  void write(long s) {
+    d.emplace(s);
+  }
+
+  long read() {
+    long seq = 0;
+    d.read([&seq](const quote& q) { seq = q.seq; });
+    return seq;
+  }
+
+  double_buffered_delayed_init<quote> d;
+};
+
+//------------------------------------------------------------------------------
+// JSON output.
+//------------------------------------------------------------------------------
+
+bool first_result = true;
+
+void report(const char* variant_name, unsigned n_readers,
+  double reads_per_second, double writes_per_second) {
+  std::printf("%s\n    {\"variant\": \"%s\", \"readers\": %u, "
+    "\"reads_per_second\": %.0f, \"writes_per_second\": %.0f}",
+    first_result ? "" : ",", variant_name, n_readers, reads_per_second,
+    writes_per_second);
+  first_result = false;
+}
+
+//------------------------------------------------------------------------------
+// run()
+//------------------------------------------------------------------------------
+
+template <typename V>
+void run(unsigned n_readers) {
+  V v;
+  std::atomic<bool> go(false), done(false);
+  std::atomic<long> n_reads(0);
+  std::vector<std::thread> readers;
+  for (unsigned i = 0; i < n_readers; ++i)
+    readers.emplace_back([&] {
+      while (!go)
+        std::this_thread::yield();
+      long n = 0, last = 0;
+      for (; !done; ++n)
+        last += v.read();
+      n_reads += n;
+      sink += last;
+    });
+
+  long n_writes = 0;
+  go = true;
+  const auto start = std::chrono::steady_clock::now();
+  auto now = start;
+  for (; now - start < duration; now = std::chrono::steady_clock::now())
+    for (int i = 0; i < 64; ++i)
+      v.write(++n_writes);
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  const double seconds = std::chrono::duration<double>(now - start).count();
+  report(V::name(), n_readers, n_reads / seconds, n_writes / seconds);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  std::printf("{\n  \"compiler\": \"%s\",\n  \"cplusplus\": %ld,\n"
+    "  \"results\": [", __VERSION__, long(__cplusplus));
+
+  const unsigned n_cores = std::thread::hardware_concurrency();
+  for (unsigned n_readers = 1; n_readers <= 8; n_readers *= 2) {
+    if (n_readers > 1 && n_readers >= n_cores)
+      break;
+    run<mutex_variant>(n_readers);
+    run<seqlock_variant>(n_readers);
+    run<double_buffered_variant>(n_readers);
+  }
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * Unit tests of overload::static_delayed_init.
+  *
+  * Tests use the C/C++ standard macro assert and hence diagnostics are fairly
+  * poor. More advanced diagnostics can be obtained by using a good unit testing
+  * framework as CATCH:
+  * http://www.catch-lib.net/
+  */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "static_delayed_init.h"
+
+// Ids of destroyed recorders (in order of destruction).
+std::vector<int> destroyed;
+
+// Records its destruction.
+class recorder {
+
+  int id_;
+
+public:
+
+  explicit recorder(int id) noexcept : id_(id) {
+  }
+
+  ~recorder() noexcept {
+    destroyed.push_back(id_);
+  }
+
+  int id() const noexcept {
+    return id_;
+  }
+};
+
+// Tag of the registry used by these tests.
+struct tests;
+
+using overload::static_delayed_init;
+typedef overload::static_registry<tests> registry;
+
+static_assert(std::is_trivially_destructible<
+  static_delayed_init<std::string>>::value,
+  "static_delayed_init<std::string> is not trivially destructible");
+static_assert(std::is_trivially_destructible<
+  static_delayed_init<recorder, registry>>::value,
+  "static_delayed_init<recorder, registry> is not trivially destructible");
+static_assert(sizeof(static_delayed_init<void*>) == 2 * sizeof(void*),
+  "static_delayed_init<void*> is larger than expected");
+
+// Globals (constant-initialised).
+#if defined(__cpp_constinit)
+constinit
+#endif
+static_delayed_init<std::string> global_string;
+static_delayed_init<recorder, registry> global_1;
+static_delayed_init<recorder, registry> global_2;
+static_delayed_init<recorder, registry> global_3;
+
+//------------------------------------------------------------------------------
+// where()
+//------------------------------------------------------------------------------
+
+void where(int line, const char* func) {
+  std::cout << "line " << line << " : " << func << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// test_init_destroy()
+//------------------------------------------------------------------------------
+
+void test_init_destroy(int line) {
+  where(line, __func__);
+  assert(!global_string);
+  assert(global_string.get() == nullptr);
+  try {
+    *global_string;
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  global_string.init(3, 'a');
+  assert(global_string);
+  assert(*global_string == "aaa");
+  assert(global_string->size() == 3);
+  try {
+    global_string.init();
+    assert(false);
+  }
+  catch (std::logic_error&) {
+  }
+  global_string.destroy();
+  assert(!global_string);
+  global_string.destroy();
+  global_string.init_with([]() { return std::string("bbb"); });
+  assert(global_string.value_unchecked() == "bbb");
+  global_string.destroy();
+}
+
+//------------------------------------------------------------------------------
+// test_no_implicit_destruction()
+//------------------------------------------------------------------------------
+
+void test_no_implicit_destruction(int line) {
+  where(line, __func__);
+  destroyed.clear();
+  {
+    static_delayed_init<recorder> s;
+    s.init(0);
+  }
+  assert(destroyed.empty());
+}
+
+//------------------------------------------------------------------------------
+// test_registry()
+//------------------------------------------------------------------------------
+
+void test_registry(int line) {
+  where(line, __func__);
+  destroyed.clear();
+  assert(registry::empty());
+  global_2.init(2);
+  global_1.init(1);
+  global_3.init(3);
+  assert(!registry::empty());
+
+  // Explicit destruction unregisters.
+  global_1.destroy();
+  assert(destroyed == std::vector<int>{1});
+
+  global_1.init(1);
+  registry::destroy_all();
+  assert((destroyed == std::vector<int>{1, 1, 3, 2}));
+  assert(registry::empty());
+  assert(!global_1 && !global_2 && !global_3);
+
+  registry::destroy_all();
+  assert(destroyed.size() == 4);
+}
+
+//------------------------------------------------------------------------------
+// main()
+//------------------------------------------------------------------------------
+
+int main() {
+
+  test_init_destroy(__LINE__);
+  test_no_implicit_destruction(__LINE__);
+  test_registry(__LINE__);
+
+  std::cout << "all tests passed." << std::endl;
+  return 0;
+}
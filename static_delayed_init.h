@@ -0,0 +1,452 @@
+/*******************************************************************************
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of this
+ * software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at large
+ * and to the detriment of our heirs and successors. We intend this dedication
+ * to be an overt act of relinquishment in perpetuity of all present and future
+ * rights to this software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ *
+ * If you use this software in a product, an acknowledgment in the product
+ * documentation would be appreciated but is not required.
+ *
+ * by Cassio Neri
+ ******************************************************************************/
+
+ /**
+  * @file static_delayed_init.h
+  * @brief Definition of class static_delayed_init.
+  */
+
+#ifndef OVERLOAD_STATIC_DELAYED_INIT_H_
+#define OVERLOAD_STATIC_DELAYED_INIT_H_
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "delayed_init.h"
+
+namespace overload {
+
+/**
+ * @brief Registry policy of static_delayed_init: objects are not registered.
+ */
+struct no_registry {
+};
+
+namespace detail {
+
+/**
+ * @brief Node of the intrusive (doubly linked) list of a static_registry.
+ *
+ * It stores only pointers and hence, it's constant-initialised and trivially
+ * destructible.
+ */
+struct static_node {
+
+  constexpr explicit static_node(void (*destroy)(static_node*)) noexcept :
+    next_(nullptr), prev_(nullptr), destroy_(destroy) {
+  }
+
+  static_node*  next_;
+  static_node** prev_;
+  void (*destroy_)(static_node*);
+};
+
+} // namespace detail
+
+/**
+ * @brief Registry of static_delayed_init objects.
+ *
+ * A static_delayed_init<T, static_registry<Tag>> object is registered when
+ * initialised and unregistered when destroyed. Then destroy_all() destroys all
+ * the registered objects in the reverse order of their initialisations. Tag
+ * allows for independent registries (e.g. one per subsystem).
+ *
+ * The registry holds a single pointer that is constant-initialised and uses no
+ * dynamic memory. It is not thread-safe: registered objects must not be
+ * initialised or destroyed concurrently.
+ *
+ * @tparam Tag Registry identifier.
+ */
+template <typename Tag = void>
+class static_registry {
+
+public:
+
+  /**
+   * @brief Destroy all registered objects in reverse order of initialisation.
+   *
+   * @post empty() == true.
+   * @throw - Nothing.
+   */
+  static void destroy_all() noexcept {
+    while (head_)
+      head_->destroy_(head_);
+  }
+
+  /**
+   * @brief Checks whether there's no registered object.
+   *
+   * @return true if there's no registered object. Otherwise, false.
+   * @throw - Nothing.
+   */
+  static bool empty() noexcept {
+    return head_ == nullptr;
+  }
+
+  /**
+   * @brief Registers a node (at the front).
+   *
+   * @param node Node.
+   * @throw - Nothing.
+   */
+  static void link(detail::static_node* node) noexcept {
+    node->next_ = head_;
+    node->prev_ = &head_;
+    if (head_)
+      head_->prev_ = &node->next_;
+    head_ = node;
+  }
+
+  /**
+   * @brief Unregisters a node.
+   *
+   * @param node Node.
+   * @throw - Nothing.
+   */
+  static void unlink(detail::static_node* node) noexcept {
+    *node->prev_ = node->next_;
+    if (node->next_)
+      node->next_->prev_ = node->prev_;
+    node->next_ = nullptr;
+    node->prev_ = nullptr;
+  }
+
+private:
+
+  static detail::static_node* head_;
+
+}; // class static_registry
+
+template <typename Tag>
+detail::static_node* static_registry<Tag>::head_ = nullptr;
+
+namespace detail {
+
+/**
+ * @brief Hook of static_delayed_init into its registry.
+ *
+ * The primary template, for no_registry, is empty and does nothing.
+ *
+ * @tparam Registry Registry policy.
+ * @tparam D The derived static_delayed_init (which must befriend this class).
+ */
+template <typename Registry, typename D>
+class registry_hook {
+
+protected:
+
+  void link() noexcept {
+  }
+
+  void unlink() noexcept {
+  }
+};
+
+template <typename Tag, typename D>
+class registry_hook<static_registry<Tag>, D> : private static_node {
+
+protected:
+
+  constexpr registry_hook() noexcept : static_node(&destroy_node) {
+  }
+
+  void link() noexcept {
+    static_registry<Tag>::link(this);
+  }
+
+  void unlink() noexcept {
+    static_registry<Tag>::unlink(this);
+  }
+
+private:
+
+  static void destroy_node(static_node* node) noexcept {
+    static_cast<D*>(static_cast<registry_hook*>(node))->destroy();
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief delayed_init<T> for objects with static storage duration.
+ *
+ * Class static_delayed_init<T> holds an object of type T whose initialisation
+ * is delayed until init() or init_with() is called. Contrarily to
+ * delayed_init<T>, static_delayed_init<T> is trivially destructible for every
+ * T and never destroys the object implicitly. Hence, a namespace-scope
+ * static_delayed_init needs neither a dynamic initialiser (its constructor is
+ * constexpr) nor an atexit registration. The object is destroyed by an explicit
+ * call to destroy() or, if Registry is a static_registry, by
+ * Registry::destroy_all(). Objects that are never destroyed are leaked, i.e.,
+ * the process exits without running ~T().
+ *
+ * Objects of this class are neither copyable nor movable. Initialisation and
+ * destruction are not thread-safe (see concurrent_delayed_init).
+ *
+ * The type T must not be a reference type.
+ *
+ * @tparam T Type of the object.
+ * @tparam Registry Registry policy: no_registry or a static_registry.
+ * @tparam Check Checking policy (see namespace check).
+ */
+template <typename T, typename Registry = no_registry,
+  typename Check = OVERLOAD_DELAYED_INIT_CHECK>
+class static_delayed_init :
+  private detail::registry_hook<Registry, static_delayed_init<T, Registry,
+  Check>> {
+
+  typedef detail::registry_hook<Registry, static_delayed_init> hook;
+  friend hook;
+
+public:
+
+  static_assert(!std::is_reference<T>::value, "instantiation of "
+    "static_delayed_init for reference type");
+
+  /**
+   * @brief Default constructor.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  constexpr static_delayed_init() noexcept : hook(), buffer_(),
+    is_init_(false) {
+  }
+
+  static_delayed_init(const static_delayed_init&) = delete;
+
+  static_delayed_init& operator=(const static_delayed_init&) = delete;
+
+  /**
+   * @brief Indirection.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  T& operator*() noexcept(Check::is_nothrow) {
+    if (!is_init_)
+      Check::fail("attempt to use uninitialised object");
+    return *obj();
+  }
+
+  /**
+   * @brief Indirection (const).
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw std::logic_error If pre-condition doesn't hold and Check is
+   * check::exception.
+   */
+  const T& operator*() const noexcept(Check::is_nothrow) {
+    if (!is_init_)
+      Check::fail("attempt to use uninitialised object");
+    return *obj();
+  }
+
+  /**
+   * @brief Unchecked indirection.
+   *
+   * The pre-condition is not checked but the optimiser assumes it holds.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw - Nothing.
+   */
+  T& value_unchecked() noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(is_init_);
+    return *obj();
+  }
+
+  /**
+   * @brief Unchecked indirection (const).
+   *
+   * The pre-condition is not checked but the optimiser assumes it holds.
+   *
+   * @pre static_cast<bool>(*this) == true.
+   * @return *get().
+   * @throw - Nothing.
+   */
+  const T& value_unchecked() const noexcept {
+    OVERLOAD_DELAYED_INIT_ASSUME(is_init_);
+    return *obj();
+  }
+
+  /**
+   * @brief Getter.
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  T* get() noexcept {
+    return is_init_ ? obj() : nullptr;
+  }
+
+  /**
+   * @brief Getter (const).
+   *
+   * @return A pointer to the inner object if static_cast<bool>(*this) == true.
+   * Otherwise, nullptr.
+   * @throw - Nothing.
+   */
+  const T* get() const noexcept {
+    return is_init_ ? obj() : nullptr;
+  }
+
+  /**
+   * @brief Deference.
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  T* operator->() noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Deference (const).
+   *
+   * @return get().
+   * @throw - Nothing.
+   */
+  const T* operator->() const noexcept {
+    return get();
+  }
+
+  /**
+   * @brief Conversion to bool.
+   *
+   * @return false if the inner object was not initialised. Otherwise, true.
+   * @throw - Nothing.
+   */
+  explicit operator bool() const noexcept {
+    return is_init_;
+  }
+
+  /**
+   * @brief Initialiser.
+   *
+   * Builds inner object by forwarding arguments to T's constructor and, if
+   * Registry is a static_registry, registers *this.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param args Initialisation arguments.
+   * @return *get().
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever T::T(Args&&...) throws.
+   */
+  template <typename... Args>
+  T& init(Args&&... args) {
+    if (is_init_)
+      Check::fail("second attempt to initialise object");
+    new ((void *) buffer_) T(std::forward<Args>(args)...);
+    return registered();
+  }
+
+  /**
+   * @brief Initialiser from factory.
+   *
+   * Builds inner object from the result of f() and, if Registry is a
+   * static_registry, registers *this. From C++17, if f() returns a prvalue of
+   * type T, then no copy or move is involved.
+   *
+   * @pre static_cast<bool>(*this) == false.
+   * @post static_cast<bool>(*this) == true && get() != nullptr.
+   * @param f Factory.
+   * @return *get().
+   * @throw - std::logic_error (if pre condition doesn't hold and Check is
+   * check::exception) and whatever f() and T's constructor throw.
+   */
+  template <typename F>
+  T& init_with(F&& f) {
+    if (is_init_)
+      Check::fail("second attempt to initialise object");
+    new ((void *) buffer_) T(std::forward<F>(f)());
+    return registered();
+  }
+
+  /**
+   * @brief Destroy inner object (if initialised).
+   *
+   * If Registry is a static_registry, then *this is unregistered. T::~T() must
+   * not throw.
+   *
+   * @post static_cast<bool>(*this) == false && get() == nullptr.
+   * @throw - Nothing.
+   */
+  void destroy() noexcept {
+    if (!is_init_)
+      return;
+    this->unlink();
+    is_init_ = false;
+    obj()->~T();
+  }
+
+private:
+
+  /**
+   * @brief Marks the object as initialised and registers *this.
+   *
+   * @return *get().
+   */
+  T& registered() noexcept {
+    is_init_ = true;
+    this->link();
+    return *obj();
+  }
+
+  T* obj() noexcept {
+    return launder(reinterpret_cast<T*>(buffer_));
+  }
+
+  const T* obj() const noexcept {
+    return launder(reinterpret_cast<const T*>(buffer_));
+  }
+
+  template <typename U>
+  static U* launder(U* ptr) noexcept {
+#if defined(__cpp_lib_launder)
+    return std::launder(ptr);
+#else
+    return ptr;
+#endif
+  }
+
+  alignas(T) unsigned char buffer_[sizeof(T)];
+  bool is_init_;
+
+}; // class static_delayed_init
+
+} // namespace overload
+
+#endif // OVERLOAD_STATIC_DELAYED_INIT_H_